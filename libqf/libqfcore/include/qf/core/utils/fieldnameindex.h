@@ -0,0 +1 @@
+#include "../../../../src/utils/fieldnameindex.h"
@@ -0,0 +1 @@
+#include "../../../../src/utils/trigramindex.h"
@@ -3,6 +3,8 @@
 
 #include <QString>
 
+#include <cstring>
+
 using namespace qf::core;
 /*
 Collator::Collator()
@@ -61,6 +63,34 @@ int Collator::compare(const QStringRef &s1, const QStringRef &s2) const
 	return ret;
 }
 
+QByteArray Collator::sortKey(const QString &s) const
+{
+	/// sortIndex() is always less than 2^16, it is stored big endian to keep bytewise order
+	QByteArray ret(s.length() * 2, Qt::Uninitialized);
+	char *p = ret.data();
+	for(int i=0; i<s.length(); i++) {
+		int n = sortIndex(s.at(i));
+		*p++ = static_cast<char>((n >> 8) & 0xff);
+		*p++ = static_cast<char>(n & 0xff);
+	}
+	return ret;
+}
+
+int Collator::compareSortKeys(const QByteArray &k1, const QByteArray &k2)
+{
+	const int len = qMin(k1.size(), k2.size());
+	int ret = ::memcmp(k1.constData(), k2.constData(), static_cast<size_t>(len));
+	if(ret < 0)
+		return -1;
+	if(ret > 0)
+		return 1;
+	if(k1.size() < k2.size())
+		return -1;
+	if(k1.size() > k2.size())
+		return 1;
+	return 0;
+}
+
 int Collator::sortIndex(QChar c) const
 {
 	QChar co = c;
@@ -115,7 +145,7 @@ QChar Collator::removePunctuation(QLocale::Language lang, QChar c)
 	return punct_to_bt7.value(c, c);
 }
 
-QHash<QChar, int> Collator::sortCache()
+const QHash<QChar, int>& Collator::sortCache()
 {
 	static QHash<QChar, int> ret;
 	if(ret.isEmpty()) {
@@ -44,12 +44,16 @@ public:
 
 	int compare(const QString &s1, const QString &s2) const;
 	int compare(const QStringRef &s1, const QStringRef &s2) const;
+	/// Binary key of string, two keys compared bytewise (memcmp, shorter first) give the same order as compare() does.
+	/// Use it when the same strings are compared many times, like in sorting.
+	QByteArray sortKey(const QString &s) const;
+	static int compareSortKeys(const QByteArray &k1, const QByteArray &k2);
 
 	static QByteArray toAscii7(QLocale::Language lang, const QString &s, bool to_lower);
 	static QChar removePunctuation(QLocale::Language language, QChar c);
 private:
 	int sortIndex(QChar c) const;
-	static QHash<QChar, int> sortCache();
+	static const QHash<QChar, int>& sortCache();
 };
 
 }}
@@ -15,6 +15,7 @@
 #include <QJSValue>
 #include <QColor>
 #include <QSet>
+#include <QTimer>
 
 namespace qfs = qf::core::sql;
 namespace qfu = qf::core::utils;
@@ -121,14 +122,108 @@ bool SqlTableModel::reload()
 bool SqlTableModel::reloadQuery(const QString &query_str)
 {
 	qfLogFuncFrame() << query_str;
+	stopFetching();
 	beginResetModel();
 	bool ok = reloadTable(query_str);
 	checkColumns();
 	endResetModel();
 	emit reloaded();
+	if(m_isFetching)
+		scheduleFetchMore();
 	return ok;
 }
 
+void SqlTableModel::clearRows()
+{
+	stopFetching();
+	Super::clearRows();
+}
+
+bool SqlTableModel::canFetchMore(const QModelIndex &parent) const
+{
+	if(parent.isValid())
+		return false;
+	return m_isFetching;
+}
+
+void SqlTableModel::fetchMore(const QModelIndex &parent)
+{
+	if(parent.isValid() || !m_isFetching)
+		return;
+	qfLogFuncFrame() << "chunk size:" << fetchChunkSize();
+	/// forward only query cannot tell number of rows left, so rows are read before they are announced by beginInsertRows()
+	QList<qfu::TableRow> rows;
+	fetchTableRows(qMax(1, fetchChunkSize()), &rows);
+	if(!rows.isEmpty()) {
+		int row_cnt = m_table.rowCount();
+		beginInsertRows(QModelIndex(), row_cnt, row_cnt + rows.count() - 1);
+		for(const qfu::TableRow &row : rows)
+			m_table.appendRow(row).setInsert(false);
+		endInsertRows();
+	}
+	if(m_isFetching)
+		scheduleFetchMore();
+}
+
+void SqlTableModel::fetchAll()
+{
+	qfLogFuncFrame();
+	while(m_isFetching)
+		fetchMore(QModelIndex());
+}
+
+void SqlTableModel::stopFetching()
+{
+	if(m_isFetching) {
+		m_isFetching = false;
+		m_fetchSerial++;
+		m_recentlyExecutedQuery.finish();
+	}
+}
+
+void SqlTableModel::scheduleFetchMore()
+{
+	int serial = m_fetchSerial;
+	QTimer::singleShot(0, this, [this, serial]() {
+		if(serial == m_fetchSerial)
+			fetchMore(QModelIndex());
+	});
+}
+
+int SqlTableModel::fetchTableRows(int max_row_count, QList<qfu::TableRow> *fetched_rows)
+{
+	const int fld_cnt = m_table.fields().count();
+	int fetched_cnt = 0;
+	while(max_row_count < 0 || fetched_cnt < max_row_count) {
+		if(!m_recentlyExecutedQuery.next()) {
+			if(m_isFetching) {
+				stopFetching();
+				emit fetchFinished();
+			}
+			break;
+		}
+		qfu::TableRow isolated_row;
+		if(fetched_rows)
+			isolated_row = m_table.isolatedRow();
+		qfu::TableRow &row = fetched_rows? isolated_row: m_table.appendRow();
+		row.setInsert(false);
+		for(int i=0; i<fld_cnt; i++) {
+			QVariant v = m_recentlyExecutedQuery.value(i);
+			//qfInfo() << m_table.fields().value(i).name() << m_table.fields().value(i).type() << i << v << "null:" << v.isNull();
+			if(m_retypeNullValues) {
+				// SQLite driver reports NULL values as QString()
+				if(v.isNull())
+					v = QVariant(m_table.fields().at(i).type());
+			}
+			row.setBareBoneValue(i, v);
+		}
+		if(fetched_rows)
+			fetched_rows->append(isolated_row);
+		fetched_cnt++;
+	}
+	return fetched_cnt;
+}
+
 bool SqlTableModel::postRow(int row_no, bool throw_exc)
 {
 	qfLogFuncFrame() << row_no;
@@ -640,13 +735,16 @@ bool SqlTableModel::reloadTable(const QString &query_str)
 	qf::core::sql::Connection sql_conn = sqlConnection();
 	m_recentlyExecutedQuery = qfs::Query(sql_conn);
 	m_recentlyExecutedQueryString = query_str;
+	const int chunk_size = fetchChunkSize();
+	if(chunk_size > 0)
+		m_recentlyExecutedQuery.setForwardOnly(true);
 	bool ok = m_recentlyExecutedQuery.exec(query_str);
 	if(!ok) {
 		qfError() << QString("SQL Error: %1\n%2").arg(m_recentlyExecutedQuery.lastError().text()).arg(query_str);
 		return false;
 	}
 	if(m_recentlyExecutedQuery.isSelect()) {
-		bool retype_null_values = sql_conn.driverName().endsWith(QLatin1String("SQLITE"), Qt::CaseInsensitive);
+		m_retypeNullValues = sql_conn.driverName().endsWith(QLatin1String("SQLITE"), Qt::CaseInsensitive);
 		qfu::Table::FieldList table_fields;
 		QSqlRecord rec = m_recentlyExecutedQuery.record();
 		int fld_cnt = rec.count();
@@ -659,21 +757,9 @@ bool SqlTableModel::reloadTable(const QString &query_str)
 		}
 		setSqlFlags(table_fields, query_str);
 		m_table = qfu::Table(table_fields);
-		while(m_recentlyExecutedQuery.next()) {
-			qfu::TableRow &row = m_table.appendRow();
-			row.setInsert(false);
-			for(int i=0; i<fld_cnt; i++) {
-				QVariant v = m_recentlyExecutedQuery.value(i);
-				//qfInfo() << table_fields.value(i).name() << table_fields.value(i).type() << i << v << "null:" << v.isNull();
-				if(retype_null_values) {
-					// SQLite driver reports NULL values as QString()
-					if(v.isNull())
-						v = QVariant(table_fields.value(i).type());
-				}
-				//qfWarning() << table_fields.value(i).name() << table_fields.value(i).type() << i << v << "null:" << v.isNull();
-				row.setBareBoneValue(i, v);
-			}
-		}
+		/// in streaming mode only first chunk is loaded here, rest of rows is appended by fetchMore()
+		m_isFetching = (chunk_size > 0);
+		fetchTableRows(m_isFetching? chunk_size: -1);
 	}
 	return true;
 }
@@ -31,6 +31,10 @@ public:
 
 	QF_PROPERTY_IMPL(QVariant, q, Q, ueryParameters)
 	QF_PROPERTY_BOOL_IMPL(i, I, ncludeJoinedTablesIdsToReloadRowQuery)
+	/// If > 0, reload() executes forward only query and loads just first fetchChunkSize rows,
+	/// the rest is appended in chunks of the same size from event loop or when view calls fetchMore().
+	/// Model is not complete after reload() returns in this mode, call fetchAll() if all rows are needed.
+	QF_PROPERTY_IMPL2(int, f, F, etchChunkSize, 0)
 
 public:
 	class QFCORE_DECL_EXPORT DbEnumCastProperties : public QVariantMap
@@ -50,6 +54,14 @@ public:
 	void revertRow(int row_no) Q_DECL_OVERRIDE;
 	int reloadRow(int row_no) Q_DECL_OVERRIDE;
 	int reloadInserts(const QString &id_column_name) Q_DECL_OVERRIDE;
+	void clearRows() Q_DECL_OVERRIDE;
+
+	bool canFetchMore(const QModelIndex &parent) const Q_DECL_OVERRIDE;
+	void fetchMore(const QModelIndex &parent) Q_DECL_OVERRIDE;
+	/// loads all rows left in streaming query
+	Q_INVOKABLE void fetchAll();
+	bool isFetching() const {return m_isFetching;}
+	Q_SIGNAL void fetchFinished();
 public:
 	void setQueryBuilder(const qf::core::sql::QueryBuilder &qb, bool clear_columns = false);
 	const qf::core::sql::QueryBuilder& queryBuilder() const;
@@ -80,6 +92,11 @@ protected:
 	bool reloadQuery(const QString &query_str);
 
 	virtual bool reloadTable(const QString &query_str);
+	/// reads up to max_row_count rows from m_recentlyExecutedQuery, max_row_count < 0 means all of them
+	/// rows are appended to m_table when fetched_rows == nullptr
+	int fetchTableRows(int max_row_count, QList<qf::core::utils::TableRow> *fetched_rows = nullptr);
+	void stopFetching();
+	void scheduleFetchMore();
 	QStringList tableIds(const utils::Table::FieldList &table_fields);
 	void setSqlFlags(qf::core::utils::Table::FieldList &table_fields, const QString &query_str);
 
@@ -95,6 +112,10 @@ protected:
 	QString m_recentlyExecutedQueryString;
 	/// INSERT needs to know dependency of tables in joined queries to insert particular tables in proper order
 	QMap<QString, QString> m_foreignKeyDependencies;
+	bool m_isFetching = false;
+	/// incremented when fetching stops, so already scheduled chunk fetch of previous query can be recognized
+	int m_fetchSerial = 0;
+	bool m_retypeNullValues = false;
 };
 
 }}}
@@ -114,7 +114,7 @@ public:
 	typedef QVector<ColumnDefinition> ColumnList;
 
 public:
-	void clearRows();
+	virtual void clearRows();
 	void clearColumns(int new_column_count = 0);
 	ColumnDefinition& addColumn(const QString &field_name, const QString &caption = QString()) {
 		return insertColumn(m_columns.count(), field_name, caption);
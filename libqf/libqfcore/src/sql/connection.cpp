@@ -1,6 +1,7 @@
 #include "connection.h"
 
 #include "catalog.h"
+#include "query.h"
 
 #include "../core/log.h"
 #include "../core/utils.h"
@@ -79,11 +80,13 @@ Connection &Connection::operator=(const QSqlDatabase &o)
 bool Connection::open()
 {
 	s_clearCache(connectionName());
+	Query::clearPreparedCache(connectionName());
 	return Super::open();
 }
 
 void Connection::close()
 {
+	Query::clearPreparedCache(connectionName());
 	Super::close();
 }
 
@@ -910,6 +913,8 @@ bool Connection::setCurrentSchema(const QString &schema_name)
 	qfLogFuncFrame() << schema_name;
 	bool ret = true;
 	s_clearCache(connectionName());
+	/// statements prepared in previous schema refer to its tables
+	Query::clearPreparedCache(connectionName());
 	if(driverName().endsWith(QLatin1String("MYSQL"))) {
 		QSqlQuery q(*this);
 		if(!q.exec("USE " + schema_name)) {
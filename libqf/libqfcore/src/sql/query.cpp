@@ -6,23 +6,141 @@
 
 #include <QSqlRecord>
 #include <QSqlField>
+#include <QSqlDriver>
 #include <QVariant>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
 
 using namespace qf::core::sql;
 
+//=========================================
+//       prepared statements cache
+//=========================================
+namespace qf {
+namespace core {
+namespace sql {
+
+struct PreparedStatement
+{
+	QSqlQuery query;
+	QString connectionName;
+	QSqlDriver *driver = nullptr;
+	QString queryString;
+	int cacheGeneration = 0;
+	bool isReusable = true;
+};
+
+}}}
+
+namespace {
+
+class PreparedCache
+{
+public:
+	static constexpr int DEFAULT_CAPACITY = 64;
+	struct ConnectionCache
+	{
+		explicit ConnectionCache(int capacity) : statements(capacity) {}
+
+		/// prepared statements are valid only for driver they were created by
+		QPointer<QSqlDriver> driver;
+		/// statements checked out before clear() are not returned to cache
+		int generation = 0;
+		QCache<QString, QSqlQuery> statements;
+	};
+public:
+	/// returns nullptr if statement is not cached
+	QSqlQuery* take(const QString &connection_name, QSqlDriver *driver, const QString &query_string, int *generation)
+	{
+		QMutexLocker locker(&m_mutex);
+		ConnectionCache *cc = m_connectionCaches.value(connection_name);
+		if(!cc) {
+			cc = new ConnectionCache(m_capacity);
+			m_connectionCaches[connection_name] = cc;
+		}
+		if(cc->driver.data() != driver) {
+			cc->statements.clear();
+			cc->generation++;
+			cc->driver = driver;
+		}
+		*generation = cc->generation;
+		return cc->statements.take(query_string);
+	}
+	void put(const PreparedStatement &st)
+	{
+		QMutexLocker locker(&m_mutex);
+		ConnectionCache *cc = m_connectionCaches.value(st.connectionName);
+		if(!cc || !cc->driver || cc->driver.data() != st.driver || cc->generation != st.cacheGeneration)
+			return;
+		cc->statements.insert(st.queryString, new QSqlQuery(st.query));
+	}
+	void clear(const QString &connection_name)
+	{
+		QMutexLocker locker(&m_mutex);
+		ConnectionCache *cc = m_connectionCaches.value(connection_name);
+		if(cc) {
+			cc->statements.clear();
+			cc->generation++;
+		}
+	}
+	int capacity() const
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_capacity;
+	}
+	void setCapacity(int n)
+	{
+		QMutexLocker locker(&m_mutex);
+		m_capacity = qMax(1, n);
+		for(ConnectionCache *cc : m_connectionCaches)
+			cc->statements.setMaxCost(m_capacity);
+	}
+private:
+	mutable QMutex m_mutex;
+	QHash<QString, ConnectionCache*> m_connectionCaches;
+	int m_capacity = DEFAULT_CAPACITY;
+};
+
+PreparedCache& s_preparedCache()
+{
+	static PreparedCache cache;
+	return cache;
+}
+
+void return_prepared_statement(PreparedStatement *st)
+{
+	if(st->isReusable) {
+		/// release SQLite read lock held by not fully fetched SELECT, statement stays prepared
+		st->query.finish();
+		s_preparedCache().put(*st);
+	}
+	delete st;
+}
+
+}
+
+//=========================================
+//              Query
+//=========================================
 Query::Query(const QSqlDatabase &db)
 	: Super(db)
+	, m_connectionName(db.connectionName())
 {
 }
 
 Query::Query(const QString &connection_name)
 	: Super(Connection::forName(connection_name))
+	, m_connectionName(connection_name.isEmpty()? QString(QSqlDatabase::defaultConnection): connection_name)
 {
 }
 
 bool Query::prepare(const QString &query, bool throw_exc)
 {
 	qfLogFuncFrame() << query;
+	releaseCachedStatement();
 	bool ret = Super::prepare(query);
 	if(!ret) {
 		if(throw_exc)
@@ -43,6 +161,7 @@ bool Query::exec(const QString &query, bool throw_exc)
 {
 	qfLogFuncFrame() << query;
 	//qfWarning() << query;
+	releaseCachedStatement();
 	bool ret = Super::exec(query);
 	if(!ret) {
 		if(throw_exc)
@@ -50,13 +169,77 @@ bool Query::exec(const QString &query, bool throw_exc)
 		qfError() << query << '\n' << lastError().text();
 	}
 	if(isSelect())
-		m_demangledRecord = QSqlRecord();
+		clearRecordCache();
 	return ret;
 }
 
 bool Query::exec(const QueryBuilder &query_builder, bool throw_exc)
 {
-	return exec(query_builder.toString(), throw_exc);
+	const QVariantMap &bound_values = query_builder.boundValues();
+	if(bound_values.isEmpty())
+		return exec(query_builder.toString(), throw_exc);
+	if(!prepare(query_builder.toString(), throw_exc))
+		return false;
+	for(auto it = bound_values.constBegin(); it != bound_values.constEnd(); ++it)
+		bindValue(it.key(), it.value());
+	return exec(throw_exc);
+}
+
+bool Query::execCached(const QString &query, const QVariantMap &bound_values, bool throw_exc)
+{
+	qfLogFuncFrame() << query;
+	releaseCachedStatement();
+	QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+	QSharedPointer<PreparedStatement> st(new PreparedStatement(), return_prepared_statement);
+	st->connectionName = m_connectionName;
+	st->driver = db.driver();
+	st->queryString = query;
+	QSqlQuery *cached_query = s_preparedCache().take(m_connectionName, st->driver, query, &st->cacheGeneration);
+	bool ret = true;
+	if(cached_query) {
+		st->query = *cached_query;
+		delete cached_query;
+	}
+	else {
+		st->query = QSqlQuery(db);
+		ret = st->query.prepare(query);
+	}
+	if(ret) {
+		for(auto it = bound_values.constBegin(); it != bound_values.constEnd(); ++it)
+			st->query.bindValue(it.key(), it.value());
+		ret = st->query.exec();
+	}
+	Super::operator=(st->query);
+	clearRecordCache();
+	if(!ret) {
+		/// statement can be broken, for example when connection was lost
+		st->isReusable = false;
+		if(throw_exc)
+			QF_EXCEPTION(query + '\n' + lastError().text());
+		qfError() << query << '\n' << lastError().text();
+	}
+	m_cachedStatement = st;
+	return ret;
+}
+
+bool Query::execCached(const QueryBuilder &query_builder, bool throw_exc)
+{
+	return execCached(query_builder.toString(), query_builder.boundValues(), throw_exc);
+}
+
+void Query::clearPreparedCache(const QString &connection_name)
+{
+	s_preparedCache().clear(connection_name.isEmpty()? QString(QSqlDatabase::defaultConnection): connection_name);
+}
+
+int Query::preparedCacheCapacity()
+{
+	return s_preparedCache().capacity();
+}
+
+void Query::setPreparedCacheCapacity(int n)
+{
+	s_preparedCache().setCapacity(n);
 }
 
 bool Query::exec(bool throw_exc)
@@ -69,7 +252,7 @@ bool Query::exec(bool throw_exc)
 		//qfWarning() << lastError().text();
 	}
 	if(isSelect())
-		m_demangledRecord = QSqlRecord();
+		clearRecordCache();
 	return ret;
 }
 
@@ -89,37 +272,58 @@ QSqlRecord Query::record() const
 	return m_demangledRecord;
 }
 
-int Query::fieldIndex(const QString &field_name) const
+void Query::clearRecordCache()
 {
-	QSqlRecord rc = record();
-	int ix;
-	for(ix=0; ix<rc.count(); ix++) {
-		QString fld_mn = rc.fieldName(ix);
-		if(fld_mn.endsWith(field_name, Qt::CaseInsensitive)) {
-			if(fld_mn.length() == field_name.length())
-				break;
-			//qfWarning() << fld_mn << field_name << fld_mn.mid(0, fld_mn.length() - field_name.length());
-			if(fld_mn[fld_mn.length() - field_name.length() - 1] == '.')
-				break;
-		}
+	m_demangledRecord = QSqlRecord();
+	m_fieldNameIndex.clear();
+}
+
+const qf::core::utils::FieldNameIndex &Query::fieldNameIndex() const
+{
+	if(!m_fieldNameIndex.isValid()) {
+		QSqlRecord rc = record();
+		for(int i=0; i<rc.count(); i++)
+			m_fieldNameIndex.append(rc.fieldName(i));
 	}
-	if(ix >= rc.count())
-		ix = -1;
-	return ix;
+	return m_fieldNameIndex;
+}
+
+int Query::fieldIndex(const QString &field_name) const
+{
+	return fieldNameIndex().indexOf(field_name);
+}
+
+int Query::fieldIndex(const FieldHandle &field_handle) const
+{
+	return fieldNameIndex().indexOf(field_handle);
+}
+
+static void log_field_not_found(const QString &field_name, const QSqlRecord &rc)
+{
+	QStringList sl;
+	for(int ix=0; ix<rc.count(); ix++)
+		sl << rc.fieldName(ix);
+	qfError() << "Field" << field_name << "not found in the record!";
+	qfInfo() << "Available fields:" << sl.join(", ");
 }
 
 QVariant Query::value(const QString &field_name) const
 {
 	QVariant ret;
 	int ix = fieldIndex(field_name);
-	if(ix < 0) {
-		QSqlRecord rc = record();
-		QStringList sl;
-		for(ix=0; ix<rc.count(); ix++)
-			sl << rc.fieldName(ix);
-		qfError() << "Field" << field_name << "not found in the record!";
-		qfInfo() << "Available fields:" << sl.join(", ");
-	}
+	if(ix < 0)
+		log_field_not_found(field_name, record());
+	else
+		ret = value(ix);
+	return ret;
+}
+
+QVariant Query::value(const FieldHandle &field_handle) const
+{
+	QVariant ret;
+	int ix = fieldIndex(field_handle);
+	if(ix < 0)
+		log_field_not_found(field_handle.fieldName(), record());
 	else
 		ret = value(ix);
 	return ret;
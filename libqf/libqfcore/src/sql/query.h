@@ -2,11 +2,13 @@
 #define QF_CORE_SQL_QUERY_H
 
 #include "../core/coreglobal.h"
+#include "../utils/fieldnameindex.h"
 
 #include <QSqlRecord>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariantMap>
+#include <QSharedPointer>
 
 class QSqlDatabase;
 
@@ -15,11 +17,20 @@ namespace core {
 namespace sql {
 
 class QueryBuilder;
+struct PreparedStatement;
 
 class QFCORE_DECL_EXPORT Query : public QSqlQuery
 {
 private:
 	typedef QSqlQuery Super;
+public:
+	/// resolve field name once before loop over rows
+	/// @code
+	/// Query::FieldHandle fld_si("cards.siId");
+	/// while(q.next())
+	///     int si = q.value(fld_si).toInt();
+	/// @endcode
+	using FieldHandle = qf::core::utils::FieldNameIndex::Handle;
 public:
 	explicit Query(const QSqlDatabase &db);
 	/// If connection_name is empty, the application's default database will be used.
@@ -35,16 +46,40 @@ public:
 	/// necessary for proper overloading, const char* is treated as bool without this function
 	bool exec(const char *query, bool throw_exc = false) {return exec(QString::fromUtf8(query), throw_exc);}
 	bool exec(bool throw_exc = false);
+	/**
+	* Executes query using prepared statement from per connection LRU cache keyed by query text.
+	* Statement is parsed and planned by SQL server only first time, next calls just bind values.
+	* Query must use placeholders, values must not be part of the query text, otherwise cache is useless.
+	* Cached statement is held by this query (and its copies) until it is re-executed or destroyed,
+	* then it is returned to cache, so the same statement can be used by nested queries safely.
+	*/
+	bool execCached(const QString &query, const QVariantMap &bound_values = QVariantMap(), bool throw_exc = false);
+	bool execCached(const QueryBuilder &query_builder, bool throw_exc = false);
+	/// drops cached prepared statements, Connection calls it on open, close and schema change
+	static void clearPreparedCache(const QString &connection_name);
+	static int preparedCacheCapacity();
+	static void setPreparedCacheCapacity(int n);
+
 	bool execCommands(const QStringList &commands, const QMap<QString, QString> &replacements = QMap<QString, QString>());
 	void execCommandsThrow(const QStringList &commands, const QMap<QString, QString> &replacements = QMap<QString, QString>());
 	QSqlRecord record() const;
 	int fieldIndex(const QString& field_name) const;
+	int fieldIndex(const FieldHandle& field_handle) const;
 	using Super::value;
 	QVariant value(const QString& field_name) const;
+	QVariant value(const FieldHandle& field_handle) const;
 	QVariantMap values() const;
 	QString lastErrorText() const;
+private:
+	void clearRecordCache();
+	void releaseCachedStatement() {m_cachedStatement.reset();}
+	const qf::core::utils::FieldNameIndex& fieldNameIndex() const;
 private:
 	mutable QSqlRecord m_demangledRecord;
+	mutable qf::core::utils::FieldNameIndex m_fieldNameIndex;
+	QString m_connectionName;
+	/// statement checked out from prepared cache, it is returned to cache when last copy of this query releases it
+	QSharedPointer<PreparedStatement> m_cachedStatement;
 };
 
 }}}
@@ -199,6 +199,8 @@ QueryBuilder& QueryBuilder::from(const QueryBuilder &table)
 {
 	qfLogFuncFrame();
 	addJoin(JoinDefinition(TableKey(), TableKey(), QVariant::fromValue(table), QString(), QString()));
+	for(auto it = table.boundValues().constBegin(); it != table.boundValues().constEnd(); ++it)
+		bindValue(it.key(), it.value());
 	return *this;
 }
 
@@ -248,6 +250,8 @@ QueryBuilder &QueryBuilder::joinQueryRestricted(const QString &t1_key, const Que
 	qfLogFuncFrame();
 	QString t2_name = t2_select_query.buildString(AsKey);
 	addJoin(JoinDefinition(TableKey(t1_key), TableKey(t2_name, t2_key_field), QVariant::fromValue(t2_select_query), join_kind, where_restriction));
+	for(auto it = t2_select_query.boundValues().constBegin(); it != t2_select_query.boundValues().constEnd(); ++it)
+		bindValue(it.key(), it.value());
 	return *this;
 }
 
@@ -356,6 +360,13 @@ QVariant QueryBuilder::take(QueryMapKey key)
 void QueryBuilder::clear()
 {
 	m_queryMap.clear();
+	m_boundValues.clear();
+}
+
+QueryBuilder &QueryBuilder::bindValue(const QString &placeholder, const QVariant &val)
+{
+	m_boundValues[placeholder] = val;
+	return *this;
 }
 
 bool QueryBuilder::BuildOptions::isSqlDriverSupportsTableNamesInSelect() const
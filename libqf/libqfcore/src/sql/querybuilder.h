@@ -112,6 +112,13 @@ public:
 	QueryBuilder& limit(int n);
 	QueryBuilder& offset(int n);
 	QueryBuilder& as(const QString &alias_name);
+	/**
+	* Value for named placeholder used in query, for example where("runs.id=:runId").bindValue(":runId", run_id).
+	* Parametrised query text does not change with values, so prepared statement can be reused, see Query::execCached().
+	* Values bound in sub-queries passed to from() or join() are taken over.
+	*/
+	QueryBuilder& bindValue(const QString &placeholder, const QVariant &val);
+	const QVariantMap& boundValues() const {return m_boundValues;}
 
 	QVariant takeWhere();
 	QVariant takeOrderBy();
@@ -189,6 +196,7 @@ private:
 	QString buildString(QueryMapKey key) const;
 private:
 	QueryMap m_queryMap;
+	QVariantMap m_boundValues;
 };
 
 }}}
@@ -0,0 +1,58 @@
+#include "fieldnameindex.h"
+
+#include <QAtomicInt>
+
+namespace qf {
+namespace core {
+namespace utils {
+
+static int nextSerialNo()
+{
+	static QAtomicInt s_serialNo;
+	int ret = s_serialNo.fetchAndAddRelaxed(1) + 1;
+	/// 0 is reserved for invalid index
+	if(ret == 0)
+		ret = s_serialNo.fetchAndAddRelaxed(1) + 1;
+	return ret;
+}
+
+void FieldNameIndex::clear()
+{
+	m_index.clear();
+	m_count = 0;
+	m_serialNo = 0;
+}
+
+void FieldNameIndex::append(const QString &field_name)
+{
+	const int ix = m_count++;
+	/// psql (podle SQL92) predelava vsechny nazvy sloupcu do lowercase, proto case insensitive
+	const QString key = field_name.toCaseFolded();
+	if(!m_index.contains(key))
+		m_index[key] = ix;
+	for(int i = key.indexOf('.'); i >= 0; i = key.indexOf('.', i + 1)) {
+		const QString suffix = key.mid(i + 1);
+		if(!m_index.contains(suffix))
+			m_index[suffix] = ix;
+	}
+	/// field not found before can be found now, handles have to be resolved again
+	m_serialNo = nextSerialNo();
+}
+
+int FieldNameIndex::indexOf(const QString &field_name) const
+{
+	return m_index.value(field_name.toCaseFolded(), -1);
+}
+
+int FieldNameIndex::indexOf(const FieldNameIndex::Handle &handle) const
+{
+	if(!isValid())
+		return -1;
+	if(handle.m_indexSerialNo != m_serialNo) {
+		handle.m_index = indexOf(handle.fieldName());
+		handle.m_indexSerialNo = m_serialNo;
+	}
+	return handle.m_index;
+}
+
+}}}
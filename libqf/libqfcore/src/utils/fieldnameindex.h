@@ -0,0 +1,57 @@
+#ifndef QF_CORE_UTILS_FIELDNAMEINDEX_H
+#define QF_CORE_UTILS_FIELDNAMEINDEX_H
+
+#include "../core/coreglobal.h"
+
+#include <QHash>
+#include <QString>
+
+namespace qf {
+namespace core {
+namespace utils {
+
+/// Precomputed field name -> index map of result set or table columns.
+/// Lookup has the same semantics as linear scan with Utils::fieldNameEndsWith(),
+/// every dot separated suffix of field name is stored case folded,
+/// so both 'runs.id' and 'id' are found in O(1). First field in column order wins.
+class QFCORE_DECL_EXPORT FieldNameIndex
+{
+public:
+	/// Field name resolved once per index and then cached.
+	/// Create it before loop over result set rows and read values by it in the loop,
+	/// name is resolved again only when index changes, for example when query is re-executed.
+	/// Handle caches resolved index without locking, do not share one instance between threads.
+	class QFCORE_DECL_EXPORT Handle
+	{
+		friend class FieldNameIndex;
+	public:
+		explicit Handle(const QString &field_name) : m_fieldName(field_name) {}
+		explicit Handle(const char *field_name) : m_fieldName(QString::fromUtf8(field_name)) {}
+
+		const QString& fieldName() const {return m_fieldName;}
+	private:
+		QString m_fieldName;
+		mutable int m_index = -1;
+		mutable int m_indexSerialNo = 0;
+	};
+public:
+	FieldNameIndex() {}
+
+	/// index is valid when it was built, it can contain no fields
+	bool isValid() const {return m_serialNo != 0;}
+	int count() const {return m_count;}
+	void clear();
+	/// field gets index count()
+	void append(const QString &field_name);
+
+	int indexOf(const QString &field_name) const;
+	int indexOf(const Handle &handle) const;
+private:
+	QHash<QString, int> m_index;
+	int m_count = 0;
+	int m_serialNo = 0;
+};
+
+}}}
+
+#endif // QF_CORE_UTILS_FIELDNAMEINDEX_H
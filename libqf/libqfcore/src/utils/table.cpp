@@ -10,9 +10,11 @@
 #include <QTextCodec>
 #include <QStringBuilder>
 #include <QDate>
+#include <QDateTime>
 #include <QDomElement>
 #include <QTextStream>
 
+#include <algorithm>
 #include <limits>
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
@@ -233,30 +235,34 @@ Table::Field::Field(const QString & _name, const QString & _def)
 //=========================================
 //           Table::FieldList
 //=========================================
+const FieldNameIndex &Table::FieldList::nameIndex() const
+{
+	if(!m_nameIndex.isValid() || m_nameIndex.count() != count()) {
+		m_nameIndex.clear();
+		for(const Field &fld : *this)
+			m_nameIndex.append(fld.name());
+	}
+	return m_nameIndex;
+}
+
 int Table::FieldList::fieldIndex(const QString &field_name) const
 {
-	int col = -1, i = 0;
-	QString s = field_name;
-	foreach(Field fld, *this) {
-		if(Utils::fieldNameEndsWith(fld.name(), s)) {
-			col = i;
-			break;
-		}
-		i++;
-	}
-	/*
-	if(col < 0) {
-		QString s1;
-		foreach(Field fld, *this)
-			s1 += ", " + fld.name();
-		s1 = s1.mid(2);
-		if(throw_exc) {
-			qfInfo() << Log::stackTrace();
-			qfFatal("Field '%s' not found in query\nAvailable fields are: %s", qPrintable(field_name), qPrintable(s1));
-		}
-		return -1;
+	int col = nameIndex().indexOf(field_name);
+	if(col >= 0 && !Utils::fieldNameEndsWith(at(col).name(), field_name)) {
+		/// field was renamed without invalidateNameIndex()
+		m_nameIndex.clear();
+		col = nameIndex().indexOf(field_name);
+	}
+	return col;
+}
+
+int Table::FieldList::fieldIndex(const FieldNameIndex::Handle &field_handle) const
+{
+	int col = nameIndex().indexOf(field_handle);
+	if(col >= 0 && !Utils::fieldNameEndsWith(at(col).name(), field_handle.fieldName())) {
+		m_nameIndex.clear();
+		col = nameIndex().indexOf(field_handle);
 	}
-	*/
 	return col;
 }
 
@@ -340,19 +346,26 @@ const TableRow& TableRow::sharedNull()
 
 void TableRow::insertInitValue(int ix)
 {
-	d->origValues.clear();
-	d->dirtyFlags.clear();
+	d->editState = nullptr;
 	d->values.insert(ix, QVariant());
 }
 
+TableRow::EditState *TableRow::editStateRef()
+{
+	if(!d->editState || d->editState->origValues.count() < d->values.count())
+		saveValues();
+	return d->editState.data();
+}
+
 bool TableRow::isDirty(int field_no) const
 {
 	QF_ASSERT(field_no >= 0 && field_no < d->values.size(),
 			  QString("field index %1 is out of range (%2)").arg(field_no).arg(d->values.size()),
 			  return false);
 	bool ret = false;
-	if(field_no < d->dirtyFlags.count()) {
-		ret = d->dirtyFlags.at(field_no);
+	const EditState *es = editState();
+	if(es && field_no < es->dirtyFlags.count()) {
+		ret = es->dirtyFlags.at(field_no);
 	}
 	//qfInfo() << field_no << "->" << ret;
 	return ret;
@@ -364,18 +377,21 @@ void TableRow::setDirty(int field_no, bool val)
 	QF_ASSERT(field_no >= 0 && field_no < d->values.size(),
 			  QString("field index %1 is out of range (%2)").arg(field_no).arg(d->values.size()),
 			  return);
-	if(d->dirtyFlags.count() < d->values.count()) {
-		d->dirtyFlags.clear();
-		d->dirtyFlags.resize(d->values.size());
-	}
+	if(isReadOnly())
+		return;
+	if(!val && !editState())
+		return;
 	//qfInfo() << val << "->" << field_no;
-	d->dirtyFlags[field_no] = val;
+	editStateRef()->dirtyFlags[field_no] = val;
 }
 
 bool TableRow::isDirty() const
 {
-	for(int i=0; i<d->dirtyFlags.count(); i++) {
-		if(d->dirtyFlags[i])
+	const EditState *es = editState();
+	if(!es)
+		return false;
+	for(int i=0; i<es->dirtyFlags.count(); i++) {
+		if(es->dirtyFlags[i])
 			return true;
 	}
 	return false;
@@ -383,11 +399,15 @@ bool TableRow::isDirty() const
 
 QVariant TableRow::origValue(int col) const
 {
+	const EditState *es = editState();
+	/// not edited row has original values the same as current ones
+	if(!es)
+		return value(col);
 	QVariant ret;
-	QF_ASSERT(col >= 0 && col < d->origValues.size(),
-			  QString("Column %1 is out of origValues range %2").arg(col).arg(d->origValues.size()),
+	QF_ASSERT(col >= 0 && col < es->origValues.size(),
+			  QString("Column %1 is out of origValues range %2").arg(col).arg(es->origValues.size()),
 			  return ret);
-	ret = d->origValues.value(col);
+	ret = es->origValues.value(col);
 	return ret;
 }
 
@@ -451,9 +471,6 @@ void TableRow::setBareBoneValue(int col, const QVariant & val)
 void TableRow::setValue(int col, const QVariant &v)
 {
 	qfLogFuncFrame() << "col:" << col << "val:" << v.toString();
-	if(d->values.count() > d->origValues.count()) {
-		saveValues();
-	}
 	QF_ASSERT(col >= 0 && col < d->values.size(),
 		QString("Column %1 is out of range %2").arg(col).arg(d->values.size()),
 		return);
@@ -461,7 +478,11 @@ void TableRow::setValue(int col, const QVariant &v)
 	QVariant new_val;
 	if(v.isValid())
 		new_val = Utils::retypeVariant(v, fields()[col].type());
-	QVariant orig_val = origValue(col);
+	if(isReadOnly()) {
+		d->values[col] = new_val;
+		return;
+	}
+	QVariant orig_val = editStateRef()->origValues.at(col);
 	//qfInfo() << new_val << "is null:" << new_val.isNull() << "==" << orig_val << "is null:" << orig_val.isNull() << "->" << (new_val == orig_val);
 	bool same_nullity = (new_val.isNull() && orig_val.isNull()) || (!new_val.isNull() && !orig_val.isNull());
 	bool same_values = same_nullity && (new_val == orig_val);
@@ -486,11 +507,14 @@ void TableRow::setValue(const QString &field_name, const QVariant &v)
 void TableRow::restoreOrigValue(int col)
 {
 	qfLogFuncFrame() << "col:" << col;
-	QVariant orig_val = d->origValues.value(col);
+	if(!editState())
+		return;
+	EditState *es = d->editState.data();
+	QVariant orig_val = es->origValues.value(col);
 	/// pokud hodnota byla nastavena (napr. po opakovanem prenastaveni) nakonec na originalni, neni nutne ji ukladat
 	d->values[col] = orig_val;
-	if(col < d->dirtyFlags.count()) {
-		d->dirtyFlags[col] = false;
+	if(col < es->dirtyFlags.count()) {
+		es->dirtyFlags[col] = false;
 	}
 }
 
@@ -499,28 +523,29 @@ void TableRow::saveValues()
 	//qfInfo() << "save values:" << d->values.size();
 	//if(isDirty()) return;
 	//qfLogFuncFrame() << "fieldcnt:" << fields().size();
-	//origValues.clear();
-	d->origValues.resize(d->values.size());
-	d->dirtyFlags.resize(d->values.size());
-	for(int i=0; i<d->values.size(); i++) {
-		//qfInfo() << i << d->values[i] << "->" << d->origValues[i];
-		d->origValues[i] = d->values[i];
-		d->dirtyFlags[i] = false;
+	if(isReadOnly()) {
+		d->editState = nullptr;
+		return;
 	}
+	EditState *es = new EditState();
+	es->origValues = d->values;
+	es->dirtyFlags.resize(d->values.size());
+	d->editState = es;
 }
 
 void TableRow::restoreOrigValues()
 {
-	for(int i=0; i<d->values.count(); i++) {
-		d->values[i] = origValue(i);
+	const EditState *es = editState();
+	if(es) {
+		for(int i=0; i<d->values.count() && i<es->origValues.count(); i++)
+			d->values[i] = es->origValues[i];
 	}
 	clearOrigValues();
 }
 
 void TableRow::clearOrigValues()
 {
-	d->origValues.clear();
-	d->dirtyFlags.clear();
+	d->editState = nullptr;
 }
 void TableRow::clearEditFlags()
 {
@@ -532,8 +557,12 @@ void TableRow::clearEditFlags()
 void TableRow::prepareForCopy()
 {
 	/// setup copied row to be inserted on post call
-	d->origValues.clear();
-	d->origValues.resize(d->values.size());
+	if(!isReadOnly()) {
+		EditState *es = new EditState();
+		es->origValues.resize(d->values.size());
+		es->dirtyFlags.resize(d->values.size());
+		d->editState = es;
+	}
 	setInsert(true);
 	//qfInfo() << "is insert;" << isInsert();
 	for(int i=0; i<fields().count(); i++) {
@@ -618,6 +647,7 @@ void Table::cleanupData(CleanupDataOption fields_options)
 		case ClearFieldsRows:
 			qfDebug() << "\tcleaning fields";
 			fieldsRef().clear();
+			d->secondaryIndexes.clear();
 			[[clang::fallthrough]];
 		default:
 			qfDebug() << "\tcleaning rows";
@@ -640,6 +670,10 @@ Table::Field &Table::insertColumn(int ix, const QString &name, QVariant::Type t)
 {
 	FieldList &fields = fieldsRef();
 	fields.insert(ix, Field(name, t));
+	for(SecondaryIndex &index : d->secondaryIndexes) {
+		if(index.fieldIndex >= ix)
+			index.fieldIndex++;
+	}
 	for (int i = 0; i < rowCount(); ++i) {
 		TableRow &r = rowRef(i);
 		r.setTableProperties(tableProperties());
@@ -700,8 +734,13 @@ TableRow& Table::insertRow(int before_row, const TableRow &_row)
 	int r = (isValidRowIndex(before_row))? before_row: rowCount();
 	TableRow empty_row(_row);
 	empty_row.setInsert(true);
-	rowsRef().append(empty_row);
-	rowIndexRef().insert(r, rowsRef().count()-1);
+	d->rows.append(empty_row);
+	int ix = d->rows.count() - 1;
+	rowIndexRef().insert(r, ix);
+	if(!d->secondaryIndexesDirty) {
+		for(SecondaryIndex &index : d->secondaryIndexes)
+			insertIntoSecondaryIndex(index, empty_row.value(index.fieldIndex), ix);
+	}
 	TableRow &row = rowRef(r);
 	//if(fill_default_and_auto_values) row.fillDefaultAndAutogeneratedValues();
 	return row;
@@ -715,6 +754,22 @@ TableRow Table::isolatedRow()
 	return empty_row;
 }
 
+void Table::setReadOnly(bool b)
+{
+	if(isReadOnly() == b)
+		return;
+	tablePropertiesRef().setReadOnly(b);
+	/// rows share table properties, they must get the new ones to be still recognized as rows of this table
+	/// values are not changed, secondary indexes stay valid
+	RowList &rows = d->rows;
+	for(int i=0; i<rows.count(); i++) {
+		TableRow &row = rows[i];
+		row.setTableProperties(tableProperties());
+		if(b && row.hasEditState())
+			row.clearOrigValues();
+	}
+}
+
 bool Table::removeRow(int ri)
 {
 	//qfLogFuncFrame();
@@ -723,13 +778,34 @@ bool Table::removeRow(int ri)
 		return false;
 	}
 	int ix = rowNumberToRowIndex(ri);
-	rowsRef().removeAt(ix);
+	d->rows.removeAt(ix);
 	rowIndexRef().remove(ri);
     /// posun zbyvajici indexy
 	RowIndexList &rlst = rowIndexRef();
 	for(int i=0; i<rlst.count(); i++)
 		if(rlst[i]>ix)
 			rlst[i]--;
+	if(!d->secondaryIndexesDirty) {
+		/// removed row entry is dropped, entries of rows behind it are shifted
+		for(SecondaryIndex &index : d->secondaryIndexes) {
+			for(auto it = index.hash.begin(); it != index.hash.end(); ) {
+				if(it.value() == ix) {
+					it = index.hash.erase(it);
+					continue;
+				}
+				if(it.value() > ix)
+					it.value()--;
+				++it;
+			}
+			for(int i=index.sorted.count()-1; i>=0; i--) {
+				int &row_ix = index.sorted[i].second;
+				if(row_ix == ix)
+					index.sorted.remove(i);
+				else if(row_ix > ix)
+					row_ix--;
+			}
+		}
+	}
 	return true;
 }
 
@@ -748,6 +824,8 @@ void Table::revertRow(TableRow &r)
 
 void Table::createRowIndex()
 {
+	d->secondaryIndexesDirty = true;
+	d->rowIndexToRowNumber.clear();
 	d->rowIndex.clear();
 	d->rowIndex.resize(d->rows.count());
 	for(int i=0; i<d->rows.count(); i++)
@@ -940,7 +1018,7 @@ void Table::importCSV(QTextStream &ts, TextImportOptions opts)
 				r.setValue(i, s);
 			}
 			r.clearOrigValues();
-			d->rows.append(r);
+			rowsRef().append(r);
 		}
 	}
 	//reload();
@@ -1222,8 +1300,87 @@ int Table::seek(const QVariant &v) const
 	return res - rowIndex().begin();
 }
 
+namespace {
+bool is_integer_type(QVariant::Type t)
+{
+	switch(t) {
+	case QVariant::Bool:
+	case QVariant::Int:
+	case QVariant::UInt:
+	case QVariant::LongLong:
+	case QVariant::ULongLong:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool is_date_time_type(QVariant::Type t)
+{
+	return t == QVariant::Date || t == QVariant::DateTime;
+}
+
+/// order of values in sorted secondary index, NULL is the smallest one
+int index_value_cmp(const QVariant &l, const QVariant &r)
+{
+	bool l_null = l.isNull();
+	bool r_null = r.isNull();
+	if(l_null || r_null)
+		return (l_null? 0: 1) - (r_null? 0: 1);
+	if(is_integer_type(l.type()) && is_integer_type(r.type())) {
+		qlonglong a = l.toLongLong();
+		qlonglong b = r.toLongLong();
+		return (a < b)? -1: (a > b)? 1: 0;
+	}
+	if((is_integer_type(l.type()) || l.type() == QVariant::Double) && (is_integer_type(r.type()) || r.type() == QVariant::Double)) {
+		double a = l.toDouble();
+		double b = r.toDouble();
+		return (a < b)? -1: (a > b)? 1: 0;
+	}
+	if(is_date_time_type(l.type()) && is_date_time_type(r.type())) {
+		QDateTime a = l.toDateTime();
+		QDateTime b = r.toDateTime();
+		return (a < b)? -1: (a > b)? 1: 0;
+	}
+	int ret = QString::compare(l.toString(), r.toString());
+	return (ret < 0)? -1: (ret > 0)? 1: 0;
+}
+
+struct IndexValueLessThan
+{
+	bool operator()(const QPair<QVariant, int> &e, const QVariant &v) const {return index_value_cmp(e.first, v) < 0;}
+	bool operator()(const QVariant &v, const QPair<QVariant, int> &e) const {return index_value_cmp(v, e.first) < 0;}
+	bool operator()(const QPair<QVariant, int> &e1, const QPair<QVariant, int> &e2) const
+	{
+		int ret = index_value_cmp(e1.first, e2.first);
+		if(ret == 0)
+			return e1.second < e2.second;
+		return ret < 0;
+	}
+};
+}
+
 int Table::find(int field_ix, const QVariant &val) const
 {
+	if(const SecondaryIndex *index = secondaryIndex(field_ix)) {
+		/// last matching row like scan does
+		int ret = -1;
+		if(index->type == IndexType::Hash) {
+			const QString key = val.toString();
+			for(auto it = index->hash.constFind(key); it != index->hash.constEnd() && it.key() == key; ++it) {
+				if(it.value() > ret && rows()[it.value()].value(field_ix) == val)
+					ret = it.value();
+			}
+		}
+		else {
+			auto range = std::equal_range(index->sorted.constBegin(), index->sorted.constEnd(), val, IndexValueLessThan());
+			for(auto it = range.first; it != range.second; ++it) {
+				if(it->second > ret && rows()[it->second].value(field_ix) == val)
+					ret = it->second;
+			}
+		}
+		return ret;
+	}
 	int ret = -1;
 	RowList row_lst = rows();
 	for(int ix=0; ix < row_lst.count(); ix++) {
@@ -1244,6 +1401,211 @@ int Table::find(const QString &field_name, const QVariant &val) const
 	return find(field_ix, val);
 }
 
+void Table::addIndex(int field_ix, IndexType type)
+{
+	QF_ASSERT(isValidFieldIndex(field_ix), QString("Invalid field index: %1").arg(field_ix), return);
+	for(int i=0; i<d->secondaryIndexes.count(); i++) {
+		if(d->secondaryIndexes[i].fieldIndex == field_ix) {
+			d->secondaryIndexes.remove(i);
+			break;
+		}
+	}
+	SecondaryIndex index;
+	index.fieldIndex = field_ix;
+	index.type = type;
+	if(!d->secondaryIndexesDirty)
+		buildSecondaryIndex(index, rows());
+	d->secondaryIndexes << index;
+}
+
+void Table::insertIntoSecondaryIndex(SecondaryIndex &index, const QVariant &val, int row_ix)
+{
+	if(index.type == IndexType::Hash) {
+		index.hash.insert(val.toString(), row_ix);
+	}
+	else {
+		QPair<QVariant, int> entry(val, row_ix);
+		auto it = std::lower_bound(index.sorted.begin(), index.sorted.end(), entry, IndexValueLessThan());
+		index.sorted.insert(it, entry);
+	}
+}
+
+void Table::removeFromSecondaryIndex(SecondaryIndex &index, const QVariant &val, int row_ix)
+{
+	if(index.type == IndexType::Hash) {
+		index.hash.remove(val.toString(), row_ix);
+	}
+	else {
+		QPair<QVariant, int> entry(val, row_ix);
+		auto it = std::lower_bound(index.sorted.begin(), index.sorted.end(), entry, IndexValueLessThan());
+		if(it != index.sorted.end() && it->second == row_ix)
+			index.sorted.erase(it);
+	}
+}
+
+void Table::setValue(int row_no, int field_ix, const QVariant &val)
+{
+	TableRow &row = rowRef(row_no);
+	if(!d->secondaryIndexesDirty) {
+		int ix = rowNumberToRowIndex(row_no);
+		for(SecondaryIndex &index : d->secondaryIndexes) {
+			if(index.fieldIndex == field_ix) {
+				removeFromSecondaryIndex(index, row.value(field_ix), ix);
+				row.setValue(field_ix, val);
+				insertIntoSecondaryIndex(index, row.value(field_ix), ix);
+				return;
+			}
+		}
+	}
+	row.setValue(field_ix, val);
+}
+
+void Table::clearIndexes()
+{
+	d->secondaryIndexes.clear();
+}
+
+const Table::SecondaryIndex *Table::secondaryIndex(int field_ix) const
+{
+	const QVector<SecondaryIndex> &indexes = d->secondaryIndexes;
+	auto it = std::find_if(indexes.constBegin(), indexes.constEnd(), [field_ix](const SecondaryIndex &index) {
+		return index.fieldIndex == field_ix;
+	});
+	if(it == indexes.constEnd())
+		return nullptr;
+	if(d->secondaryIndexesDirty) {
+		int n = it - indexes.constBegin();
+		rebuildSecondaryIndexes();
+		return &d->secondaryIndexes.at(n);
+	}
+	return &(*it);
+}
+
+void Table::rebuildSecondaryIndexes() const
+{
+	qfLogFuncFrame() << "index count:" << d->secondaryIndexes.count() << "row count:" << rows().count();
+	for(SecondaryIndex &index : d->secondaryIndexes)
+		buildSecondaryIndex(index, rows());
+	d->secondaryIndexesDirty = false;
+}
+
+void Table::buildSecondaryIndex(SecondaryIndex &index, const RowList &rows)
+{
+	index.hash.clear();
+	index.sorted.clear();
+	if(index.type == IndexType::Hash) {
+		index.hash.reserve(rows.count());
+		for(int i=0; i<rows.count(); i++)
+			index.hash.insert(rows[i].value(index.fieldIndex).toString(), i);
+	}
+	else {
+		index.sorted.reserve(rows.count());
+		for(int i=0; i<rows.count(); i++)
+			index.sorted << QPair<QVariant, int>(rows[i].value(index.fieldIndex), i);
+		std::sort(index.sorted.begin(), index.sorted.end(), IndexValueLessThan());
+	}
+}
+
+int Table::rowIndexToRowNumber(int row_index) const
+{
+	QVector<int> &inverse = d->rowIndexToRowNumber;
+	if(inverse.count() != rows().count()) {
+		inverse.fill(-1, rows().count());
+		const RowIndexList &row_index_list = rowIndex();
+		for(int i=0; i<row_index_list.count(); i++)
+			inverse[row_index_list[i]] = i;
+	}
+	return inverse.value(row_index, -1);
+}
+
+QList<int> Table::findAll(int field_ix, const QVariant &val) const
+{
+	QList<int> ret;
+	const SecondaryIndex *index = secondaryIndex(field_ix);
+	if(!index) {
+		for(int i=0; i<rowCount(); i++) {
+			if(rows()[rowIndex()[i]].value(field_ix) == val)
+				ret << i;
+		}
+		return ret;
+	}
+	auto add_row = [this, &ret, field_ix, &val](int row_ix) {
+		/// values of different types can have the same key
+		if(rows()[row_ix].value(field_ix) == val) {
+			int row_no = rowIndexToRowNumber(row_ix);
+			if(row_no >= 0)
+				ret << row_no;
+		}
+	};
+	if(index->type == IndexType::Hash) {
+		const QString key = val.toString();
+		for(auto it = index->hash.constFind(key); it != index->hash.constEnd() && it.key() == key; ++it)
+			add_row(it.value());
+	}
+	else {
+		auto range = std::equal_range(index->sorted.constBegin(), index->sorted.constEnd(), val, IndexValueLessThan());
+		for(auto it = range.first; it != range.second; ++it)
+			add_row(it->second);
+	}
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+QList<int> Table::findPrefix(int field_ix, const QString &prefix) const
+{
+	QList<int> ret;
+	const SecondaryIndex *index = secondaryIndex(field_ix);
+	QF_ASSERT(index && index->type == IndexType::Sorted,
+			  QString("Sorted index on field %1 is needed for prefix lookup.").arg(field_ix),
+			  return ret);
+	auto it = std::lower_bound(index->sorted.constBegin(), index->sorted.constEnd(), QVariant(prefix), IndexValueLessThan());
+	for(; it != index->sorted.constEnd(); ++it) {
+		if(!it->first.toString().startsWith(prefix))
+			break;
+		int row_no = rowIndexToRowNumber(it->second);
+		if(row_no >= 0)
+			ret << row_no;
+	}
+	return ret;
+}
+
+QList<int> Table::findRange(int field_ix, const QVariant &from, const QVariant &to) const
+{
+	QList<int> ret;
+	const SecondaryIndex *index = secondaryIndex(field_ix);
+	QF_ASSERT(index && index->type == IndexType::Sorted,
+			  QString("Sorted index on field %1 is needed for range lookup.").arg(field_ix),
+			  return ret);
+	auto begin = index->sorted.constBegin();
+	if(from.isValid())
+		begin = std::lower_bound(index->sorted.constBegin(), index->sorted.constEnd(), from, IndexValueLessThan());
+	auto end = index->sorted.constEnd();
+	if(to.isValid())
+		end = std::lower_bound(begin, index->sorted.constEnd(), to, IndexValueLessThan());
+	for(auto it = begin; it < end; ++it) {
+		int row_no = rowIndexToRowNumber(it->second);
+		if(row_no >= 0)
+			ret << row_no;
+	}
+	return ret;
+}
+
+int Table::seek(int field_ix, const QVariant &val) const
+{
+	const SecondaryIndex *index = secondaryIndex(field_ix);
+	QF_ASSERT(index && index->type == IndexType::Sorted,
+			  QString("Sorted index on field %1 is needed for seek.").arg(field_ix),
+			  return -1);
+	auto it = std::lower_bound(index->sorted.constBegin(), index->sorted.constEnd(), val, IndexValueLessThan());
+	for(; it != index->sorted.constEnd(); ++it) {
+		/// skip rows filtered out of row index
+		int row_no = rowIndexToRowNumber(it->second);
+		if(row_no >= 0)
+			return row_no;
+	}
+	return -1;
+}
+
 QVariant Table::sumValue(int field_ix) const
 {
 	QVariant::Type type = field(field_ix).type();
@@ -1474,9 +1836,75 @@ void Table::dataFromVariantList(const QVariantList &_lst)
 	}
 	createRowIndex();
 }
+namespace {
+/// sorted value of one row, string values have precomputed collation key
+struct RowSortKey
+{
+	QVariant value;
+	QByteArray key;
+	bool hasKey = false;
+};
+
+class KeyedLessThan : public Table::LessThan
+{
+public:
+	/// keys[sort_def_index][row_index]
+	KeyedLessThan(const Table &t, const QVector<QVector<RowSortKey>> &keys) : LessThan(t), m_keys(keys) {}
+
+	bool operator()(int r1, int r2) const
+	{
+		for(int i=0; i<sortedFields.count(); i++) {
+			const Table::SortDef &sd = sortedFields[i];
+			const RowSortKey &k1 = m_keys[i][r1];
+			const RowSortKey &k2 = m_keys[i][r2];
+			int res;
+			if(k1.hasKey && k2.hasKey)
+				res = qf::core::Collator::compareSortKeys(k1.key, k2.key);
+			else
+				res = cmp(k1.value, k2.value, sd);
+			if(res == 0)
+				continue;
+			if(sd.ascending)
+				return (res < 0);
+			return (res > 0);
+		}
+		return false;
+	}
+private:
+	const QVector<QVector<RowSortKey>> &m_keys;
+};
+}
+
 void Table::sort(RowIndexList::iterator begin, RowIndexList::iterator end)
 {
-	std::sort(begin, end, LessThan(*this));
+	/// values and collation keys are computed once per row, not in every comparison
+	const SortDefList &sort_defs = tableProperties().sortDefinition();
+	const Collator collator = sortCollator();
+	const RowList &row_list = rows();
+	QVector<QVector<RowSortKey>> keys(sort_defs.count());
+	for(int i=0; i<sort_defs.count(); i++) {
+		const SortDef &sd = sort_defs[i];
+		if(!fields().isValidFieldIndex(sd.fieldIndex)) {
+			qfWarning() << "Invalid sort definition. field index:" << sd.fieldIndex;
+			std::sort(begin, end, LessThan(*this));
+			return;
+		}
+		QVector<RowSortKey> &field_keys = keys[i];
+		field_keys.resize(row_list.count());
+		for(RowIndexList::iterator it = begin; it != end; ++it) {
+			RowSortKey &k = field_keys[*it];
+			k.value = row_list[*it].value(sd.fieldIndex);
+			if(k.value.type() == QVariant::String) {
+				const QString str = k.value.toString();
+				if(sd.ascii7bit)
+					k.key = qf::core::Collator::toAscii7(QLocale::Czech, str, !sd.caseSensitive);
+				else
+					k.key = collator.sortKey(str);
+				k.hasKey = true;
+			}
+		}
+	}
+	std::sort(begin, end, KeyedLessThan(*this, keys));
 }
 
 Table::RowIndexList::const_iterator Table::binaryFind(Table::RowIndexList::const_iterator begin, Table::RowIndexList::const_iterator end, const QVariant & val) const
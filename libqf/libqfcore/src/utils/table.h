@@ -4,12 +4,15 @@
 #include "../core/coreglobal.h"
 #include "../core/utils.h"
 #include "../core/collator.h"
+#include "fieldnameindex.h"
 
 #include <QString>
 #include <QVariantMap>
 #include <QRegExp>
 #include <QVector>
 #include <QBitArray>
+#include <QMultiHash>
+#include <QPair>
 
 class QDomElement;
 class QDomDocument;
@@ -109,6 +112,8 @@ public:
 	};
 protected:
 	typedef QVector<int> RowIndexList;
+public:
+	enum class IndexType {Hash, Sorted};
 public:
 	class QFCORE_DECL_EXPORT Field
 	{
@@ -156,7 +161,14 @@ public:
 			@return field index or value lower than zero
 			 */
 		int fieldIndex(const QString &field_name) const;
+		int fieldIndex(const FieldNameIndex::Handle &field_handle) const;
 		bool isValidFieldIndex(int fld_ix) const;
+		/// must be called when field names are changed, fieldsRef() calls it
+		void invalidateNameIndex() {m_nameIndex.clear();}
+	private:
+		const FieldNameIndex& nameIndex() const;
+	private:
+		mutable FieldNameIndex m_nameIndex;
 	};
 public:
 	class QFCORE_DECL_EXPORT TableProperties
@@ -167,6 +179,7 @@ public:
 		public:
 			FieldList fields;
 			SortDefList sortedFields; //!< Each sorted field has one entry in this list.
+			bool readOnly = false;
 		public:
 			Data() {}
 			~Data() {}
@@ -178,18 +191,29 @@ public:
 		static const TableProperties& sharedNull();
 		bool isNull() const {return d == sharedNull().d;}
 
-		FieldList& fieldsRef() {return d->fields;}
+		FieldList& fieldsRef() {d->fields.invalidateNameIndex(); return d->fields;}
 		const FieldList& fields() const {return d->fields;}
 
 		const SortDefList& sortDefinition() const {return d->sortedFields;}
 		SortDefList& sortDefinitionRef() {return d->sortedFields;}
 		void setSortDefinition(const SortDefList& sdl) {d->sortedFields = sdl;}
 
+		bool isReadOnly() const {return d->readOnly;}
+		void setReadOnly(bool b) {d->readOnly = b;}
+
 		bool operator==(const TableProperties &other) const {return d == other.d;}
 	public:
 		TableProperties();
 	};
 private:
+	/// secondary index of one field, it contains indexes to rows(), not row numbers
+	struct SecondaryIndex
+	{
+		int fieldIndex = -1;
+		IndexType type = IndexType::Hash;
+		QMultiHash<QString, int> hash;
+		QVector<QPair<QVariant, int>> sorted;
+	};
 	class Data : public QSharedData
 	{
 	public:
@@ -201,6 +225,10 @@ private:
 		//int currentRow; ///< index of current row in \a index
 		SortDefList sortedFields;
 		Collator sortCollator;
+		/// indexes are rebuilt lazily in const lookup functions
+		mutable QVector<SecondaryIndex> secondaryIndexes;
+		mutable bool secondaryIndexesDirty = false;
+		mutable QVector<int> rowIndexToRowNumber; ///< inverse of rowIndex, empty when invalid
 	public:
 		Data();
 		~Data() { }
@@ -223,16 +251,29 @@ public:
 private:
 	/// unsorted, unfiltered table rows
 	const RowList& rows() const {return d->rows;}
-	RowList& rowsRef() {return d->rows;}
+	/// rows can be added or changed by caller in bulk, so secondary indexes must be rebuilt
+	RowList& rowsRef() {d->secondaryIndexesDirty = true; return d->rows;}
 	//! clears all rows, if \a fields_options tells what else will be cleared.
 	void cleanupData(CleanupDataOption fields_options);
 	int rowNumberToRowIndex(int rowno) const;
 	void createRowIndex();
 	const RowIndexList& rowIndex() const {return d->rowIndex;}
-	RowIndexList& rowIndexRef() {return d->rowIndex;}
+	RowIndexList& rowIndexRef() {d->rowIndexToRowNumber.clear(); return d->rowIndex;}
+
+	const SecondaryIndex* secondaryIndex(int field_ix) const;
+	void rebuildSecondaryIndexes() const;
+	static void buildSecondaryIndex(SecondaryIndex &index, const RowList &rows);
+	static void insertIntoSecondaryIndex(SecondaryIndex &index, const QVariant &val, int row_ix);
+	static void removeFromSecondaryIndex(SecondaryIndex &index, const QVariant &val, int row_ix);
+	int rowIndexToRowNumber(int row_index) const;
 public:
 	TableProperties& tablePropertiesRef() {return d->tableProperties;}
 	FieldList& fieldsRef() {return tablePropertiesRef().fieldsRef();}
+
+	/// Rows of read-only table do not keep original values and dirty flags,
+	/// TableRow::setValue() only changes value. Use it for tables which are never posted back to database.
+	bool isReadOnly() const {return tableProperties().isReadOnly();}
+	void setReadOnly(bool b);
 public:
 	Field& fieldRef(int fld_ix);
 	Field& fieldRef(const QString& field_name);
@@ -269,6 +310,8 @@ public:
 	virtual TableRow& insertRow(int before_row, const TableRow &_row);
 	TableRow& appendRow() {return insertRow(rowCount());}
 	TableRow& appendRow(const TableRow &_row) {return insertRow(rowCount(), _row);}
+	/// sets value and updates secondary index of field, use it instead of rowRef().setValue() for indexed fields
+	void setValue(int row_no, int field_ix, const QVariant &val);
 	virtual bool removeRow(int ri);
 	// other related
 	void revertRow(int ri);
@@ -298,6 +341,25 @@ public:
 	/// Prochazi tabulku radek po radku, pokus nic nenajde vraci -1
 	int find(int field_ix, const QVariant &val) const;
 	int find(const QString &field_name, const QVariant &val) const;
+public:
+	/// Secondary indexes for fast lookups by field value, hash index is for equality only,
+	/// sorted index can be used for prefix and range lookups too. find() uses them when field is indexed.
+	/// insertRow(), removeRow() and setValue() update indexes in place, bulk changes (reload, imports) cause lazy rebuild on next lookup.
+	/// Indexes do not see values changed through rowRef(), indexed fields have to be changed by setValue().
+	void addIndex(int field_ix, IndexType type = IndexType::Hash);
+	void addIndex(const QString &field_name, IndexType type = IndexType::Hash) {addIndex(fields().fieldIndex(field_name), type);}
+	void clearIndexes();
+	bool hasIndex(int field_ix) const {return secondaryIndex(field_ix) != nullptr;}
+	/// returns numbers of rows with field value equal to val, ordered by row number
+	QList<int> findAll(int field_ix, const QVariant &val) const;
+	QList<int> findAll(const QString &field_name, const QVariant &val) const {return findAll(fields().fieldIndex(field_name), val);}
+	/// returns numbers of rows with string field value starting with prefix in index order, sorted index is needed
+	QList<int> findPrefix(int field_ix, const QString &prefix) const;
+	/// returns numbers of rows with field value in range <from, to) in index order, invalid bound means unbounded, sorted index is needed
+	QList<int> findRange(int field_ix, const QVariant &from, const QVariant &to) const;
+	/// returns number of first row in sorted index with value not less than val or -1, sorted index is needed
+	/// it does not need table to be sorted by field_ix like seek(val) does
+	int seek(int field_ix, const QVariant &val) const;
 public:
 	// export / import
 	QString toString() const;
@@ -330,13 +392,19 @@ public:
 	TableRow(const Table::TableProperties &props);
 private:
 	class SharedDummyHelper {};
+	/// original values and dirty flags exist only for edited rows, they are created on first setValue() or setDirty()
+	class EditState : public QSharedData
+	{
+	public:
+		QVector<QVariant> origValues;
+		QBitArray dirtyFlags; ///< jsou situace, kdy je treba oznacit field jako dirty a pritom origValue a value jsou stejne
+	};
 	class QFCORE_DECL_EXPORT Data : public QSharedData
 	{
 		friend class TableRow;
 	public:
 		QVector<QVariant> values;
-		QVector<QVariant> origValues;
-		QBitArray dirtyFlags; ///< jsou situace, kdy je treba oznacit field jako dirty a pritom origValue a value jsou stejne
+		QSharedDataPointer<EditState> editState; ///< nullptr for not edited row
 		Table::TableProperties tableProperties;
 		struct Flags {
 			bool insert:1;
@@ -351,6 +419,9 @@ private:
 	QSharedDataPointer<Data> d;
 	static const TableRow& sharedNull();
 	TableRow(SharedDummyHelper);
+	const EditState* editState() const {return d->editState.constData();}
+	/// creates edit state with current values as original ones, if it does not exist
+	EditState* editStateRef();
 public:
 	//void initValues();
 	void saveValues();
@@ -383,6 +454,9 @@ public:
 	bool isDirty() const;
 	bool isDirty(int field_no) const;
 	void setDirty(int field_no, bool val = true);
+	/// row has original values saved, it is edited or prepared for copy
+	bool hasEditState() const {return editState() != nullptr;}
+	bool isReadOnly() const {return d->tableProperties.isReadOnly();}
 
 
 	//! returns number of fields in the row.
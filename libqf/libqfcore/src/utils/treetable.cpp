@@ -117,23 +117,112 @@ QString TreeTableColumn::halign() const
 	return ret;
 }
 
+//=================================================
+// TreeTableData
+//=================================================
+namespace qf {
+namespace core {
+namespace utils {
+
+class TreeTableData : public QSharedData
+{
+public:
+	bool isValid = false;
+	QVariantMap meta;
+	QVariantMap keyvals;
+	QVariantList columns;
+	mutable FieldNameIndex columnNameIndex;
+	/// unknown top level keys of table created from QVariant, they are preserved in toVariant()
+	QVariantMap otherValues;
+
+	int rowCount = 0;
+	/// cells[col_ix][row_ix], all column vectors have rowCount items,
+	/// there can be more column vectors than columns when row with more values is inserted
+	QVector<QVector<QVariant>> cells;
+	QVector<QVariantMap> rowKeyvals;
+	QVector<QVector<TreeTable>> rowTables;
+
+	/// nested QVariant form, it is not thread safe, like QML reports using it
+	mutable QVariant cachedVariant;
+	mutable bool isCacheValid = false;
+
+	void ensureCellsWidth(int width)
+	{
+		int old_width = cells.count();
+		if(width <= old_width)
+			return;
+		cells.resize(width);
+		for (int i = old_width; i < width; ++i)
+			cells[i].resize(rowCount);
+	}
+};
+
+}}}
+
+//=================================================
+// TreeTableRow
+//=================================================
+TreeTableRow::TreeTableRow(const QVariant &columns, const QVariant &row_data)
+	: m_columns(columns.toList())
+	, m_isValid(row_data.isValid())
+{
+	if(row_data.type() == QVariant::Map) {
+		const QVariantMap rm = row_data.toMap();
+		m_values = rm.value(TreeTable::KEY_ROW).toList();
+		m_keyvals = rm.value(TreeTable::KEY_KEYVALS).toMap();
+		const QVariantList tlst = rm.value(TreeTable::KEY_TABLES).toList();
+		m_tables.reserve(tlst.count());
+		for(const QVariant &t : tlst)
+			m_tables << TreeTable(t);
+	}
+	else {
+		m_values = row_data.toList();
+	}
+}
+
+const FieldNameIndex &TreeTableRow::columnNameIndex() const
+{
+	if(!m_columnNameIndex.isValid()) {
+		for(const QVariant &c : m_columns)
+			m_columnNameIndex.append(c.toMap().value(TreeTable::KEY_NAME).toString());
+	}
+	return m_columnNameIndex;
+}
+
 int TreeTableRow::columnIndex(const QString &col_name) const
 {
-	return TreeTable::columnIndex(m_columns, col_name);
+	return columnNameIndex().indexOf(col_name);
+}
+
+int TreeTableRow::columnIndex(const FieldNameIndex::Handle &col_handle) const
+{
+	return columnNameIndex().indexOf(col_handle);
+}
+
+QVariant TreeTableRow::row() const
+{
+	if(!m_isValid)
+		return QVariant();
+	if(m_keyvals.isEmpty() && m_tables.isEmpty())
+		return m_values;
+	QVariantMap rm{{TreeTable::KEY_ROW, m_values}};
+	if(!m_keyvals.isEmpty())
+		rm[TreeTable::KEY_KEYVALS] = m_keyvals;
+	if(!m_tables.isEmpty()) {
+		QVariantList tlst;
+		tlst.reserve(m_tables.count());
+		for(const TreeTable &t : m_tables)
+			tlst << t.toVariant();
+		rm[TreeTable::KEY_TABLES] = tlst;
+	}
+	return rm;
 }
 
 QVariant TreeTableRow::value(int col_ix) const
 {
 	if(0 <= col_ix && col_ix < m_columns.count()) {
-		QVariant v;
-		if(m_row.type() == QVariant::Map) {
-			v = m_row.toMap().value(TreeTable::KEY_ROW).toList().value(col_ix);
-		}
-		else {
-			v = m_row.toList().value(col_ix);
-		}
 		/// pretypuj na typ sloupce
-		return retypeVariant(col_ix, v);
+		return retypeVariant(col_ix, m_values.value(col_ix));
 	}
 	qfWarning() << "Column index:" << col_ix << "of:" << m_columns.count() << "does not exist.";
 	return QVariant();
@@ -144,7 +233,7 @@ QVariant TreeTableRow::value(const QString &col_or_key_name) const
 	QVariant v;
 	int ix = columnIndex(col_or_key_name);
 	if(ix < 0) {
-		v = m_row.toMap().value(TreeTable::KEY_KEYVALS).toMap().value(col_or_key_name);
+		v = m_keyvals.value(col_or_key_name);
 	}
 	else {
 		v = value(ix);
@@ -158,40 +247,21 @@ void TreeTableRow::setValue(int col_ix, const QVariant &val)
 		qfWarning() << "Invalid column index:" << col_ix << "of:" << columnCount();
 		return;
 	}
-	if(m_row.type() == QVariant::Map) {
-		QVariantMap rm = m_row.toMap();
-		QVariantList rvals = rm.value(TreeTable::KEY_ROW).toList();
-		while (rvals.count() <= col_ix)
-			rvals << QVariant();
-		rvals[col_ix] = val;
-		rm[TreeTable::KEY_ROW] = rvals;
-		m_row = rm;
-	}
-	else {
-		QVariantList rvals = m_row.toList();
-		while (rvals.count() <= col_ix)
-			rvals << QVariant();
-		rvals[col_ix] = val;
-		m_row = rvals;
-	}
+	while (m_values.count() <= col_ix)
+		m_values << QVariant();
+	m_values[col_ix] = val;
+	m_isValid = true;
 }
 
 void TreeTableRow::setValue(const QString &col_or_key_name, const QVariant &val)
 {
 	int ix = columnIndex(col_or_key_name);
 	if(ix < 0) {
-		QVariantMap rm;
-		if(m_row.type() != QVariant::Map)
-			rm = QVariantMap{ {TreeTable::KEY_ROW, m_row} };
-		else
-			rm = m_row.toMap();
-		QVariantMap kvals = rm.value(TreeTable::KEY_KEYVALS).toMap();
 		if(val.isValid())
-			kvals[col_or_key_name] = val;
+			m_keyvals[col_or_key_name] = val;
 		else
-			kvals.remove(col_or_key_name);
-		rm[TreeTable::KEY_KEYVALS] = kvals;
-		m_row = rm;
+			m_keyvals.remove(col_or_key_name);
+		m_isValid = true;
 	}
 	else {
 		setValue(ix, val);
@@ -210,28 +280,14 @@ QVariant TreeTableRow::retypeVariant(int col_ix, const QVariant &v) const
 	return v;
 }
 
-int TreeTableRow::tablesCount() const
-{
-	if(m_row.type() == QVariant::Map) {
-		return m_row.toMap().value(TreeTable::KEY_TABLES).toList().count();
-	}
-	return 0;
-}
-
 TreeTable TreeTableRow::table(int ix) const
 {
-	if(m_row.type() == QVariant::Map) {
-		QVariant t = m_row.toMap().value(TreeTable::KEY_TABLES).toList().value(ix);
-		return TreeTable(t);
-	}
-	return TreeTable();
+	return m_tables.value(ix);
 }
 
 TreeTable TreeTableRow::table(const QString &table_name) const
 {
-	QVariantList tlst = m_row.toMap().value(TreeTable::KEY_TABLES).toList();
-	for (int i = 0; i < tlst.count(); ++i) {
-		TreeTable tt{tlst[i]};
+	for (const TreeTable &tt : m_tables) {
 		if(tt.name() == table_name)
 			return tt;
 	}
@@ -240,15 +296,8 @@ TreeTable TreeTableRow::table(const QString &table_name) const
 
 void TreeTableRow::appendTable(const TreeTable &t)
 {
-	QVariantMap rm;
-	if(m_row.type() == QVariant::List)
-		rm[TreeTable::KEY_ROW] = m_row;
-	else
-		rm = m_row.toMap();
-	QVariantList tlst = rm.value(TreeTable::KEY_TABLES).toList();
-	tlst << t.toVariant();
-	rm[TreeTable::KEY_TABLES] = tlst;
-	m_row = rm;
+	m_tables << t;
+	m_isValid = true;
 }
 
 //=================================================
@@ -268,16 +317,131 @@ const QString TreeTable::KEY_TABLES = "tables";
 const QString TreeTable::KEY_ROW = "row";
 const QString TreeTable::KEY_KEYVALS = "keyvals";
 
+TreeTable::TreeTable()
+	: d(new TreeTableData)
+{
+}
+
+TreeTable::TreeTable(const QVariant &value, const QString &table_name)
+	: d(new TreeTableData)
+{
+	setValues(value);
+	setName(table_name);
+}
+
+TreeTable::TreeTable(const QString &table_name)
+	: d(new TreeTableData)
+{
+	setName(table_name);
+}
+
+TreeTable::TreeTable(const QVariant &value)
+	: d(new TreeTableData)
+{
+	setValues(value);
+}
+
+TreeTable::TreeTable(const TreeTable &other) = default;
+TreeTable::~TreeTable() = default;
+TreeTable &TreeTable::operator=(const TreeTable &other) = default;
+
+void TreeTable::setValues(const QVariant &value)
+{
+	TreeTableData *dd = d.data();
+	QVariantMap m = value.toMap();
+	dd->isValid = value.isValid();
+	dd->meta = m.take(KEY_META).toMap();
+	dd->keyvals = m.take(KEY_KEYVALS).toMap();
+	dd->columns = m.take(KEY_COLUMNS).toList();
+	dd->columnNameIndex.clear();
+	const QVariantList rows = m.take(KEY_ROWS).toList();
+	dd->otherValues = m;
+
+	dd->rowCount = rows.count();
+	dd->rowKeyvals.resize(dd->rowCount);
+	dd->rowTables.resize(dd->rowCount);
+	dd->cells.clear();
+	dd->ensureCellsWidth(dd->columns.count());
+	for (int i = 0; i < rows.count(); ++i) {
+		const QVariant &row_data = rows[i];
+		QVariantList vals;
+		if(row_data.type() == QVariant::Map) {
+			const QVariantMap rm = row_data.toMap();
+			vals = rm.value(KEY_ROW).toList();
+			dd->rowKeyvals[i] = rm.value(KEY_KEYVALS).toMap();
+			const QVariantList tlst = rm.value(KEY_TABLES).toList();
+			for(const QVariant &t : tlst)
+				dd->rowTables[i] << TreeTable(t);
+		}
+		else {
+			vals = row_data.toList();
+		}
+		dd->ensureCellsWidth(vals.count());
+		for (int j = 0; j < vals.count(); ++j)
+			dd->cells[j][i] = vals[j];
+	}
+	/// table is not modified yet, so source is its QVariant form
+	dd->cachedVariant = dd->isValid? value: QVariant();
+	dd->isCacheValid = true;
+}
+
+TreeTableData *TreeTable::mutableData()
+{
+	TreeTableData *dd = d.data();
+	dd->isValid = true;
+	if(dd->isCacheValid) {
+		dd->isCacheValid = false;
+		dd->cachedVariant = QVariant();
+	}
+	return dd;
+}
+
+bool TreeTable::isValid() const
+{
+	return d->isValid;
+}
+
+QString TreeTable::name() const
+{
+	return d->meta.value(KEY_NAME).toString();
+}
+
 void TreeTable::setName(const QString &n)
 {
-	QVariantMap t = m_values.toMap();
-	QVariantMap m = t.value(KEY_META).toMap();
+	TreeTableData *dd = mutableData();
 	if(n.isEmpty())
-		m.remove(KEY_NAME);
+		dd->meta.remove(KEY_NAME);
 	else
-		m[KEY_NAME] = n;
-	t[KEY_META] = m;
-	m_values = t;
+		dd->meta[KEY_NAME] = n;
+}
+
+const FieldNameIndex &TreeTable::columnNameIndex() const
+{
+	if(!d->columnNameIndex.isValid()) {
+		for(const QVariant &c : d->columns)
+			d->columnNameIndex.append(c.toMap().value(KEY_NAME).toString());
+	}
+	return d->columnNameIndex;
+}
+
+int TreeTable::columnIndex(const QString &col_name) const
+{
+	return columnNameIndex().indexOf(col_name);
+}
+
+int TreeTable::columnIndex(const FieldNameIndex::Handle &col_handle) const
+{
+	return columnNameIndex().indexOf(col_handle);
+}
+
+int TreeTable::columnCount() const
+{
+	return d->columns.count();
+}
+
+int TreeTable::rowCount() const
+{
+	return d->rowCount;
 }
 
 int TreeTable::insertRow(int ix, const QVariantList &vals)
@@ -286,30 +450,30 @@ int TreeTable::insertRow(int ix, const QVariantList &vals)
 		ix = 0;
 	if(ix >= rowCount())
 		ix = rowCount();
-	appendRow();
-	QVariantList rr = rows();
-	for (int i = rr.count() - 1; i > ix; --i) {
-		rr[i] = rr[i-1];
-	}
-	rr[ix] = vals;
-	setRows(rr);
+	TreeTableData *dd = mutableData();
+	dd->ensureCellsWidth(vals.count());
+	for (int j = 0; j < dd->cells.count(); ++j)
+		dd->cells[j].insert(ix, vals.value(j));
+	dd->rowKeyvals.insert(ix, QVariantMap());
+	dd->rowTables.insert(ix, QVector<TreeTable>());
+	dd->rowCount++;
 	return ix;
 }
 
 int TreeTable::appendRow(const QVariantList &vals)
 {
-	QVariantList rr = rows();
-	rr.insert(rr.count(), vals);
-	setRows(rr);
-	return rowCount() - 1;
+	return insertRow(rowCount(), vals);
 }
 
 void TreeTable::removeRow(int ix)
 {
 	if(ix >= 0 &&  ix < rowCount()) {
-		QVariantList rr = rows();
-		rr.removeAt(ix);
-		setRows(rr);
+		TreeTableData *dd = mutableData();
+		for (int j = 0; j < dd->cells.count(); ++j)
+			dd->cells[j].removeAt(ix);
+		dd->rowKeyvals.removeAt(ix);
+		dd->rowTables.removeAt(ix);
+		dd->rowCount--;
 	}
 }
 
@@ -324,14 +488,16 @@ void TreeTable::appendColumn(const QString &name, QVariant::Type type, const QSt
 
 void TreeTable::appendColumn(const TreeTableColumn &c)
 {
-	QVariantList cc = columns();
-	cc << c.values();
-	setColumns(cc);
+	TreeTableData *dd = mutableData();
+	dd->columns << c.values();
+	if(dd->columnNameIndex.isValid())
+		dd->columnNameIndex.append(c.name());
+	dd->ensureCellsWidth(dd->columns.count());
 }
 
 TreeTableColumn TreeTable::column(int col_ix) const
 {
-	return TreeTableColumn(columns().value(col_ix).toMap());
+	return TreeTableColumn(d->columns.value(col_ix).toMap());
 }
 
 void TreeTable::setColumn(int col_ix, const TreeTableColumn &ttc)
@@ -340,14 +506,25 @@ void TreeTable::setColumn(int col_ix, const TreeTableColumn &ttc)
 		qfWarning() << "Invalid column index:" << col_ix << "of:" << columnCount();
 		return;
 	}
-	QVariantList cc = columns();
-	cc[col_ix] = ttc.values();
-	setColumns(cc);
+	TreeTableData *dd = mutableData();
+	dd->columns[col_ix] = ttc.values();
+	dd->columnNameIndex.clear();
 }
 
 TreeTableRow TreeTable::row(int row_ix) const
 {
-	return TreeTableRow(columns(), rows().value(row_ix));
+	TreeTableRow ret;
+	ret.m_columns = d->columns;
+	ret.m_columnNameIndex = columnNameIndex();
+	if(row_ix >= 0 && row_ix < rowCount()) {
+		ret.m_isValid = true;
+		ret.m_values.reserve(d->cells.count());
+		for (int j = 0; j < d->cells.count(); ++j)
+			ret.m_values << d->cells[j][row_ix];
+		ret.m_keyvals = d->rowKeyvals[row_ix];
+		ret.m_tables = d->rowTables[row_ix];
+	}
+	return ret;
 }
 
 void TreeTable::setRow(int row_ix, const TreeTableRow &ttr)
@@ -356,9 +533,82 @@ void TreeTable::setRow(int row_ix, const TreeTableRow &ttr)
 		qfWarning() << "Onvalid row index:" << row_ix << "of:" << rowCount();
 		return;
 	}
-	QVariantList rr = rows();
-	rr[row_ix] = ttr.row();
-	setRows(rr);
+	TreeTableData *dd = mutableData();
+	dd->ensureCellsWidth(ttr.m_values.count());
+	for (int j = 0; j < dd->cells.count(); ++j)
+		dd->cells[j][row_ix] = ttr.m_values.value(j);
+	dd->rowKeyvals[row_ix] = ttr.m_keyvals;
+	dd->rowTables[row_ix] = ttr.m_tables;
+}
+
+QVariant TreeTable::cellValue(int row_ix, int col_ix) const
+{
+	if(row_ix < 0 || row_ix >= rowCount() || col_ix < 0 || col_ix >= columnCount()) {
+		qfWarning() << "Invalid cell row:" << row_ix << "of:" << rowCount() << "column:" << col_ix << "of:" << columnCount();
+		return QVariant();
+	}
+	const QVariant &v = d->cells[col_ix][row_ix];
+	if(v.isValid()) {
+		int t = TreeTableColumn(d->columns[col_ix].toMap()).type();
+		if(t > 0)
+			return Utils::retypeVariant(v, t);
+	}
+	return v;
+}
+
+void TreeTable::setCellValue(int row_ix, int col_ix, const QVariant &val)
+{
+	if(row_ix < 0 || row_ix >= rowCount() || col_ix < 0 || col_ix >= columnCount()) {
+		qfWarning() << "Invalid cell row:" << row_ix << "of:" << rowCount() << "column:" << col_ix << "of:" << columnCount();
+		return;
+	}
+	mutableData()->cells[col_ix][row_ix] = val;
+}
+
+QVariant TreeTable::toVariant() const
+{
+	if(d->isCacheValid)
+		return d->cachedVariant;
+	QVariant ret;
+	if(d->isValid) {
+		QVariantMap t = d->otherValues;
+		if(!d->meta.isEmpty())
+			t[KEY_META] = d->meta;
+		t[KEY_COLUMNS] = d->columns;
+		if(!d->keyvals.isEmpty())
+			t[KEY_KEYVALS] = d->keyvals;
+		QVariantList rows;
+		rows.reserve(d->rowCount);
+		for (int i = 0; i < d->rowCount; ++i) {
+			QVariantList vals;
+			vals.reserve(d->cells.count());
+			for (int j = 0; j < d->cells.count(); ++j)
+				vals << d->cells[j][i];
+			const QVariantMap &kv = d->rowKeyvals[i];
+			const QVector<TreeTable> &tables = d->rowTables[i];
+			if(kv.isEmpty() && tables.isEmpty()) {
+				rows << QVariant(vals);
+			}
+			else {
+				QVariantMap rm{{KEY_ROW, vals}};
+				if(!kv.isEmpty())
+					rm[KEY_KEYVALS] = kv;
+				if(!tables.isEmpty()) {
+					QVariantList tlst;
+					tlst.reserve(tables.count());
+					for(const TreeTable &tt : tables)
+						tlst << tt.toVariant();
+					rm[KEY_TABLES] = tlst;
+				}
+				rows << QVariant(rm);
+			}
+		}
+		t[KEY_ROWS] = rows;
+		ret = t;
+	}
+	d->cachedVariant = ret;
+	d->isCacheValid = true;
+	return ret;
 }
 
 QVariant TreeTable::value(const QString &_key_name, const QVariant &default_val, bool key_ends_with) const
@@ -448,16 +698,16 @@ QVariant TreeTable::value(const QString &_key_name, const QVariant &default_val,
 
 void TreeTable::setValue(const QString& key_name, const QVariant& val)
 {
-	QVariantMap kv = keyvals();
-	kv[key_name] = val;
-	setKeyvals(kv);
+	mutableData()->keyvals[key_name] = val;
 }
 
 void TreeTable::appendTable(int row_ix, const TreeTable &t)
 {
-	auto r = row(row_ix);
-	r.appendTable(t);
-	setRow(row_ix, r);
+	if(row_ix < 0 || row_ix >= rowCount()) {
+		qfWarning() << "Onvalid row index:" << row_ix << "of:" << rowCount();
+		return;
+	}
+	mutableData()->rowTables[row_ix] << t;
 }
 
 QVariant TreeTable::sum(const QString &col_name) const
@@ -474,21 +724,21 @@ QVariant TreeTable::sum(int col_index) const
 	//qfDebug() << QF_FUNC_NAME << "col index:" << col_index;
 	if(col_index < 0 || col_index >= columnCount())
 		return QVariant();
-	QString ts = columns().value(col_index).toMap().value(KEY_TYPE).toString();
+	QString ts = d->columns.value(col_index).toMap().value(KEY_TYPE).toString();
 	QVariant::Type t = QVariant::nameToType(qPrintable(ts));
 	QVariant ret;
 	//qfInfo() << "type:" << QVariant::typeToName(t);
 	if(t == QVariant::Int) {
 		int s = 0;
 		for(int i=0; i<rowCount(); i++) {
-			s += row(i).value(col_index).toInt();
+			s += cellValue(i, col_index).toInt();
 		}
 		ret = s;
 	}
 	else {
 		double s = 0;
 		for(int i=0; i<rowCount(); i++) {
-			s += row(i).value(col_index).toDouble();
+			s += cellValue(i, col_index).toDouble();
 		}
 		ret = s;
 	}
@@ -540,7 +790,7 @@ TreeTable TreeTable::cd(const QString& path) const
 
 QVariantMap TreeTable::keyvals(int row_ix) const
 {
-	return rows().value(row_ix).toMap().value(KEY_KEYVALS).toMap();
+	return d->rowKeyvals.value(row_ix);
 }
 
 static inline QString line_indent(const QString &ind, int level)
@@ -640,18 +890,14 @@ QString TreeTable::toString(QJsonDocument::JsonFormat format) const
 	return QString::fromUtf8(ba);
 }
 
-void TreeTable::setKeyvals(const QVariantMap &keyvals)
+QVariantMap TreeTable::keyvals() const
 {
-	QVariantMap t = valueMap();
-	t[KEY_KEYVALS] = keyvals;
-	m_values = t;
+	return d->keyvals;
 }
 
-void TreeTable::setColumns(const QVariantList &cols)
+QVariantList TreeTable::columns() const
 {
-	QVariantMap t = valueMap();
-	t[KEY_COLUMNS] = cols;
-	m_values = t;
+	return d->columns;
 }
 
 int TreeTable::columnIndex(const QVariantList &cols, const QString &col_name)
@@ -663,11 +909,3 @@ int TreeTable::columnIndex(const QVariantList &cols, const QString &col_name)
 	}
 	return -1;
 }
-
-void TreeTable::setRows(const QVariantList &rows)
-{
-	QVariantMap t = valueMap();
-	t[KEY_ROWS] = rows;
-	m_values = t;
-}
-
@@ -8,10 +8,13 @@
 #define QF_CORE_UTILS_TREETABLE_H
 
 #include "../core/coreglobal.h"
+#include "fieldnameindex.h"
 
 #include <QVariantMap>
 #include <QVariantList>
 #include <QJsonDocument>
+#include <QSharedDataPointer>
+#include <QVector>
 
 namespace qf {
 namespace core {
@@ -48,39 +51,12 @@ private:
 	QVariantMap m_values;
 };
 
-class TreeTable;
-class QFCORE_DECL_EXPORT TreeTableRow
-{
-public:
-	TreeTableRow() {}
-	TreeTableRow(const QVariant &columns, const QVariant &row_data)
-		: m_columns(columns.toList())
-		, m_row(row_data)
-	{}
-
-	bool isValid() const {return m_row.isValid();}
-	int columnCount() const {return m_columns.count();}
-	int columnIndex(const QString &col_name) const;
-
-	QVariant row() const { return  m_row; }
-
-	QVariant value(int col_ix) const;
-	QVariant value(const QString &col_or_key_name) const;
-
-	void setValue(int col_ix, const QVariant &val);
-	void setValue(const QString &col_or_key_name, const QVariant &val);
-
-	int tablesCount() const;
-	TreeTable table(int ix = 0) const;
-	TreeTable table(const QString &table_name) const;
-	void appendTable(const TreeTable &t);
-private:
-	QVariant retypeVariant(int col_ix, const QVariant &v) const;
-private:
-	QVariantList m_columns;
-	QVariant m_row;
-};
+class TreeTableRow;
+class TreeTableData;
 
+/// Table data are stored column-wise in implicitly shared storage, so row and cell mutation is O(1)
+/// and copies are cheap until one of them is modified.
+/// Nested QVariant form (toVariant(), toJson()), used by QML reports, is created lazily and cached until next mutation.
 class QFCORE_DECL_EXPORT TreeTable
 {
 public:
@@ -101,18 +77,22 @@ public:
 	static const QString KEY_KEYVALS;
 	static const QString KEY_TABLES;
 public:
-	TreeTable() {}
-	TreeTable(const QVariant &value, const QString &table_name) : m_values(value) {setName(table_name);}
-	TreeTable(const QString &table_name) {setName(table_name);}
-	TreeTable(const QVariant &value) : m_values(value) {}
+	TreeTable();
+	TreeTable(const QVariant &value, const QString &table_name);
+	TreeTable(const QString &table_name);
+	TreeTable(const QVariant &value);
+	TreeTable(const TreeTable &other);
+	~TreeTable();
+	TreeTable& operator=(const TreeTable &other);
 public:
-	bool isValid() const {return m_values.isValid();}
-	QString name() const {return m_values.toMap().value(KEY_META).toMap().value(KEY_NAME).toString();}
+	bool isValid() const;
+	QString name() const;
 	void setName(const QString &n);
 
 	static int columnIndex(const QVariantList &cols, const QString &col_name);
-	int columnIndex(const QString &col_name) const {return columnIndex(columns(), col_name);}
-	int columnCount() const {return m_values.toMap().value(KEY_COLUMNS).toList().count();}
+	int columnIndex(const QString &col_name) const;
+	int columnIndex(const FieldNameIndex::Handle &col_handle) const;
+	int columnCount() const;
 	void appendColumn(const QString &name, QVariant::Type type = QVariant::String, const QString &caption = QString());
 	void appendColumn(const TreeTableColumn &c);
 
@@ -120,8 +100,7 @@ public:
 	TreeTableColumn column(const QString &col_name) const {return column(columnIndex(col_name));}
 	void setColumn(int col_ix, const TreeTableColumn &ttc);
 
-	int rowCount() const {return m_values.toMap().value(KEY_ROWS).toList().count();}
-	//TreeTableRow row(int ix) const {return TreeTableRow(columns(), rows().property(ix));}
+	int rowCount() const;
 	int insertRow(int ix, const QVariantList &vals = QVariantList());
 	int appendRow(const QVariantList &vals = QVariantList());
 	void removeRow(int ix);
@@ -129,6 +108,10 @@ public:
 	TreeTableRow row(int row_ix) const;
 	void setRow(int row_ix, const TreeTableRow &ttr);
 
+	/// cell value retyped to column type, without creating TreeTableRow
+	QVariant cellValue(int row_ix, int col_ix) const;
+	void setCellValue(int row_ix, int col_ix, const QVariant &val);
+
 	//! @param key_ends_with if true key name is compared using function QFSql::endsWith().
 	/// pokud se vyskytuje agregacni funkce, musi byt okolo jmena fieldu, napr. SUM(cena)
 	QVariant value(const QString &key_name, const QVariant &default_val = QVariant(), bool key_ends_with = true) const;
@@ -136,7 +119,7 @@ public:
 
 	void appendTable(int row_ix, const TreeTable &t);
 
-	QVariant toVariant() const {return m_values;}
+	QVariant toVariant() const;
 
 	QVariant sum(const QString &col_name) const;
 	QVariant sum(int col_index) const;
@@ -159,21 +142,53 @@ public:
 	QByteArray toJson(QJsonDocument::JsonFormat format = QJsonDocument::Indented) const;
 	QString toString(QJsonDocument::JsonFormat format = QJsonDocument::Indented) const;
 private:
-	//QVariant retypeVariant(int col_ix, const QVariant &v) const;
+	void setValues(const QVariant &value);
+	const FieldNameIndex& columnNameIndex() const;
+	/// every mutation has to call this to drop cached QVariant form
+	TreeTableData* mutableData();
+
+	QVariantMap keyvals() const;
+	QVariantList columns() const;
+private:
+	QSharedDataPointer<TreeTableData> d;
+};
 
-	QVariantMap valueMap() const { return m_values.toMap(); }
-	QVariantMap meta() const { return m_values.toMap().value(KEY_META).toMap(); }
+class QFCORE_DECL_EXPORT TreeTableRow
+{
+	friend class TreeTable;
+public:
+	TreeTableRow() {}
+	TreeTableRow(const QVariant &columns, const QVariant &row_data);
 
-	QVariantMap keyvals() const { return m_values.toMap().value(KEY_KEYVALS).toMap(); }
-	void setKeyvals(const QVariantMap &keyvals);
+	bool isValid() const {return m_isValid;}
+	int columnCount() const {return m_columns.count();}
+	int columnIndex(const QString &col_name) const;
+	int columnIndex(const FieldNameIndex::Handle &col_handle) const;
 
-	QVariantList columns() const { return m_values.toMap().value(KEY_COLUMNS).toList(); }
-	void setColumns(const QVariantList &columns);
+	/// row in QVariant form, list of values or map with row, keyvals and tables keys
+	QVariant row() const;
 
-	QVariantList rows() const { return m_values.toMap().value(KEY_ROWS).toList(); }
-	void setRows(const QVariantList &rows);
+	QVariant value(int col_ix) const;
+	QVariant value(const QString &col_or_key_name) const;
+	QVariant value(const FieldNameIndex::Handle &col_handle) const {return value(columnIndex(col_handle));}
+
+	void setValue(int col_ix, const QVariant &val);
+	void setValue(const QString &col_or_key_name, const QVariant &val);
+
+	int tablesCount() const {return m_tables.count();}
+	TreeTable table(int ix = 0) const;
+	TreeTable table(const QString &table_name) const;
+	void appendTable(const TreeTable &t);
 private:
-	QVariant m_values;
+	QVariant retypeVariant(int col_ix, const QVariant &v) const;
+	const FieldNameIndex& columnNameIndex() const;
+private:
+	QVariantList m_columns;
+	mutable FieldNameIndex m_columnNameIndex;
+	QVariantList m_values;
+	QVariantMap m_keyvals;
+	QVector<TreeTable> m_tables;
+	bool m_isValid = false;
 };
 
 }}}
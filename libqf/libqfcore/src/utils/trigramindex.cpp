@@ -0,0 +1,117 @@
+#include "trigramindex.h"
+
+#include "../core/collator.h"
+
+#include <algorithm>
+
+namespace qf {
+namespace core {
+namespace utils {
+
+QByteArray TrigramIndex::foldText(const QString &text)
+{
+	return qf::core::Collator::toAscii7(QLocale::Czech, text, true);
+}
+
+void TrigramIndex::clear()
+{
+	m_texts.clear();
+	m_postings.clear();
+}
+
+QVector<TrigramIndex::Trigram> TrigramIndex::trigrams(const QByteArray &folded_text)
+{
+	QVector<Trigram> ret;
+	const char *p = folded_text.constData();
+	for(int i = 0; i + 3 <= folded_text.size(); i++)
+		ret << trigram(p + i);
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
+}
+
+void TrigramIndex::insert(int id, const QString &text)
+{
+	if(m_texts.contains(id))
+		remove(id);
+	const QByteArray folded = foldText(text);
+	m_texts.insert(id, folded);
+	for(Trigram t : trigrams(folded)) {
+		QVector<int> &ids = m_postings[t];
+		/// ids are inserted mostly in ascending order when index is built
+		if(ids.isEmpty() || ids.last() < id)
+			ids << id;
+		else
+			ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+	}
+}
+
+void TrigramIndex::remove(int id)
+{
+	auto it = m_texts.find(id);
+	if(it == m_texts.end())
+		return;
+	for(Trigram t : trigrams(it.value())) {
+		auto pit = m_postings.find(t);
+		if(pit == m_postings.end())
+			continue;
+		QVector<int> &ids = pit.value();
+		auto iit = std::lower_bound(ids.begin(), ids.end(), id);
+		if(iit != ids.end() && *iit == id)
+			ids.erase(iit);
+		if(ids.isEmpty())
+			m_postings.erase(pit);
+	}
+	m_texts.erase(it);
+}
+
+QVector<int> TrigramIndex::search(const QString &query, int max_count) const
+{
+	QVector<int> ret;
+	const QByteArray folded = foldText(query);
+	if(folded.isEmpty())
+		return ret;
+	if(folded.size() < 3) {
+		for(auto it = m_texts.constBegin(); it != m_texts.constEnd(); ++it) {
+			if(it.value().contains(folded))
+				ret << it.key();
+		}
+		std::sort(ret.begin(), ret.end());
+		if(max_count >= 0 && ret.count() > max_count)
+			ret.resize(max_count);
+		return ret;
+	}
+	/// intersect posting lists starting with the shortest one
+	QVector<const QVector<int>*> lists;
+	for(Trigram t : trigrams(folded)) {
+		auto it = m_postings.constFind(t);
+		if(it == m_postings.constEnd())
+			return ret;
+		lists << &it.value();
+	}
+	std::sort(lists.begin(), lists.end(), [](const QVector<int> *l1, const QVector<int> *l2) {
+		return l1->count() < l2->count();
+	});
+	const QVector<int> &shortest = *lists.first();
+	for(int id : shortest) {
+		bool in_all = true;
+		for(int i = 1; i < lists.count(); i++) {
+			const QVector<int> &ids = *lists[i];
+			if(!std::binary_search(ids.constBegin(), ids.constEnd(), id)) {
+				in_all = false;
+				break;
+			}
+		}
+		if(!in_all)
+			continue;
+		/// trigrams can be found in text in different order than in query
+		if(folded.size() > 3 && !m_texts.value(id).contains(folded))
+			continue;
+		ret << id;
+		if(max_count >= 0 && ret.count() >= max_count)
+			break;
+	}
+	return ret;
+}
+
+}}}
@@ -0,0 +1,50 @@
+#ifndef QF_CORE_UTILS_TRIGRAMINDEX_H
+#define QF_CORE_UTILS_TRIGRAMINDEX_H
+
+#include "../core/coreglobal.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace qf {
+namespace core {
+namespace utils {
+
+/// Substring search index over short texts, like competitor names, registrations and SI numbers.
+/// Texts are folded to lower case ASCII7, every three chars of folded text are stored in posting list of text ids.
+/// Query is answered by intersection of posting lists of query trigrams, candidates are verified by substring match,
+/// so the result is the same as linear scan with QByteArray::contains() on folded texts.
+/// Queries shorter than three chars are answered by linear scan.
+class QFCORE_DECL_EXPORT TrigramIndex
+{
+public:
+	TrigramIndex() {}
+
+	static QByteArray foldText(const QString &text);
+
+	void clear();
+	bool isEmpty() const {return m_texts.isEmpty();}
+	int count() const {return m_texts.count();}
+	bool contains(int id) const {return m_texts.contains(id);}
+
+	/// inserts or replaces text with id
+	void insert(int id, const QString &text);
+	void remove(int id);
+
+	/// returns ids of texts containing query in ascending order, max_count < 0 means all of them
+	QVector<int> search(const QString &query, int max_count = -1) const;
+private:
+	using Trigram = quint32;
+	static Trigram trigram(const char *p) {return (static_cast<quint8>(p[0]) << 16) | (static_cast<quint8>(p[1]) << 8) | static_cast<quint8>(p[2]);}
+	static QVector<Trigram> trigrams(const QByteArray &folded_text);
+private:
+	QHash<int, QByteArray> m_texts;
+	/// trigram -> ascending ids of texts containing it
+	QHash<Trigram, QVector<int>> m_postings;
+};
+
+}}}
+
+#endif // QF_CORE_UTILS_TRIGRAMINDEX_H
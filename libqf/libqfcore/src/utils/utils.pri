@@ -1,6 +1,8 @@
 HEADERS += \
     $$PWD/crypt.h \
     $$PWD/treetable.h \
+    $$PWD/fieldnameindex.h \
+    $$PWD/trigramindex.h \
     $$PWD/table.h \
     $$PWD/csvreader.h \
 	$$PWD/fileutils.h \
@@ -13,6 +15,8 @@ HEADERS += \
 SOURCES += \
     $$PWD/crypt.cpp \
     $$PWD/treetable.cpp \
+    $$PWD/fieldnameindex.cpp \
+    $$PWD/trigramindex.cpp \
     $$PWD/table.cpp \
     $$PWD/csvreader.cpp \
 	$$PWD/fileutils.cpp \
@@ -11,10 +11,38 @@
 //namespace qfm = qf::core::model;
 using namespace qf::qmlwidgets;
 
+namespace {
+/// ASCII7 keys are compared as signed chars, Latin1 letters not folded by toAscii7() sort before 'a'
+/// Collator::compareSortKeys() compares unsigned bytes, so it cannot be used here
+int compareAscii7Keys(const QByteArray &lb, const QByteArray &rb)
+{
+	int lsz = lb.size();
+	int rsz = rb.size();
+	int i;
+	for(i=0; i<lsz && i<rsz; i++) {
+		char lc = lb.at(i);
+		char rc = rb.at(i);
+		if(lc == rc)
+			continue;
+		if (lc < rc)
+			return -1;
+		return 1;
+	}
+	if(lsz == rsz)
+		return 0;
+	if(lsz < rsz)
+		return -1;
+	return 1;
+}
+}
+
 TableViewProxyModel::TableViewProxyModel(QObject *parent)
 	: Super(parent)
 {
 	setSortRole(qf::core::model::TableModel::SortRole);
+	/// cached keys are validated against current value, cache is dropped just to release memory
+	connect(this, &TableViewProxyModel::sourceModelChanged, this, &TableViewProxyModel::clearSortKeyCache);
+	connect(this, &TableViewProxyModel::modelReset, this, &TableViewProxyModel::clearSortKeyCache);
 }
 
 TableViewProxyModel::~TableViewProxyModel()
@@ -22,6 +50,29 @@ TableViewProxyModel::~TableViewProxyModel()
 
 }
 
+void TableViewProxyModel::setSourceModel(QAbstractItemModel *source_model)
+{
+	for(const QMetaObject::Connection &c : m_sourceModelConnections)
+		disconnect(c);
+	m_sourceModelConnections.clear();
+	clearRowFilterCache();
+	if(source_model) {
+		/// connect before QSortFilterProxyModel does, so filterAcceptsRow() called from its handlers sees updated cache
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &top_left, const QModelIndex &bottom_right) {
+			if(!top_left.parent().isValid())
+				invalidateRowFilterCache(top_left.row(), bottom_right.row());
+		});
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::rowsInserted, this, &TableViewProxyModel::onSourceRowsInserted);
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::rowsRemoved, this, &TableViewProxyModel::onSourceRowsRemoved);
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::rowsMoved, this, &TableViewProxyModel::clearRowFilterCache);
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::columnsInserted, this, &TableViewProxyModel::clearRowFilterCache);
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::columnsRemoved, this, &TableViewProxyModel::clearRowFilterCache);
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::layoutChanged, this, &TableViewProxyModel::clearRowFilterCache);
+		m_sourceModelConnections << connect(source_model, &QAbstractItemModel::modelReset, this, &TableViewProxyModel::clearRowFilterCache);
+	}
+	Super::setSourceModel(source_model);
+}
+
 void TableViewProxyModel::setRowFilterString(const QString &s)
 {
 	qfLogFuncFrame() << s;
@@ -29,6 +80,12 @@ void TableViewProxyModel::setRowFilterString(const QString &s)
 	qfDebug() << ba;
 	if(ba == m_rowFilterString)
 		return;
+	/// text containing new filter string contains the previous one as well
+	m_isFilterNarrowing = !m_rowFilterString.isEmpty() && ba.contains(m_rowFilterString);
+	if(!m_isFilterNarrowing) {
+		for(RowFilterCache &c : m_rowFilterCache)
+			c.accepted = RowFilterCache::Unknown;
+	}
 	m_rowFilterString = ba;
 	invalidateFilter();
 }
@@ -52,6 +109,7 @@ void TableViewProxyModel::sort()
 
 void TableViewProxyModel::sort(int column, Qt::SortOrder order)
 {
+	clearSortKeyCache();
 	m_sortColumns.clear();
 	m_sortColumns << column;
 	m_sortOrder = order;
@@ -90,13 +148,92 @@ bool TableViewProxyModel::filterAcceptsRow(int source_row, const QModelIndex &so
 {
 	if(m_rowFilterString.isEmpty())
 		return true;
-	QAbstractItemModel *sm = sourceModel();
-	for(int i=0; i<sm->columnCount(); i++) {
-		QModelIndex ix = sm->index(source_row, i, source_parent);
-		if(dataMatchFilter(sm->data(ix)))
-			return true;
+	if(source_parent.isValid()) {
+		QAbstractItemModel *sm = sourceModel();
+		for(int i=0; i<sm->columnCount(); i++) {
+			QModelIndex ix = sm->index(source_row, i, source_parent);
+			if(dataMatchFilter(sm->data(ix)))
+				return true;
+		}
+		return false;
+	}
+	const QByteArray &text = rowFilterText(source_row);
+	RowFilterCache &c = m_rowFilterCache[source_row];
+	if(m_isFilterNarrowing && c.accepted == RowFilterCache::Rejected)
+		return false;
+	bool ret = text.contains(m_rowFilterString);
+	c.accepted = ret? RowFilterCache::Accepted: RowFilterCache::Rejected;
+	return ret;
+}
+
+const QByteArray &TableViewProxyModel::rowFilterText(int source_row) const
+{
+	if(source_row >= m_rowFilterCache.count())
+		m_rowFilterCache.resize(qMax(source_row + 1, sourceModel()->rowCount()));
+	RowFilterCache &c = m_rowFilterCache[source_row];
+	/// null text means not computed yet
+	if(c.text.isNull()) {
+		QAbstractItemModel *sm = sourceModel();
+		QByteArray text("", 0);
+		for(int i=0; i<sm->columnCount(); i++) {
+			if(i > 0)
+				text.append('\0');
+			text.append(qf::core::Collator::toAscii7(QLocale::Czech, sm->data(sm->index(source_row, i)).toString(), true));
+		}
+		c.text = text;
+	}
+	return c.text;
+}
+
+void TableViewProxyModel::clearRowFilterCache()
+{
+	m_rowFilterCache.clear();
+	m_isFilterNarrowing = false;
+}
+
+void TableViewProxyModel::invalidateRowFilterCache(int first_row, int last_row)
+{
+	last_row = qMin(last_row, m_rowFilterCache.count() - 1);
+	for(int i = qMax(first_row, 0); i <= last_row; i++)
+		m_rowFilterCache[i] = RowFilterCache();
+}
+
+void TableViewProxyModel::onSourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+	if(parent.isValid())
+		return;
+	if(first < m_rowFilterCache.count())
+		m_rowFilterCache.insert(first, last - first + 1, RowFilterCache());
+}
+
+void TableViewProxyModel::onSourceRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+	if(parent.isValid())
+		return;
+	last = qMin(last, m_rowFilterCache.count() - 1);
+	if(first <= last)
+		m_rowFilterCache.remove(first, last - first + 1);
+}
+
+QByteArray TableViewProxyModel::sortKey(int source_row, int column, const QString &s) const
+{
+	QVector<SortKey> &column_keys = m_sortKeyCache[column];
+	if(source_row >= column_keys.count())
+		column_keys.resize(qMax(source_row + 1, sourceModel()? sourceModel()->rowCount(): 0));
+	SortKey &k = column_keys[source_row];
+	/// null key means not computed yet, key of empty string is empty but not null
+	if(k.key.isNull() || k.text != s) {
+		k.text = s;
+		k.key = qf::core::Collator::toAscii7(QLocale::Czech, s, true);
+		if(k.key.isNull())
+			k.key = QByteArray("", 0);
 	}
-	return false;
+	return k.key;
+}
+
+void TableViewProxyModel::clearSortKeyCache()
+{
+	m_sortKeyCache.clear();
 }
 
 int TableViewProxyModel::variantCmp(const QVariant &left, const QVariant &right) const
@@ -104,23 +241,7 @@ int TableViewProxyModel::variantCmp(const QVariant &left, const QVariant &right)
 	if(left.userType() == qMetaTypeId<QString>() && right.userType() == qMetaTypeId<QString>()) {
 		const QByteArray lb = qf::core::Collator::toAscii7(QLocale::Czech, left.toString(), true);
 		const QByteArray rb = qf::core::Collator::toAscii7(QLocale::Czech, right.toString(), true);
-		int lsz = lb.size();
-		int rsz = rb.size();
-		int i;
-		for(i=0; i<lsz && i<rsz; i++) {
-			char lc = lb.at(i);
-			char rc = rb.at(i);
-			if(lc == rc)
-				continue;
-			if (lc < rc)
-				return -1;
-			return 1;
-		}
-		if(lsz == rsz)
-			return 0;
-		if(lsz < rsz)
-			return -1;
-		return 1;
+		return compareAscii7Keys(lb, rb);
 	}
 	if(!left.isValid() && !right.isValid())
 		return 0;
@@ -190,7 +311,13 @@ bool TableViewProxyModel::lessThan(const QModelIndex &left, const QModelIndex &r
 			int column = m_sortColumns[i];
 			QVariant lv = source_model->data(left.sibling(left.row(), column), sortRole()); /// comparing display role is not working for NULL values
 			QVariant rv = source_model->data(right.sibling(right.row(), column), sortRole());
-			int cmp = variantCmp(lv, rv);
+			int cmp;
+			if(lv.userType() == qMetaTypeId<QString>() && rv.userType() == qMetaTypeId<QString>()) {
+				cmp = compareAscii7Keys(sortKey(left.row(), column, lv.toString()), sortKey(right.row(), column, rv.toString()));
+			}
+			else {
+				cmp = variantCmp(lv, rv);
+			}
 			//qfInfo() << "\tcol:" << column << lv.toString() << "vs" << rv.toString() << "->" << cmp;
 			if(cmp == 0)
 				continue;
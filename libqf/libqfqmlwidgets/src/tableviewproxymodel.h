@@ -2,6 +2,8 @@
 #define QF_QMLWIDGETS_TABLEVIEWPROXYMODEL_H
 
 #include <QSortFilterProxyModel>
+#include <QHash>
+#include <QVector>
 
 namespace qf {
 namespace qmlwidgets {
@@ -15,6 +17,8 @@ public:
 	TableViewProxyModel(QObject *parent = nullptr);
 	~TableViewProxyModel() Q_DECL_OVERRIDE;
 public:
+	void setSourceModel(QAbstractItemModel *source_model) Q_DECL_OVERRIDE;
+
 	Q_SLOT void setRowFilterString(const QString &s);
 	QString rowFilterString() const;
 	bool isIdle() const;
@@ -30,10 +34,37 @@ protected:
 	int variantCmp(const QVariant &left, const QVariant &right) const;
 private:
 	bool dataMatchFilter(const QVariant &d) const;
+	/// ASCII7 text of all the source row columns separated by '\0', it is cached until row data are changed
+	const QByteArray& rowFilterText(int source_row) const;
+	void clearRowFilterCache();
+	void invalidateRowFilterCache(int first_row, int last_row);
+	void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+	void onSourceRowsRemoved(const QModelIndex &parent, int first, int last);
+	/// ASCII7 sort key of source model string value, key is computed once and reused while the value is unchanged
+	QByteArray sortKey(int source_row, int column, const QString &s) const;
+	void clearSortKeyCache();
 private:
 	QByteArray m_rowFilterString;
 	QVector<int> m_sortColumns;
 	Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+	struct SortKey
+	{
+		QString text;
+		QByteArray key;
+	};
+	/// column -> source row -> key
+	mutable QHash<int, QVector<SortKey>> m_sortKeyCache;
+	struct RowFilterCache
+	{
+		enum {Unknown = -1, Rejected = 0, Accepted = 1};
+		QByteArray text;
+		qint8 accepted = Unknown; //< result for current filter string
+	};
+	/// source row -> cache, rows must be shifted or invalidated before QSortFilterProxyModel sees source model change
+	mutable QVector<RowFilterCache> m_rowFilterCache;
+	/// new filter string extends previous one, rows rejected by previous one cannot match and are not re-checked
+	bool m_isFilterNarrowing = false;
+	QList<QMetaObject::Connection> m_sourceModelConnections;
 };
 
 }}
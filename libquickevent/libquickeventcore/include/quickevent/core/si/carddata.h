@@ -0,0 +1 @@
+#include "../../../../src/si/carddata.h"
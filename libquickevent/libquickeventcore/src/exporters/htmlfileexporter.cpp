@@ -39,19 +39,19 @@ qf::core::sql::Query HtmlFileExporter::execSql(const QString &query_str)
 	return q;
 }
 
-void HtmlFileExporter::generateHtml()
+bool HtmlFileExporter::initExport()
 {
 	QDir html_dir(outDir());
 	if(!html_dir.exists()) {
 		qfInfo() << "creating HTML dir:" << outDir();
 		if(!QDir().mkpath(outDir())) {
 			qfError() << "Cannot create out dir:" << outDir();
-			return;
+			return false;
 		}
 		html_dir = QDir(outDir());
 		if(!html_dir.exists()) {
 			qfError() << "Author even doesn't know, how to use QDir API.";
-			return;
+			return false;
 		}
 	}
 	QVariantMap event_info = eventInfo();
@@ -67,13 +67,25 @@ void HtmlFileExporter::generateHtml()
 		qfInfo() << "Setting stage to:" << curr_stage;
 		setCurrentStage(curr_stage);
 	}
+	return true;
+}
 
-	QVariantList html_body = QVariantList() << QStringLiteral("body");
-	html_body.insert(html_body.length(), QVariantList() << QStringLiteral("body"));
-
+void HtmlFileExporter::generateHtml()
+{
+	if(!initExport())
+		return;
 	exportClasses();
 }
 
+void HtmlFileExporter::generateClassesHtml(const QList<int> &class_ids)
+{
+	if(class_ids.isEmpty())
+		return;
+	if(!initExport())
+		return;
+	exportClasses(class_ids);
+}
+
 QString HtmlFileExporter::normalizeClassName(const QString class_name)
 {
 	QString ret = class_name;
@@ -81,7 +93,7 @@ QString HtmlFileExporter::normalizeClassName(const QString class_name)
 	return QString::fromUtf8(qf::core::Collator::toAscii7(QLocale::Czech, ret, true));
 }
 
-void HtmlFileExporter::exportClasses()
+void HtmlFileExporter::exportClasses(const QList<int> &class_ids)
 {
 	QString where;
 	if(!classesLike().isEmpty())
@@ -98,22 +110,25 @@ void HtmlFileExporter::exportClasses()
 	qfDebug() << "loading clases:" << qs;
 
 	QVariantList class_links;
-	QList<int> class_ids;
+	QList<int> export_class_ids;
 	QSqlQuery q = execSql(qs);
 	while(q.next()) {
 		int class_id = q.value("id").toInt();
-		class_ids << class_id;
+		/// links to all the classes are needed even if some of them are exported only
+		if(class_ids.isEmpty() || class_ids.contains(class_id))
+			export_class_ids << class_id;
 		QString class_name = q.value("name").toString();
 		QString class_name_ascii7 = normalizeClassName(class_name);
 
 		class_links.insert(class_links.length(), QVariantList{"a", QVariantMap{{"href", class_name_ascii7 + ".html"}}, class_name});
 	}
-	for(int class_id : class_ids) {
+	for(int class_id : export_class_ids) {
 		exportClass(class_id, class_links);
 	}
+	if(!class_ids.isEmpty())
+		return;
 
 	QVariantMap event_info = eventInfo();
-	QDir html_dir(outDir());
 	{
 		QString title = tr("E%1 %2").arg(currentStage()).arg(reportTitle());
 		QVariantList html_body = QVariantList() << QStringLiteral("body");
@@ -126,16 +141,25 @@ void HtmlFileExporter::exportClasses()
 		opts.setDocumentTitle(title);
 		QString html = qf::core::utils::HtmlUtils::fromHtmlList(html_body, opts);
 		QString sub_dir = QString("E%1/%2").arg(currentStage()).arg(reportDir());
-		html_dir.mkpath(sub_dir);
-		QFile f(html_dir.absolutePath() + '/' + sub_dir + "/index.html");
-		qfInfo() << "Generating:" << f.fileName();
-		if(f.open(QFile::WriteOnly)) {
-			f.write(html.toUtf8());
-		}
-		else {
-			qfError() << "Cannot open file" << f.fileName() + "for writing.";
-		}
+		writeHtmlFile(sub_dir, QStringLiteral("index.html"), html);
+	}
+}
+
+void HtmlFileExporter::writeHtmlFile(const QString &sub_dir, const QString &file_name, const QString &html)
+{
+	QDir html_dir(outDir());
+	html_dir.mkpath(sub_dir);
+	QString file_path = sub_dir + '/' + file_name;
+	QByteArray content = html.toUtf8();
+	QFile f(html_dir.absolutePath() + '/' + file_path);
+	qfInfo() << "Generating:" << f.fileName();
+	if(f.open(QFile::WriteOnly)) {
+		f.write(content);
+	}
+	else {
+		qfError() << "Cannot open file" << f.fileName() + "for writing.";
 	}
+	emit htmlFileGenerated(file_path, content);
 }
 
 }}}
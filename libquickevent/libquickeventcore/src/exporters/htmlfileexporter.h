@@ -28,13 +28,21 @@ public:
 	explicit HtmlFileExporter(QObject *parent = nullptr);
 	void setSqlConnection(const qf::core::sql::Connection &c) {m_sqlConnection = c;}
 	void generateHtml();
+	/// regenerates pages of classes class_ids only, index.html is left as it is
+	void generateClassesHtml(const QList<int> &class_ids);
+
+	/// file_path is relative to outDir, content is what was written to the file
+	Q_SIGNAL void htmlFileGenerated(const QString &file_path, const QByteArray &content);
 protected:
 	qf::core::sql::Connection sqlConnection() {return m_sqlConnection;}
 	qf::core::sql::Query execSql(const QString &query_str);
 	QVariantMap eventInfo();
-	void exportClasses();
+	bool initExport();
+	/// empty class_ids means all classes, index.html is written in this case only
+	void exportClasses(const QList<int> &class_ids = QList<int>());
 	virtual void exportClass(int class_id, const QVariantList &class_links) = 0;
 	QString normalizeClassName(const QString class_name);
+	void writeHtmlFile(const QString &sub_dir, const QString &file_name, const QString &html);
 private:
 	QVariantMap m_eventInfo;
 	qf::core::sql::Connection m_sqlConnection;
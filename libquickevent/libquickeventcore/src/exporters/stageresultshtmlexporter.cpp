@@ -109,16 +109,7 @@ void StageResultsHtmlExporter::exportClass(int class_id, const QVariantList &cla
 		opts.setDocumentTitle(tr("Results %1").arg(q.value("classes.name").toString()));
 		QString html = qf::core::utils::HtmlUtils::fromHtmlList(html_body, opts);
 		QString sub_dir = QString("E%1/results").arg(currentStage());
-		QDir html_dir(outDir());
-		html_dir.mkpath(sub_dir);
-		QFile f(html_dir.absolutePath() + '/' + sub_dir + '/' + normalizeClassName(class_name) + ".html");
-		qfInfo() << "Generating:" << f.fileName();
-		if(f.open(QFile::WriteOnly)) {
-			f.write(html.toUtf8());
-		}
-		else {
-			qfError() << "Cannot open file" << f.fileName() + "for writing.";
-		}
+		writeHtmlFile(sub_dir, normalizeClassName(class_name) + ".html", html);
 	}
 }
 
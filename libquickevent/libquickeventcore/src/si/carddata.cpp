@@ -0,0 +1,216 @@
+#include "carddata.h"
+#include "checkedcard.h"
+#include "readcard.h"
+#include "../codedef.h"
+
+#include <siut/sicard.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSqlRecord>
+
+namespace quickevent {
+namespace core {
+namespace si {
+
+//=================================================
+//             ReadCardData
+//=================================================
+ReadCardData ReadCardData::fromSICard(const siut::SICard &card)
+{
+	ReadCardData ret;
+	ret.stationNumber = card.stationNumber();
+	ret.cardNumber = card.cardNumber();
+	ret.checkTime = card.checkTime();
+	ret.startTime = card.startTime();
+	ret.finishTime = card.finishTime();
+	ret.finishTimeMs = card.finishTimeMs();
+	const QVariantList punches = card.punches();
+	ret.punches.reserve(punches.count());
+	for(const QVariant &v : punches) {
+		const QVariantMap m = v.toMap();
+		ReadPunchData p;
+		p.code = m.value(QStringLiteral("code")).toInt();
+		p.time = m.value(QStringLiteral("time")).toInt();
+		p.msec = m.value(QStringLiteral("msec")).toInt();
+		ret.punches << p;
+	}
+	return ret;
+}
+
+ReadCardData ReadCardData::fromReadCard(const ReadCard &read_card)
+{
+	ReadCardData ret;
+	ret.runId = read_card.runId();
+	ret.stationNumber = read_card.stationNumber();
+	ret.cardNumber = read_card.cardNumber();
+	ret.checkTime = read_card.checkTime();
+	ret.startTime = read_card.startTime();
+	ret.finishTime = read_card.finishTime();
+	ret.finishTimeMs = read_card.finishTimeMs();
+	ret.runIdAssignError = read_card.runIdAssignError();
+	const QVariantList punches = read_card.punches();
+	ret.punches.reserve(punches.count());
+	for(const QVariant &v : punches) {
+		ReadPunch rp(v.toMap());
+		ReadPunchData p;
+		p.code = rp.code();
+		p.time = rp.time();
+		p.msec = rp.msec();
+		ret.punches << p;
+	}
+	return ret;
+}
+
+ReadCardData ReadCardData::fromSqlRecord(const QSqlRecord &rec)
+{
+	ReadCardData ret;
+	ret.runId = rec.value(QStringLiteral("runId")).toInt();
+	ret.stationNumber = rec.value(QStringLiteral("stationNumber")).toInt();
+	ret.cardNumber = rec.value(QStringLiteral("siId")).toInt();
+	ret.checkTime = rec.value(QStringLiteral("checkTime")).toInt();
+	ret.startTime = rec.value(QStringLiteral("startTime")).toInt();
+	ret.finishTime = rec.value(QStringLiteral("finishTime")).toInt();
+	auto jsd = QJsonDocument::fromJson(rec.value(QStringLiteral("punches")).toString().toUtf8());
+	const QJsonArray punches = jsd.array();
+	ret.punches.reserve(punches.count());
+	for(const QJsonValue &v : punches) {
+		const QJsonArray arr = v.toArray();
+		ReadPunchData p;
+		p.code = arr.at(0).toInt();
+		p.time = arr.at(1).toInt();
+		p.msec = arr.at(2).toInt();
+		ret.punches << p;
+	}
+	return ret;
+}
+
+ReadCard ReadCardData::toReadCard() const
+{
+	ReadCard ret;
+	ret.setRunId(runId);
+	ret.setStationNumber(stationNumber);
+	ret.setCardNumber(cardNumber);
+	ret.setCheckTime(checkTime);
+	ret.setStartTime(startTime);
+	ret.setFinishTime(finishTime);
+	ret.setFinishTimeMs(finishTimeMs);
+	if(!runIdAssignError.isEmpty())
+		ret.setRunIdAssignError(runIdAssignError);
+	QVariantList lst;
+	lst.reserve(punches.count());
+	for(const ReadPunchData &p : punches) {
+		ReadPunch rp;
+		rp.setCode(p.code);
+		rp.setTime(p.time);
+		rp.setMsec(p.msec);
+		lst << rp;
+	}
+	ret.setPunches(lst);
+	return ret;
+}
+
+QString ReadCardData::punchesToJsonString() const
+{
+	QString ret;
+	ret.reserve(punches.count() * 16 + 2);
+	ret += '[';
+	for (int i = 0; i < punches.count(); ++i) {
+		const ReadPunchData &p = punches[i];
+		if(i > 0)
+			ret += QLatin1String(", ");
+		ret += '[';
+		ret += QString::number(p.code);
+		ret += QLatin1String(", ");
+		ret += QString::number(p.time);
+		ret += QLatin1String(", ");
+		ret += QString::number(p.msec);
+		ret += ']';
+	}
+	ret += ']';
+	return ret;
+}
+
+QString ReadCardData::toString() const
+{
+	return toReadCard().toString();
+}
+
+//=================================================
+//             CheckedPunchData
+//=================================================
+CheckedPunchData CheckedPunchData::fromCodeDef(const CodeDef &cd)
+{
+	CheckedPunchData ret;
+	ret.code = cd.code();
+	ret.distance = cd.distance();
+	return ret;
+}
+
+//=================================================
+//             CheckedCardData
+//=================================================
+CheckedCardData CheckedCardData::fromCheckedCard(const CheckedCard &checked_card)
+{
+	CheckedCardData ret;
+	ret.runId = checked_card.runId();
+	ret.courseId = checked_card.courseId();
+	ret.stageStartTimeMs = checked_card.stageStartTimeMs();
+	ret.hasCheckTime = checked_card.checkTimeMs_isset();
+	ret.checkTimeMs = checked_card.checkTimeMs();
+	ret.startTimeMs = checked_card.startTimeMs();
+	ret.hasFinishTime = checked_card.finishTimeMs_isset();
+	ret.finishTimeMs = checked_card.finishTimeMs();
+	ret.cardNumber = checked_card.cardNumber();
+	ret.badCheck = checked_card.isBadCheck();
+	ret.misPunch = checked_card.isMisPunch();
+	const QVariantList punches = checked_card.punches();
+	ret.punches.reserve(punches.count());
+	for(const QVariant &v : punches) {
+		CheckedPunch cp(v.toMap());
+		CheckedPunchData p;
+		p.code = cp.code();
+		p.stpTimeMs = cp.stpTimeMs();
+		p.lapTimeMs = cp.lapTimeMs();
+		p.distance = cp.distance();
+		ret.punches << p;
+	}
+	return ret;
+}
+
+CheckedCard CheckedCardData::toCheckedCard() const
+{
+	CheckedCard ret;
+	ret.setRunId(runId);
+	ret.setCardNumber(cardNumber);
+	if(courseId == 0)
+		return ret;
+	ret.setCourseId(courseId);
+	ret.setStageStartTimeMs(stageStartTimeMs);
+	if(hasCheckTime)
+		ret.setCheckTimeMs(checkTimeMs);
+	ret.setStartTimeMs(startTimeMs);
+	if(hasFinishTime)
+		ret.setFinishTimeMs(finishTimeMs);
+	ret.setBadCheck(badCheck);
+	ret.setMisPunch(misPunch);
+	QVariantList lst;
+	lst.reserve(punches.count());
+	for(const CheckedPunchData &p : punches) {
+		CheckedPunch cp;
+		cp.setCode(p.code);
+		cp.setStpTimeMs(p.stpTimeMs);
+		cp.setLapTimeMs(p.lapTimeMs);
+		cp.setDistance(p.distance);
+		lst << cp;
+	}
+	ret.setPunches(lst);
+	return ret;
+}
+
+QString CheckedCardData::toString() const
+{
+	return toCheckedCard().toString();
+}
+
+}}}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../quickeventcoreglobal.h"
+
+#include <QString>
+#include <QVector>
+
+class QSqlRecord;
+
+namespace siut { class SICard; }
+
+namespace quickevent {
+namespace core {
+
+class CodeDef;
+
+namespace si {
+
+class ReadCard;
+class CheckedCard;
+
+/// Flat value types used on card read-out path.
+/// ReadCard, CheckedCard and friends are QVariantMaps, what is handy for QML and db events,
+/// but every field access is a string keyed lookup plus QVariant conversion.
+/// Card is read, checked and saved using these types, maps are created only on QML/receipts boundary.
+
+struct QUICKEVENTCORE_DECL_EXPORT ReadPunchData
+{
+	int code = 0;
+	int time = 0; //< SI time in sec, 12H format
+	int msec = 0;
+
+	int timeMs() const {return time * 1000 + msec;}
+};
+
+struct QUICKEVENTCORE_DECL_EXPORT ReadCardData
+{
+	static constexpr int INVALID_SI_TIME = 0xEEEE;
+
+	int runId = 0;
+	int stationNumber = 0;
+	int cardNumber = 0;
+	int checkTime = 0;
+	int startTime = 0;
+	int finishTime = 0;
+	int finishTimeMs = 0;
+	QVector<ReadPunchData> punches;
+	QString runIdAssignError;
+
+	bool isEmpty() const {return cardNumber == 0 && punches.isEmpty();}
+
+	static ReadCardData fromSICard(const siut::SICard &card);
+	static ReadCardData fromReadCard(const ReadCard &read_card);
+	/// cards table record
+	static ReadCardData fromSqlRecord(const QSqlRecord &rec);
+	ReadCard toReadCard() const;
+
+	/// punches in cards.punches column format [[code, time, msec], ...]
+	QString punchesToJsonString() const;
+	QString toString() const;
+};
+
+struct QUICKEVENTCORE_DECL_EXPORT CheckedPunchData
+{
+	int code = 0;
+	int stpTimeMs = 0;
+	int lapTimeMs = 0;
+	int distance = 0;
+
+	static CheckedPunchData fromCodeDef(const quickevent::core::CodeDef &cd);
+};
+
+struct QUICKEVENTCORE_DECL_EXPORT CheckedCardData
+{
+	int runId = 0;
+	int courseId = 0;
+	int stageStartTimeMs = 0; //< stage start till midnight
+	int checkTimeMs = 0; //< check time till stage start
+	int startTimeMs = 0; //< start time till stage start
+	int finishTimeMs = 0; //< finish time till stage start
+	int cardNumber = 0;
+	bool badCheck = false;
+	bool misPunch = false;
+	bool hasCheckTime = false;
+	bool hasFinishTime = false;
+	/// course punches including finish, see CheckedCard::punches()
+	QVector<CheckedPunchData> punches;
+
+	int timeMs() const {return punches.isEmpty()? 0: punches.last().stpTimeMs;}
+	bool isOk() const {return !badCheck && !misPunch;}
+
+	static CheckedCardData fromCheckedCard(const CheckedCard &checked_card);
+	/// unchecked card (without course) exports runId and cardNumber only, the same like CheckedCard does
+	CheckedCard toCheckedCard() const;
+	QString toString() const;
+};
+
+}}}
@@ -4,6 +4,7 @@ SOURCES += \
     $$PWD/checkedcard.cpp \
     $$PWD/checkedpunch.cpp \
     $$PWD/readcard.cpp \
+    $$PWD/carddata.cpp \
 
 HEADERS  += \
     $$PWD/siid.h \
@@ -11,6 +12,7 @@ HEADERS  += \
     $$PWD/checkedcard.h \
     $$PWD/checkedpunch.h \
     $$PWD/readcard.h \
+    $$PWD/carddata.h \
 
 FORMS += \
 
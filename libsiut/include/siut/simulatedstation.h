@@ -0,0 +1 @@
+#include "../../src/device/simulatedstation.h"
@@ -6,6 +6,8 @@ extern "C" {
 #endif
 
 unsigned int crc(unsigned int uiCount, unsigned char *pucDat);
+/// table driven crc()
+unsigned int crc529(unsigned int uiCount, const unsigned char *pucDat);
 
 #ifdef __cplusplus
 }
@@ -4,10 +4,12 @@ HEADERS  +=     \
 	$$PWD/sidevicedriver.h     \
 	$$PWD/commport.h  \
 	$$PWD/sitask.h    \
+	$$PWD/simulatedstation.h    \
 
 SOURCES +=     \
 	$$PWD/sidevicedriver.cpp     \
 	$$PWD/commport.cpp    \
 	$$PWD/sitask.cpp    \
+	$$PWD/simulatedstation.cpp    \
 	$$PWD/crc529.c    \
 
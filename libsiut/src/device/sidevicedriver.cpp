@@ -12,10 +12,13 @@
 
 #include <qf/core/log.h>
 
+#include <QScopedValueRollback>
 #include <QTimer>
 #include <QSettings>
 #include <QSerialPortInfo>
 
+#include <cstring>
+
 namespace siut {
 
 //=================================================
@@ -24,6 +27,7 @@ namespace siut {
 DeviceDriver::DeviceDriver(QObject *parent)
 	: Super(parent)
 {
+	m_rxBuffer.resize(4096);
 	//NecroLog::checkLogLevelMetaTypeRegistered();
 }
 
@@ -55,11 +59,16 @@ void DeviceDriver::processSIMessageData(const SIMessageData &data)
 {
 	qfLogFuncFrame();
 	qfDebug() << data.toString();
+	SIMessageData::Command cmd = data.command();
+	if(m_transmitRecordsEnabled && cmd == SIMessageData::Command::TransmitRecord) {
+		/// autosend only, it is never response to the task command
+		processTransmitRecord(data);
+		return;
+	}
 	if(m_taskInProcess) {
 		m_taskInProcess->onSiMessageReceived(data);
 		return;
 	}
-	SIMessageData::Command cmd = data.command();
 	switch(cmd) {
 	case SIMessageData::Command::SICardRemoved: {
 		qfInfo() << "SICardRemoved";
@@ -100,6 +109,35 @@ void DeviceDriver::processSIMessageData(const SIMessageData &data)
 	}
 }
 
+void DeviceDriver::processTransmitRecord(const SIMessageData &msg)
+{
+	/// STX, CMD, LEN, CN1, CN0, SI3, SI2, SI1, SI0, TD, TH, TL, TSS, MEM2, MEM1, MEM0, CRC1, CRC0, ETX
+	const QByteArray &data = msg.data();
+	if(data.size() < 16) {
+		qfError() << "Invalid transmit record received, size:" << data.size();
+		return;
+	}
+	int card_number = (int)SIPunch::getUnsigned(data, 6, 3);
+	if(card_number < 500000) {
+		/// SI5 card number is CS * 100000 + 16 bit number
+		int cs = (uint8_t)data[6];
+		card_number = (int)SIPunch::getUnsigned(data, 7, 2);
+		if(cs > 1)
+			card_number += 100000 * cs;
+	}
+	uint8_t td = (uint8_t)data[9];
+	SIPunch punch;
+	punch.setCardNumber(card_number);
+	punch.setCode((int)SIPunch::getUnsigned(data, 3, 2));
+	punch.setTime((int)SIPunch::getUnsigned(data, 10, 2));
+	punch.setMsec((uint8_t)data[12] * 1000 / 256);
+	punch.setPmFlag(td & 1);
+	punch.setDayOfWeek((td & 0x0e) >> 1);
+	punch.setWeekCnt((td & 0x30) >> 4);
+	qfInfo() << "TransmitRecord, SI:" << card_number << "code:" << punch.code() << "time:" << punch.time();
+	emit siTaskFinished(static_cast<int>(SiTask::Type::Punch), punch);
+}
+
 namespace
 {
 static const char STX = 0x02;
@@ -112,44 +150,93 @@ static const char NAK = 0x15;
 void DeviceDriver::processData(const QByteArray &data)
 {
 	qfLogFuncFrame() << "\n" << SIMessageData::dumpData(data, 16);
-	f_rxData.append(data);
-	while(f_rxData.size() > 3) {
-		int stx_pos = f_rxData.indexOf(STX);
-		if(stx_pos > 0)
-			qfWarning() << tr("Garbage received, stripping %1 characters from beginning of buffer").arg(stx_pos);
+	if(m_isProcessingData) {
+		/// event loop was entered while processing message, rx buffer cannot be touched now
+		m_rxPending.append(data);
+		return;
+	}
+	QScopedValueRollback<bool> processing_guard(m_isProcessingData, true);
+	appendRxData(data);
+	processRxData();
+	while(!m_rxPending.isEmpty()) {
+		QByteArray pending = m_rxPending;
+		m_rxPending.clear();
+		appendRxData(pending);
+		processRxData();
+	}
+}
+
+void DeviceDriver::appendRxData(const QByteArray &data)
+{
+	if(m_rxEnd + data.size() > m_rxBuffer.size()) {
+		int unprocessed_len = m_rxEnd - m_rxBegin;
+		if(m_rxBegin > 0 && unprocessed_len > 0)
+			memmove(m_rxBuffer.data(), m_rxBuffer.constData() + m_rxBegin, static_cast<size_t>(unprocessed_len));
+		m_rxBegin = 0;
+		m_rxEnd = unprocessed_len;
+		if(m_rxEnd + data.size() > m_rxBuffer.size())
+			m_rxBuffer.resize(qMax(2 * m_rxBuffer.size(), m_rxEnd + data.size()));
+	}
+	memcpy(m_rxBuffer.data() + m_rxEnd, data.constData(), static_cast<size_t>(data.size()));
+	m_rxEnd += data.size();
+}
+
+void DeviceDriver::processRxData()
+{
+	const char *buff = m_rxBuffer.constData();
+	while(m_rxEnd - m_rxBegin > 3) {
+		const char *stx = static_cast<const char*>(memchr(buff + m_rxBegin, STX, static_cast<size_t>(m_rxEnd - m_rxBegin)));
+		if(!stx) {
+			qfWarning() << tr("Garbage received, stripping %1 characters from beginning of buffer").arg(m_rxEnd - m_rxBegin);
+			m_rxBegin = m_rxEnd = 0;
+			return;
+		}
+		int stx_pos = static_cast<int>(stx - buff);
+		if(stx_pos > m_rxBegin)
+			qfWarning() << tr("Garbage received, stripping %1 characters from beginning of buffer").arg(stx_pos - m_rxBegin);
 		// remove multiple STX, this can happen
-		while(stx_pos < f_rxData.size()-1 && f_rxData[stx_pos+1] == STX)
+		while(stx_pos < m_rxEnd - 1 && buff[stx_pos + 1] == STX)
 			stx_pos++;
-		if(stx_pos > 0) {
-			f_rxData = f_rxData.mid(stx_pos);
-			stx_pos = 0;
-		}
+		m_rxBegin = stx_pos;
 		// STX,CMD,LEN, data, CRC1,CRC0,ETX/NAK
-		if(f_rxData.size() < 3) // STX,CMD,LEN
+		if(m_rxEnd - m_rxBegin < 3) // STX,CMD,LEN
 			return;
-		int len = (uint8_t)f_rxData[2];
-		len += 3 + 3;
-		if(f_rxData.size() < len)
+		const uint8_t *frame = reinterpret_cast<const uint8_t*>(buff + m_rxBegin);
+		int data_len = frame[2];
+		int len = data_len + 3 + 3;
+		if(m_rxEnd - m_rxBegin < len)
 			return;
-		uint8_t etx = (uint8_t)f_rxData[len-1];
+		uint8_t etx = frame[len-1];
 		if(etx == NAK) {
 			emitDriverInfo(NecroLog::Level::Error, tr("NAK received"));
 		}
 		else if(etx == ETX) {
-			QByteArray data = f_rxData.mid(0, len);
-			uint8_t cmd = (uint8_t)data[1];
+			uint8_t cmd = frame[1];
 			if(cmd < 0x80) {
 				emitDriverInfo(NecroLog::Level::Error, tr("Legacy protocol is not supported, switch station to extended one."));
 			}
 			else {
-				processSIMessageData(data);
+				unsigned int crc_sum = crc529(static_cast<unsigned int>(data_len + 2), frame + 1);
+				unsigned int crc_received = (frame[len-3] << 8) + frame[len-2];
+				if(crc_sum != crc_received) {
+					qfWarning() << tr("CRC error, received: %1, computed: %2, skipping STX").arg(crc_received, 4, 16, QChar('0')).arg(crc_sum, 4, 16, QChar('0'));
+					/// STX might be a part of garbage, try to find next one
+					m_rxBegin++;
+					continue;
+				}
+				/// message data are referencing rx buffer, they are valid during processSIMessageData() call only
+				processSIMessageData(SIMessageData(QByteArray::fromRawData(buff + m_rxBegin, len)));
 			}
 		}
 		else {
-			qfWarning() << tr("Valid message shall end with ETX or NAK, throwing data away");
+			qfWarning() << tr("Valid message shall end with ETX or NAK, skipping STX");
+			m_rxBegin++;
+			continue;
 		}
-		f_rxData = f_rxData.mid(len);
+		m_rxBegin += len;
 	}
+	if(m_rxBegin == m_rxEnd)
+		m_rxBegin = m_rxEnd = 0;
 }
 
 void DeviceDriver::emitDriverInfo( NecroLog::Level level, const QString& msg )
@@ -174,7 +261,7 @@ void DeviceDriver::sendCommand(int cmd, const QByteArray& data)
 
 		ba += data;
 
-		int crc_sum = crc(len + 2, (unsigned char*)ba.constData() + 1);
+		int crc_sum = crc529(len + 2, (const unsigned char*)ba.constData() + 1);
 		set_byte_at(ba, ba.length(), (crc_sum >> 8) & 0xFF);
 		set_byte_at(ba, ba.length(), crc_sum & 0xFF);
 		set_byte_at(ba, ba.length(), ETX);
@@ -206,6 +293,12 @@ void DeviceDriver::setSiTask(SiTask *task)
 	m_taskInProcess->start();
 }
 
+void DeviceDriver::abortSiTask()
+{
+	if(m_taskInProcess)
+		m_taskInProcess->abort();
+}
+
 void DeviceDriver::sendACK()
 {
 	emit dataToSend(QByteArray(1, ACK));
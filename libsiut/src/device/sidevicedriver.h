@@ -38,6 +38,11 @@ public:
 
 	void sendCommand(int cmd, const QByteArray& data);
 	void setSiTask(SiTask *task);
+	void abortSiTask();
+
+	/// transmit records (autosend punches) are decoded only when enabled, SimulatedStation sends them
+	bool isTransmitRecordsEnabled() const {return m_transmitRecordsEnabled;}
+	void setTransmitRecordsEnabled(bool b) {m_transmitRecordsEnabled = b;}
 
 	void sendACK();
 
@@ -49,14 +54,25 @@ public:
 protected:
 	//virtual void onSiMessageReceived(const SIMessageData &msg);
 	void processSIMessageData(const SIMessageData &msg_data);
+	void processTransmitRecord(const SIMessageData &msg);
 	void emitDriverInfo(NecroLog::Level level, const QString &msg);
 private:
 	//void sendAck();
 	//void abortMessage();
+	void appendRxData(const QByteArray &data);
+	void processRxData();
 protected:
-	QByteArray f_rxData;
+	/// received data are appended to m_rxBuffer and parsed in place,
+	/// unprocessed rest is moved to the buffer beginning only when there is no space left at the end
+	QByteArray m_rxBuffer;
+	int m_rxBegin = 0;
+	int m_rxEnd = 0;
+	/// data received while message is processed, messages passed to processSIMessageData() reference m_rxBuffer
+	QByteArray m_rxPending;
+	bool m_isProcessingData = false;
 	SIMessageData f_messageData;
 	SiTask *m_taskInProcess = nullptr;
+	bool m_transmitRecordsEnabled = false;
 };
 
 }
@@ -0,0 +1,596 @@
+#include "simulatedstation.h"
+#include "crc529.h"
+#include "../message/simessagedata.h"
+
+#include <qf/core/log.h>
+
+#include <QDate>
+#include <QRandomGenerator>
+#include <QScopedValueRollback>
+#include <QTime>
+#include <QTimer>
+
+namespace siut {
+
+namespace {
+constexpr char STX = 0x02;
+constexpr char ETX = 0x03;
+constexpr char ACK = 0x06;
+constexpr uint8_t WAKEUP = 0xFF;
+constexpr int BLOCK_SIZE = 128;
+constexpr int HALF_DAY_SEC = 12 * 60 * 60;
+constexpr int GENERATOR_TICK_MSEC = 10;
+
+int byte_at(const QByteArray &ba, int ix)
+{
+	return (ix < ba.size())? (uint8_t)ba[ix]: 0;
+}
+
+/// SI 12H time, INVALID_SI_TIME is kept
+unsigned time12(int time)
+{
+	if(time == SICard::INVALID_SI_TIME)
+		return (unsigned)time;
+	return (unsigned)(((time % HALF_DAY_SEC) + HALF_DAY_SEC) % HALF_DAY_SEC);
+}
+
+void put_unsigned(QByteArray &ba, int ix, unsigned val, int byte_cnt)
+{
+	for (int i = byte_cnt - 1; i >= 0; --i) {
+		ba[ix + i] = (char)(val & 0xFF);
+		val >>= 8;
+	}
+}
+
+/// SI punch record: PTD, CN, PTH, PTL
+void put_punch_record(QByteArray &ba, int ix, int code, int time)
+{
+	if(time == SICard::INVALID_SI_TIME) {
+		put_unsigned(ba, ix, 0xEEEEEEEE, 4);
+		return;
+	}
+	uint8_t ptd = (time >= HALF_DAY_SEC)? 1: 0;
+	ptd |= (uint8_t)(QDate::currentDate().dayOfWeek() % 7) << 1;
+	ba[ix] = (char)ptd;
+	ba[ix + 1] = (char)(code & 0xFF);
+	put_unsigned(ba, ix + 2, time12(time), 2);
+}
+
+/// SI3, SI2, SI1, SI0 as it is sent in card detected and transmit record messages
+QByteArray card_number_bytes(int card_number)
+{
+	QByteArray ret(4, 0);
+	if(card_number < 500000) {
+		/// SI5 card number is CS * 100000 + 16 bit number
+		int cs = card_number / 100000;
+		if(cs >= 2) {
+			ret[1] = (char)cs;
+			put_unsigned(ret, 2, (unsigned)(card_number % 100000), 2);
+			return ret;
+		}
+	}
+	put_unsigned(ret, 1, (unsigned)card_number, 3);
+	return ret;
+}
+}
+
+SimulatedStation::SimulatedStation(QObject *parent)
+	: Super(parent)
+{
+	m_generatorTimer = new QTimer(this);
+	m_generatorTimer->setInterval(GENERATOR_TICK_MSEC);
+	connect(m_generatorTimer, &QTimer::timeout, this, &SimulatedStation::onGeneratorTimeout);
+	m_generatorCardTypes << CardType::Card5 << CardType::Card6 << CardType::Card8 << CardType::Card9
+						 << CardType::pCard << CardType::Card10 << CardType::Siac;
+}
+
+SimulatedStation::~SimulatedStation()
+{
+}
+
+void SimulatedStation::processData(const QByteArray &data)
+{
+	m_rxBuffer.append(data);
+	if(m_isProcessingData) {
+		/// driver sent data from dataReceived() handler, they will be processed in the loop below
+		return;
+	}
+	QScopedValueRollback<bool> processing_guard(m_isProcessingData, true);
+	while(!m_rxBuffer.isEmpty()) {
+		uint8_t b = (uint8_t)m_rxBuffer[0];
+		if(b == ACK) {
+			m_rxBuffer.remove(0, 1);
+			onCardAcknowledged();
+			continue;
+		}
+		if(b != STX) {
+			if(b != WAKEUP)
+				qfWarning() << "SimulatedStation: garbage received:" << QString::number(b, 16);
+			m_rxBuffer.remove(0, 1);
+			continue;
+		}
+		if(m_rxBuffer.size() < 3)
+			break;
+		int data_len = (uint8_t)m_rxBuffer[2];
+		int len = data_len + 3 + 3;
+		if(m_rxBuffer.size() < len)
+			break;
+		const uint8_t *frame = (const uint8_t*)m_rxBuffer.constData();
+		unsigned int crc_sum = crc529((unsigned int)(data_len + 2), frame + 1);
+		unsigned int crc_received = (frame[len-3] << 8) + frame[len-2];
+		if(frame[len-1] != ETX || crc_sum != crc_received) {
+			qfWarning() << "SimulatedStation: invalid frame received, skipping STX";
+			m_rxBuffer.remove(0, 1);
+			continue;
+		}
+		uint8_t cmd = frame[1];
+		QByteArray cmd_data = m_rxBuffer.mid(3, data_len);
+		m_rxBuffer.remove(0, len);
+		processCommand(cmd, cmd_data);
+	}
+}
+
+void SimulatedStation::sendFrame(uint8_t cmd, const QByteArray &data)
+{
+	QByteArray ba;
+	ba.reserve(data.size() + 6);
+	ba.append(STX);
+	ba.append((char)cmd);
+	ba.append((char)data.size());
+	ba.append(data);
+	unsigned int crc_sum = crc529((unsigned int)(data.size() + 2), (const unsigned char*)ba.constData() + 1);
+	ba.append((char)((crc_sum >> 8) & 0xFF));
+	ba.append((char)(crc_sum & 0xFF));
+	ba.append(ETX);
+	emit dataReceived(ba);
+}
+
+QByteArray SimulatedStation::stationNumberBytes() const
+{
+	QByteArray ret(2, 0);
+	put_unsigned(ret, 0, (unsigned)m_stationNumber, 2);
+	return ret;
+}
+
+void SimulatedStation::processCommand(uint8_t cmd, const QByteArray &data)
+{
+	switch(static_cast<SIMessageData::Command>(cmd)) {
+	case SIMessageData::Command::SetDirectRemoteMode: {
+		sendFrame(cmd, stationNumberBytes() + QByteArray(1, (char)byte_at(data, 0)));
+		break;
+	}
+	case SIMessageData::Command::GetSystemData: {
+		int address = byte_at(data, 0);
+		int len = byte_at(data, 1);
+		sendFrame(cmd, stationNumberBytes() + QByteArray(1, (char)address) + systemData(address, len));
+		break;
+	}
+	case SIMessageData::Command::GetBackupMemory: {
+		if(data.size() < 4) {
+			qfWarning() << "SimulatedStation: invalid backup memory request";
+			break;
+		}
+		uint32_t address = SIPunch::getUnsigned(data, 0, 3);
+		int len = (uint8_t)data[3];
+		sendFrame(cmd, stationNumberBytes() + data.mid(0, 3) + backupMemoryData(address, len));
+		break;
+	}
+	case SIMessageData::Command::GetSICard5:
+	case SIMessageData::Command::GetSICard6:
+	case SIMessageData::Command::GetSICard8: {
+		if(m_currentCard.isEmpty()) {
+			qfWarning() << "SimulatedStation: card read-out requested, but there is no card in station";
+			break;
+		}
+		if(cmd == (uint8_t)SIMessageData::Command::GetSICard5) {
+			sendFrame(cmd, stationNumberBytes() + card5Data());
+		}
+		else {
+			int block_number = byte_at(data, 0);
+			sendFrame(cmd, stationNumberBytes() + QByteArray(1, (char)block_number) + cardBlock(block_number));
+		}
+		break;
+	}
+	default:
+		qfWarning() << "SimulatedStation: unsupported command:" << QString::number(cmd, 16);
+	}
+}
+
+void SimulatedStation::insertCard(CardType type, const SICard &card)
+{
+	QueuedCard qc;
+	qc.type = type;
+	qc.card = card;
+	int max_cnt = maxPunchCount(type);
+	QVariantList punches = card.punches();
+	if(punches.count() > max_cnt) {
+		qfWarning() << "SimulatedStation: card" << card.cardNumber() << "punch count:" << punches.count() << "exceeds card capacity:" << max_cnt;
+		qc.card.setPunches(punches.mid(0, max_cnt));
+	}
+	m_cardQueue.enqueue(qc);
+	if(m_currentCard.isEmpty())
+		QTimer::singleShot(0, this, &SimulatedStation::insertNextCard);
+}
+
+void SimulatedStation::insertNextCard()
+{
+	if(!m_currentCard.isEmpty() || m_cardQueue.isEmpty())
+		return;
+	QueuedCard qc = m_cardQueue.dequeue();
+	m_currentCardType = qc.type;
+	m_currentCard = qc.card;
+	SIMessageData::Command cmd = SIMessageData::Command::SICard8Detected;
+	if(qc.type == CardType::Card5)
+		cmd = SIMessageData::Command::SICard5Detected;
+	else if(qc.type == CardType::Card6)
+		cmd = SIMessageData::Command::SICard6Detected;
+	sendFrame((uint8_t)cmd, stationNumberBytes() + card_number_bytes(m_currentCard.cardNumber()));
+}
+
+void SimulatedStation::onCardAcknowledged()
+{
+	if(m_currentCard.isEmpty())
+		return;
+	int card_number = m_currentCard.cardNumber();
+	m_currentCard = SICard();
+	m_readOutCardCount++;
+	emit cardReadOut(card_number);
+	/// card is removed and next one inserted after driver finishes ACK sending task
+	QTimer::singleShot(0, this, [this, card_number]() {
+		sendFrame((uint8_t)SIMessageData::Command::SICardRemoved, stationNumberBytes() + card_number_bytes(card_number));
+		insertNextCard();
+	});
+	if(m_generatorCardCount > 0 && m_readOutCardCount >= m_generatorCardCount && m_generatorTimer->isActive()) {
+		stopGenerator();
+		emit generatorFinished();
+	}
+}
+
+void SimulatedStation::sendPunch(const SIPunch &punch)
+{
+	/// CN1, CN0, SI3, SI2, SI1, SI0, TD, TH, TL, TSS, MEM2, MEM1, MEM0
+	int time = punch.time();
+	QByteArray data(13, 0);
+	put_unsigned(data, 0, (unsigned)punch.code(), 2);
+	data.replace(2, 4, card_number_bytes(punch.cardNumber()));
+	uint8_t td = (time >= HALF_DAY_SEC || punch.pmFlag())? 1: 0;
+	td |= (uint8_t)((punch.dayOfWeek() & 7) << 1);
+	td |= (uint8_t)((punch.weekCnt() & 3) << 4);
+	data[6] = (char)td;
+	put_unsigned(data, 7, time12(time), 2);
+	data[9] = (char)(punch.msec() * 256 / 1000);
+	put_unsigned(data, 10, MEMORY_START + (unsigned)m_backupMemory.size(), 3);
+	appendBackupMemoryRecord(punch);
+	m_sentPunchCount++;
+	sendFrame((uint8_t)SIMessageData::Command::TransmitRecord, data);
+}
+
+void SimulatedStation::appendBackupMemoryRecord(const SIPunch &punch)
+{
+	/// SI2, SI1, SI0, DATE1, DATE0, TH, TL, MS, see SiTaskReadStationBackupMemory::createResult()
+	QByteArray rec(8, 0);
+	put_unsigned(rec, 0, (unsigned)punch.cardNumber(), 3);
+	QDate d = QDate::currentDate();
+	int year = (d.year() - 2000) & 0x3F;
+	int month = d.month();
+	bool is_pm = punch.time() >= HALF_DAY_SEC || punch.pmFlag();
+	rec[3] = (char)((year << 2) | (month >> 2));
+	rec[4] = (char)(((month & 3) << 6) | (d.day() << 1) | (is_pm? 1: 0));
+	put_unsigned(rec, 5, time12(punch.time()), 2);
+	rec[7] = (char)(punch.msec() * 256 / 1000);
+	m_backupMemory.append(rec);
+}
+
+void SimulatedStation::replay(const QByteArray &data, int chunk_size)
+{
+	if(chunk_size <= 0) {
+		emit dataReceived(data);
+		return;
+	}
+	for (int i = 0; i < data.size(); i += chunk_size)
+		emit dataReceived(data.mid(i, chunk_size));
+}
+
+QByteArray SimulatedStation::systemData(int address, int len) const
+{
+	QByteArray mem(BLOCK_SIZE, 0);
+	/// backup memory pointer EP3, EP2, xx, xx, xx, EP1, EP0 at 0x1C
+	uint32_t ptr = MEMORY_START + (uint32_t)m_backupMemory.size();
+	mem[0x1C] = (char)((ptr >> 24) & 0xFF);
+	mem[0x1D] = (char)((ptr >> 16) & 0xFF);
+	mem[0x21] = (char)((ptr >> 8) & 0xFF);
+	mem[0x22] = (char)(ptr & 0xFF);
+	/// memory overflow flag
+	mem[0x3D] = 0;
+	/// protocol configuration, extended mode and handshake
+	mem[0x74] = 0x05;
+	QByteArray ret = mem.mid(address, len);
+	if(ret.size() < len)
+		ret.append(QByteArray(len - ret.size(), 0));
+	return ret;
+}
+
+QByteArray SimulatedStation::backupMemoryData(uint32_t address, int len) const
+{
+	QByteArray ret(len, (char)0xFF);
+	if(address >= MEMORY_START) {
+		int ix = (int)(address - MEMORY_START);
+		int n = qMin(len, m_backupMemory.size() - ix);
+		if(n > 0)
+			ret.replace(0, n, m_backupMemory.mid(ix, n));
+	}
+	return ret;
+}
+
+QByteArray SimulatedStation::cardBlock(int block_number) const
+{
+	if(m_currentCardType == CardType::Card6)
+		return card6Block(block_number);
+	return card8Block(block_number);
+}
+
+QByteArray SimulatedStation::card5Data() const
+{
+	const SICard &card = m_currentCard;
+	QByteArray ret(BLOCK_SIZE, 0);
+	int card_number = card.cardNumber();
+	int cs = 1;
+	if(card_number >= 100000) {
+		cs = card_number / 100000;
+		card_number %= 100000;
+	}
+	put_unsigned(ret, 4, (unsigned)card_number, 2);
+	ret[6] = (char)cs;
+	put_unsigned(ret, 0x13, time12(card.startTime()), 2);
+	put_unsigned(ret, 0x15, time12(card.finishTime()), 2);
+	put_unsigned(ret, 0x19, time12(card.checkTime()), 2);
+	int punch_cnt = card.punchCount();
+	ret[0x17] = (char)(punch_cnt + 1);
+	int base = 0x20;
+	// 5 x 6 records with times, the first byte of every 16 bytes row holds code of punch 31-36 without time
+	for (int i = 0; i < punch_cnt; ++i) {
+		SIPunch p = card.punchAt(i);
+		if(i < 30) {
+			int offset = 3*i + i/5 + 1;
+			ret[base + offset] = (char)p.code();
+			put_unsigned(ret, base + offset + 1, time12(p.time()), 2);
+		}
+		else {
+			ret[base + 16*(i-30)] = (char)p.code();
+		}
+	}
+	return ret;
+}
+
+QByteArray SimulatedStation::card6Block(int block_number) const
+{
+	const SICard &card = m_currentCard;
+	QByteArray ret(BLOCK_SIZE, (char)0xEE);
+	if(block_number == 0) {
+		put_unsigned(ret, 11, (unsigned)card.cardNumber(), 3);
+		ret[18] = (char)card.punchCount();
+		put_punch_record(ret, 20, 0, card.finishTime());
+		put_punch_record(ret, 24, 0, card.startTime());
+		put_punch_record(ret, 28, 0, card.checkTime());
+		/// clear record at offset 32 is left empty, SICard does not carry clear time
+		return ret;
+	}
+	/// punches are stored in blocks 6, 7, 2, 3, 4, 5, 32 punches each
+	static const int block_order[] = {6, 7, 2, 3, 4, 5};
+	int first_punch = -1;
+	for (int i = 0; i < 6; ++i) {
+		if(block_order[i] == block_number) {
+			first_punch = i * 32;
+			break;
+		}
+	}
+	if(first_punch < 0)
+		return ret;
+	for (int i = 0; i < 32 && first_punch + i < card.punchCount(); ++i) {
+		SIPunch p = card.punchAt(first_punch + i);
+		put_punch_record(ret, i*4, p.code(), p.time());
+	}
+	return ret;
+}
+
+QByteArray SimulatedStation::card8Block(int block_number) const
+{
+	const SICard &card = m_currentCard;
+	QByteArray ret(BLOCK_SIZE, (char)0xEE);
+	/// card serie as it is read by SiTaskReadCard8
+	int cs = 2;
+	int first_punch = 0;
+	int punch_offset = 0;
+	int punch_capacity = 0;
+	switch(m_currentCardType) {
+	case CardType::Card8:
+		cs = 2;
+		if(block_number == 1) {
+			punch_offset = 8;
+			punch_capacity = 30;
+		}
+		break;
+	case CardType::Card9:
+		cs = 1;
+		if(block_number == 0) {
+			punch_offset = 14*4;
+			punch_capacity = 18;
+		}
+		else if(block_number == 1) {
+			first_punch = 18;
+			punch_capacity = 32;
+		}
+		break;
+	case CardType::pCard:
+		cs = 4;
+		if(block_number == 1) {
+			punch_offset = 12*4;
+			punch_capacity = 20;
+		}
+		break;
+	default:
+		/// SI10, SI11 and SIAC have the same memory layout
+		cs = 15;
+		if(block_number >= 4 && block_number <= 7) {
+			first_punch = (block_number - 4) * 32;
+			punch_capacity = 32;
+		}
+		else if(block_number == 3) {
+			QDate d = QDate::currentDate();
+			ret[0xf*4 + 0] = (char)(d.year() - 2000);
+			ret[0xf*4 + 1] = (char)d.month();
+			ret[0xf*4 + 2] = (char)d.day();
+			ret[0x10*4 + 0] = 1;
+			ret[0x10*4 + 1] = 0;
+			ret[0x10*4 + 2] = 1;
+			ret[0x10*4 + 3] = 0;
+			ret[0x15*4 + 1] = (char)0xAA;
+		}
+		break;
+	}
+	if(block_number == 0) {
+		put_punch_record(ret, 0x08, 0, card.checkTime());
+		put_punch_record(ret, 0x0c, 0, card.startTime());
+		put_punch_record(ret, 0x10, 0, card.finishTime());
+		ret[0x16] = (char)card.punchCount();
+		ret[0x18] = (char)cs;
+		put_unsigned(ret, 0x19, (unsigned)card.cardNumber(), 3);
+	}
+	for (int i = 0; i < punch_capacity && first_punch + i < card.punchCount(); ++i) {
+		SIPunch p = card.punchAt(first_punch + i);
+		put_punch_record(ret, punch_offset + i*4, p.code(), p.time());
+	}
+	return ret;
+}
+
+int SimulatedStation::maxPunchCount(CardType type)
+{
+	switch(type) {
+	case CardType::Card5: return 36;
+	case CardType::Card6: return 64;
+	case CardType::Card8: return 30;
+	case CardType::Card9: return 50;
+	case CardType::pCard: return 20;
+	case CardType::Card10:
+	case CardType::Siac: return 128;
+	}
+	return 0;
+}
+
+SimulatedStation::CardType SimulatedStation::cardTypeForCardNumber(int card_number)
+{
+	if(card_number < 500000)
+		return CardType::Card5;
+	if(card_number < 1000000)
+		return CardType::Card6;
+	if(card_number < 2000000)
+		return CardType::Card9;
+	if(card_number < 4000000)
+		return CardType::Card8;
+	if(card_number < 5000000)
+		return CardType::pCard;
+	if(card_number < 8000000)
+		return CardType::Card10;
+	return CardType::Siac;
+}
+
+int SimulatedStation::randomCardNumber(CardType type)
+{
+	QRandomGenerator *rnd = QRandomGenerator::global();
+	switch(type) {
+	case CardType::Card5: return rnd->bounded(1, 65000);
+	case CardType::Card6: return rnd->bounded(500000, 1000000);
+	case CardType::Card8: return rnd->bounded(2000001, 3000000);
+	case CardType::Card9: return rnd->bounded(1000000, 2000000);
+	case CardType::pCard: return rnd->bounded(4000000, 5000000);
+	case CardType::Card10: return rnd->bounded(7000000, 8000000);
+	case CardType::Siac: return rnd->bounded(8000001, 9000000);
+	}
+	return 0;
+}
+
+SICard SimulatedStation::generateCard(int card_number, int punch_count, int start_time)
+{
+	QRandomGenerator *rnd = QRandomGenerator::global();
+	SICard ret(card_number);
+	ret.setCheckTime(start_time - rnd->bounded(60, 300));
+	ret.setStartTime(start_time);
+	QVariantList punches;
+	int time = start_time;
+	for (int i = 0; i < punch_count; ++i) {
+		time += rnd->bounded(30, 300);
+		punches << SIPunch(31 + i, time);
+	}
+	ret.setPunches(punches);
+	ret.setFinishTime(time + rnd->bounded(10, 60));
+	return ret;
+}
+
+void SimulatedStation::startGenerator(int card_count, int cards_per_second, int punches_per_second)
+{
+	if(m_generatorCardTypes.isEmpty()) {
+		qfWarning() << "SimulatedStation: no card types set for generator";
+		return;
+	}
+	m_generatorCardCount = card_count;
+	m_generatedCardCount = 0;
+	m_readOutCardCount = 0;
+	m_sentPunchCount = 0;
+	m_generatorCardsPerTick = cards_per_second * GENERATOR_TICK_MSEC / 1000.;
+	m_generatorPunchesPerTick = punches_per_second * GENERATOR_TICK_MSEC / 1000.;
+	m_generatorCardsDue = 0;
+	m_generatorPunchesDue = 0;
+	m_generatorElapsed.start();
+	m_generatorTimer->start();
+	qfInfo() << "SimulatedStation: generator started, cards:" << card_count << "cards/sec:" << cards_per_second << "punches/sec:" << punches_per_second;
+}
+
+void SimulatedStation::stopGenerator()
+{
+	if(!m_generatorTimer->isActive())
+		return;
+	m_generatorTimer->stop();
+	qfInfo() << "SimulatedStation: generator stopped," << m_readOutCardCount << "cards read-out,"
+			 << m_sentPunchCount << "punches sent in" << m_generatorElapsed.elapsed() << "msec,"
+			 << cardsPerSecond() << "cards/sec";
+}
+
+double SimulatedStation::cardsPerSecond() const
+{
+	qint64 msec = m_generatorElapsed.isValid()? m_generatorElapsed.elapsed(): 0;
+	if(msec <= 0)
+		return 0;
+	return m_readOutCardCount * 1000. / msec;
+}
+
+void SimulatedStation::onGeneratorTimeout()
+{
+	int start_time = QTime::currentTime().msecsSinceStartOfDay() / 1000;
+	m_generatorCardsDue += m_generatorCardsPerTick;
+	while(m_generatorCardsDue >= 1) {
+		if(m_generatorCardCount > 0 && m_generatedCardCount >= m_generatorCardCount)
+			break;
+		if(m_cardQueue.count() >= m_generatorMaxQueueLength)
+			break;
+		m_generatorCardsDue -= 1;
+		CardType type = m_generatorCardTypes.value(m_generatedCardCount % m_generatorCardTypes.count());
+		int punch_cnt = qMin(m_generatorPunchCount, maxPunchCount(type));
+		insertCard(type, generateCard(randomCardNumber(type), punch_cnt, start_time - punch_cnt * 300));
+		m_generatedCardCount++;
+	}
+	if(m_cardQueue.count() >= m_generatorMaxQueueLength) {
+		/// read-out path is slower than generator, do not accumulate cards which cannot be inserted
+		m_generatorCardsDue = qMin(m_generatorCardsDue, 1.);
+	}
+	m_generatorPunchesDue += m_generatorPunchesPerTick;
+	while(m_generatorPunchesDue >= 1) {
+		m_generatorPunchesDue -= 1;
+		CardType type = m_generatorCardTypes.value(m_sentPunchCount % m_generatorCardTypes.count());
+		SIPunch punch(QRandomGenerator::global()->bounded(31, 100), start_time);
+		punch.setCardNumber(randomCardNumber(type));
+		punch.setMsec(QRandomGenerator::global()->bounded(1000));
+		sendPunch(punch);
+	}
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../siutglobal.h"
+#include "../sicard.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QQueue>
+#include <QVector>
+
+class QTimer;
+
+namespace siut {
+
+/// Software SI station in extended protocol, direct mode.
+/// It can be used instead of CommPort to load-test card read-out path without hardware,
+/// connect DeviceDriver::dataToSend() to processData() and dataReceived() to DeviceDriver::processData().
+/// Connect station to driver with Qt::QueuedConnection to simulate serial line latency and to avoid deep call stacks.
+/// Station answers card read-out, direct/remote mode, system data and backup memory commands,
+/// it can also replay captured byte stream and generate cards and transmit records at configurable rate.
+/// Transmit records are decoded by driver only when DeviceDriver::setTransmitRecordsEnabled() is set.
+class SIUT_DECL_EXPORT SimulatedStation : public QObject
+{
+	Q_OBJECT
+	using Super = QObject;
+public:
+	enum class CardType {Card5, Card6, Card8, Card9, pCard, Card10, Siac};
+public:
+	explicit SimulatedStation(QObject *parent = nullptr);
+	~SimulatedStation() override;
+
+	int stationNumber() const {return m_stationNumber;}
+	void setStationNumber(int n) {m_stationNumber = n;}
+
+	/// data sent by station to driver
+	Q_SIGNAL void dataReceived(const QByteArray &data);
+	/// data sent by driver to station
+	void processData(const QByteArray &data);
+
+	/// card is queued and inserted to station when previous one is read-out and acknowledged
+	void insertCard(CardType type, const SICard &card);
+	int queuedCardCount() const {return m_cardQueue.count() + (m_currentCard.isEmpty()? 0: 1);}
+	/// transmit record like station in autosend mode does, punch is stored to backup memory too
+	void sendPunch(const SIPunch &punch);
+	/// send captured data as they are, in chunks of chunk_size bytes to simulate serial line fragmentation
+	void replay(const QByteArray &data, int chunk_size = 0);
+
+	static int maxPunchCount(CardType type);
+	static CardType cardTypeForCardNumber(int card_number);
+	/// random card number from card type number range
+	static int randomCardNumber(CardType type);
+	/// card with random check, start, finish and punch_count punch times, codes are 31, 32, ...
+	static SICard generateCard(int card_number, int punch_count, int start_time);
+
+	/// generator inserts cards_per_second cards and sends punches_per_second transmit records
+	/// until card_count cards are read-out, card_count == 0 means forever
+	void startGenerator(int card_count, int cards_per_second, int punches_per_second = 0);
+	void stopGenerator();
+	/// card types used by generator, cards are generated round robin
+	void setGeneratorCardTypes(const QList<CardType> &types) {m_generatorCardTypes = types;}
+	void setGeneratorPunchCount(int n) {m_generatorPunchCount = n;}
+	/// max number of cards waiting in station, generator does not insert next card when queue is full
+	void setGeneratorMaxQueueLength(int n) {m_generatorMaxQueueLength = n;}
+
+	int readOutCardCount() const {return m_readOutCardCount;}
+	int sentPunchCount() const {return m_sentPunchCount;}
+	/// read-out cards per second since generator start
+	double cardsPerSecond() const;
+
+	Q_SIGNAL void cardReadOut(int card_number);
+	Q_SIGNAL void generatorFinished();
+private:
+	void sendFrame(uint8_t cmd, const QByteArray &data);
+	void processCommand(uint8_t cmd, const QByteArray &data);
+	void insertNextCard();
+	void onCardAcknowledged();
+	void onGeneratorTimeout();
+
+	QByteArray stationNumberBytes() const;
+	QByteArray cardBlock(int block_number) const;
+	QByteArray card5Data() const;
+	QByteArray card6Block(int block_number) const;
+	QByteArray card8Block(int block_number) const;
+	QByteArray systemData(int address, int len) const;
+	QByteArray backupMemoryData(uint32_t address, int len) const;
+	void appendBackupMemoryRecord(const SIPunch &punch);
+private:
+	static constexpr uint32_t MEMORY_START = 0x100;
+	int m_stationNumber = 1;
+	QByteArray m_rxBuffer;
+	bool m_isProcessingData = false;
+
+	struct QueuedCard
+	{
+		CardType type = CardType::Card5;
+		SICard card;
+	};
+	QQueue<QueuedCard> m_cardQueue;
+	CardType m_currentCardType = CardType::Card5;
+	SICard m_currentCard;
+
+	QByteArray m_backupMemory;
+
+	QTimer *m_generatorTimer = nullptr;
+	QElapsedTimer m_generatorElapsed;
+	QList<CardType> m_generatorCardTypes;
+	int m_generatorPunchCount = 20;
+	int m_generatorMaxQueueLength = 10;
+	int m_generatorCardCount = 0;
+	int m_generatedCardCount = 0;
+	double m_generatorCardsPerTick = 0;
+	double m_generatorPunchesPerTick = 0;
+	double m_generatorCardsDue = 0;
+	double m_generatorPunchesDue = 0;
+	int m_readOutCardCount = 0;
+	int m_sentPunchCount = 0;
+};
+
+}
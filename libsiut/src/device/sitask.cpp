@@ -127,6 +127,10 @@ void SiTaskStationConfig::onSiMessageReceived(const SIMessageData &msg)
 SiTaskReadStationBackupMemory::SiTaskReadStationBackupMemory(QObject *parent)
 	: Super(parent)
 {
+	m_retryTimer = new QTimer(this);
+	m_retryTimer->setSingleShot(true);
+	m_retryTimer->setInterval(1000);
+	connect(m_retryTimer, &QTimer::timeout, this, &SiTaskReadStationBackupMemory::resendPendingBlockRequests);
 }
 
 void SiTaskReadStationBackupMemory::start()
@@ -196,31 +200,37 @@ void SiTaskReadStationBackupMemory::onSiMessageReceived(const SIMessageData &msg
 			logCardRead() << "is memory overflow:" << is_overflow;
 
 			//m_blockCount = m_isOverflow? MEMORY_SIZE: (m_memoryDataPointer - MEMORY_START) / m_blockSize + 1;
-			m_blockCount = (is_overflow? MEMORY_SIZE - MEMORY_START: m_memoryDataPointer - MEMORY_START) / m_blockSize + 1;
+			unsigned block_count = (is_overflow? MEMORY_SIZE - MEMORY_START: m_memoryDataPointer - MEMORY_START) / m_blockSize + 1;
 
-			if(m_blockCount == 0) {
+			if(block_count == 0) {
 				finishAndDestroy(true, createResult());
 				return;
 			}
-			if(m_blockCount > 255) {
-				qfError() << "Invalid block count:" << m_blockCount;
+			if(block_count > 255) {
+				qfError() << "Invalid block count:" << block_count;
 				abort();
 				return;
 			}
 
-			logCardRead() << "ReadData";
-			emit progress(m_progressPhase++, (int)m_blockCount);
+			uint32_t read_data_pointer = is_overflow? m_memoryDataPointer + 1: MEMORY_START;
+			m_blockAddresses.clear();
+			for (unsigned i = 0; i < block_count; ++i) {
+				m_blockAddresses << read_data_pointer;
+				read_data_pointer += m_blockSize;
+				if(read_data_pointer - MEMORY_START > MEMORY_SIZE)
+					read_data_pointer = MEMORY_START;
+			}
+			m_blocks.clear();
+			m_blocks.resize(m_blockAddresses.count());
+			m_pendingBlocks.clear();
+			m_nextBlockIndex = 0;
+			m_receivedBlockCount = 0;
+
+			logCardRead() << "ReadData, blocks:" << block_count << "pipeline depth:" << m_pipelineDepth;
+			emit progress(m_progressPhase++, m_blockAddresses.count());
 			m_state = State::ReadData;
-			QByteArray ba;
-			if(is_overflow)
-				m_readDataPointer = m_memoryDataPointer + 1;
-			else
-				m_readDataPointer = MEMORY_START;
-			ba.append((char)((m_readDataPointer >> (2*8)) & 0xFF));
-			ba.append((char)((m_readDataPointer >> (1*8)) & 0xFF));
-			ba.append((char)((m_readDataPointer >> (0*8)) & 0xFF));
-			ba.append((char)m_blockSize);
-			sendCommand(0x81, ba);
+			m_readDataElapsed.start();
+			requestBlocks();
 		}
 		else {
 			qfError() << "Invalid command:" << (int)cmd << "received";
@@ -230,46 +240,7 @@ void SiTaskReadStationBackupMemory::onSiMessageReceived(const SIMessageData &msg
 	else if(m_state == State::ReadData) {
 		int cmd = (int)msg.command();
 		if(cmd == 0x81) {
-			logCardRead() << "block of" << msg.data().length() << "bytes received, " << m_blockCount << "blocks to receive";
-			logCardRead() << "read data pointer:" << QString::number(m_readDataPointer, 16) << "memory data pointer:" << QString::number(m_memoryDataPointer, 16) << "bytes to load:" << QString::number(m_memoryDataPointer - m_readDataPointer, 16);
-			QByteArray ba = msg.data().mid(8, m_blockSize);
-			if(m_readDataPointer < m_memoryDataPointer) {
-				if(m_memoryDataPointer - m_readDataPointer < m_blockSize) {
-					logCardRead() << "stripping last packet to len:" << (m_memoryDataPointer - m_readDataPointer);
-					ba = ba.mid(0, m_memoryDataPointer - m_readDataPointer);
-				}
-			}
-			//qfInfo() << SIMessageData::dumpData(ba, 16);
-			m_data.append(ba);
-			emit progress(m_progressPhase++, (int)m_blockCount);
-			if(!--m_blockCount) {
-				logCardRead() << "SwitchToDirect";
-				m_state = State::SwitchToDirect;
-				SiTaskSetDirectRemoteMode *cmd = new SiTaskSetDirectRemoteMode(SiTaskSetDirectRemoteMode::Mode::Direct);
-				connect(cmd, &SiTaskSetDirectRemoteMode::sigSendCommand, this, &SiTaskReadStationBackupMemory::sigSendCommand);
-				connect(this, &SiTaskReadStationBackupMemory::siMessageForwarded, cmd, &SiTaskSetDirectRemoteMode::onSiMessageReceived);
-				connect(cmd, &SiTaskSetDirectRemoteMode::finished, this, [this](bool ok, QVariant ) {
-					if(ok) {
-						finishAndDestroy(true, createResult());
-					}
-					else {
-						abort();
-					}
-				});
-				cmd->start();
-				return;
-			}
-			m_readDataPointer += m_blockSize;
-			if(m_readDataPointer - MEMORY_START > MEMORY_SIZE)
-				m_readDataPointer = MEMORY_START;
-			{
-				QByteArray ba;
-				ba.append((char)((m_readDataPointer >> (2*8)) & 0xFF));
-				ba.append((char)((m_readDataPointer >> (1*8)) & 0xFF));
-				ba.append((char)((m_readDataPointer >> (0*8)) & 0xFF));
-				ba.append((char)m_blockSize);
-				sendCommand(0x81, ba);
-			}
+			onBlockReceived(msg);
 		}
 		else {
 			qfError() << "Invalid command:" << cmd << "received";
@@ -282,6 +253,110 @@ void SiTaskReadStationBackupMemory::onSiMessageReceived(const SIMessageData &msg
 	}
 }
 
+void SiTaskReadStationBackupMemory::requestBlocks()
+{
+	while(m_pendingBlocks.count() < m_pipelineDepth && m_nextBlockIndex < m_blockAddresses.count()) {
+		int block_ix = m_nextBlockIndex++;
+		m_pendingBlocks << block_ix;
+		sendBlockRequest(block_ix);
+	}
+	if(m_pendingBlocks.isEmpty())
+		m_retryTimer->stop();
+	else
+		m_retryTimer->start();
+}
+
+void SiTaskReadStationBackupMemory::sendBlockRequest(int block_ix)
+{
+	uint32_t addr = m_blockAddresses.value(block_ix);
+	QByteArray ba;
+	ba.append((char)((addr >> (2*8)) & 0xFF));
+	ba.append((char)((addr >> (1*8)) & 0xFF));
+	ba.append((char)((addr >> (0*8)) & 0xFF));
+	ba.append((char)m_blockSize);
+	sendCommand(0x81, ba);
+}
+
+void SiTaskReadStationBackupMemory::onBlockReceived(const SIMessageData &msg)
+{
+	const QByteArray &hdr = msg.data();
+	if(hdr.size() < 8) {
+		qfError() << "Invalid backup memory block received, size:" << hdr.size();
+		abort();
+		return;
+	}
+	/// STX, CMD, LEN, CN1, CN0, ADR2, ADR1, ADR0, data ...
+	uint32_t addr = ((uint32_t)(uint8_t)hdr[5] << 16) + ((uint32_t)(uint8_t)hdr[6] << 8) + (uint8_t)hdr[7];
+	int pending_ix = -1;
+	for (int i = 0; i < m_pendingBlocks.count(); ++i) {
+		if(m_blockAddresses.value(m_pendingBlocks[i]) == addr) {
+			pending_ix = i;
+			break;
+		}
+	}
+	if(pending_ix < 0) {
+		/// duplicate response to resent request
+		logCardRead() << "unexpected block address:" << QString::number(addr, 16) << "ignored";
+		return;
+	}
+	int block_ix = m_pendingBlocks.takeAt(pending_ix);
+	logCardRead() << "block" << (block_ix + 1) << "of" << m_blockAddresses.count() << "received, address:" << QString::number(addr, 16)
+				  << "memory data pointer:" << QString::number(m_memoryDataPointer, 16);
+	QByteArray ba = hdr.mid(8, m_blockSize);
+	if(addr < m_memoryDataPointer) {
+		if(m_memoryDataPointer - addr < m_blockSize) {
+			logCardRead() << "stripping last packet to len:" << (m_memoryDataPointer - addr);
+			ba = ba.mid(0, m_memoryDataPointer - addr);
+		}
+	}
+	m_blocks[block_ix] = ba;
+	m_receivedBlockCount++;
+	m_retryCount = 0;
+	emit progress(m_progressPhase++, m_blockAddresses.count());
+	if(m_receivedBlockCount == m_blockAddresses.count()) {
+		m_retryTimer->stop();
+		m_data.clear();
+		for(const QByteArray &block : m_blocks)
+			m_data.append(block);
+		logCardRead() << m_blockAddresses.count() << "blocks," << m_data.size() << "bytes read in" << m_readDataElapsed.elapsed() << "msec";
+		switchToDirect();
+		return;
+	}
+	requestBlocks();
+}
+
+void SiTaskReadStationBackupMemory::resendPendingBlockRequests()
+{
+	if(m_state != State::ReadData || m_pendingBlocks.isEmpty())
+		return;
+	if(++m_retryCount > MAX_RETRY_COUNT) {
+		abortWithMessage(tr("Backup memory block read failed after %1 retries.").arg(MAX_RETRY_COUNT));
+		return;
+	}
+	qfWarning() << "Resending" << m_pendingBlocks.count() << "backup memory block requests, retry:" << m_retryCount;
+	for(int block_ix : m_pendingBlocks)
+		sendBlockRequest(block_ix);
+	m_retryTimer->start();
+}
+
+void SiTaskReadStationBackupMemory::switchToDirect()
+{
+	logCardRead() << "SwitchToDirect";
+	m_state = State::SwitchToDirect;
+	SiTaskSetDirectRemoteMode *cmd = new SiTaskSetDirectRemoteMode(SiTaskSetDirectRemoteMode::Mode::Direct);
+	connect(cmd, &SiTaskSetDirectRemoteMode::sigSendCommand, this, &SiTaskReadStationBackupMemory::sigSendCommand);
+	connect(this, &SiTaskReadStationBackupMemory::siMessageForwarded, cmd, &SiTaskSetDirectRemoteMode::onSiMessageReceived);
+	connect(cmd, &SiTaskSetDirectRemoteMode::finished, this, [this](bool ok, QVariant ) {
+		if(ok) {
+			finishAndDestroy(true, createResult());
+		}
+		else {
+			abort();
+		}
+	});
+	cmd->start();
+}
+
 QVariantMap SiTaskReadStationBackupMemory::createResult()
 {
 	QVariantMap ret;
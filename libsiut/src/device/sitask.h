@@ -5,7 +5,9 @@
 
 #include <qf/core/utils.h>
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QVector>
 
 class QTimer;
 
@@ -101,18 +103,38 @@ public:
 	Type type() const override {return  Type::Other;}
 	void start() override;
 	void onSiMessageReceived(const siut::SIMessageData &msg) override;
+
+	/// number of block read requests sent without waiting for response, 1 == strictly request/response
+	/// blocks are reassembled by address from response, so they can be received in any order
+	int pipelineDepth() const {return m_pipelineDepth;}
+	void setPipelineDepth(int n) {m_pipelineDepth = qMax(1, n);}
 private:
 	Q_SIGNAL void siMessageForwarded(const siut::SIMessageData &msg);
 	QVariantMap createResult();
+	void requestBlocks();
+	void sendBlockRequest(int block_ix);
+	void onBlockReceived(const siut::SIMessageData &msg);
+	void resendPendingBlockRequests();
+	void switchToDirect();
 private:
 	enum class State {SwitchToRemote, ReadPointer, CheckOverflow, ReadData, SwitchToDirect};
 	static constexpr unsigned MEMORY_START = 0x100;
 	static constexpr unsigned MEMORY_SIZE = 0x200000;
+	/// 0x81 command max data length
+	static constexpr unsigned MAX_BLOCK_SIZE = 128;
+	static constexpr int MAX_RETRY_COUNT = 3;
 	State m_state = State::SwitchToRemote;
 	uint32_t m_memoryDataPointer;
-	uint32_t m_readDataPointer;
-	unsigned m_blockSize = 128;
-	unsigned m_blockCount;
+	unsigned m_blockSize = MAX_BLOCK_SIZE;
+	int m_pipelineDepth = 1;
+	QVector<uint32_t> m_blockAddresses;
+	QVector<QByteArray> m_blocks;
+	QList<int> m_pendingBlocks; //< requested and not received block indexes
+	int m_nextBlockIndex = 0;
+	int m_receivedBlockCount = 0;
+	int m_retryCount = 0;
+	QTimer *m_retryTimer = nullptr;
+	QElapsedTimer m_readDataElapsed;
 	int m_progressPhase = 0;
 	//bool m_isOverflow;
 	int m_stationNumber = 0;
@@ -94,4 +94,25 @@ quickevent::core::CourseDef CardChecker::courseCodesForRunId(int run_id)
 	return getPlugin<RunsPlugin>()->courseCodesForRunId(run_id);
 }
 
+RunCoursePlan CardChecker::runCoursePlan(int run_id)
+{
+	return getPlugin<CardReaderPlugin>()->coursePlanCache().runCoursePlan(run_id);
+}
+
+CardCheckerCpp::CheckContext CardCheckerCpp::loadCheckContext(int run_id)
+{
+	CheckContext ret;
+	if(run_id > 0) {
+		ret.run = runCoursePlan(run_id);
+		ret.stageStartSec = stageStartSec(ret.run.stageId);
+	}
+	ret.cardCheckCheckTimeSec = cardCheckCheckTimeSec();
+	return ret;
+}
+
+quickevent::core::si::CheckedCardData CardCheckerCpp::checkCard(const quickevent::core::si::ReadCardData &read_card)
+{
+	return checkCard(read_card, loadCheckContext(read_card.runId));
+}
+
 }
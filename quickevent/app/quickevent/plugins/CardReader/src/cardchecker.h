@@ -1,14 +1,16 @@
 #ifndef CARDREADER_CARDCHECKER_H
 #define CARDREADER_CARDCHECKER_H
 
-#include <quickevent/core/si/checkedcard.h>
+#include "courseplancache.h"
+
+#include <quickevent/core/si/carddata.h>
 
 #include <qf/core/utils.h>
 
 #include <QObject>
 #include <QVariant>
 
-namespace quickevent { namespace core { namespace si { class ReadCard; } class CourseDef;}}
+namespace quickevent { namespace core { class CourseDef; }}
 
 namespace CardReader {
 
@@ -35,6 +37,8 @@ public:
 	Q_INVOKABLE int startTimeSec(int run_id);
 	Q_INVOKABLE int cardCheckCheckTimeSec();
 	quickevent::core::CourseDef courseCodesForRunId(int run_id);
+	/// compiled course and start time for run, courses are cached by CardReaderPlugin
+	RunCoursePlan runCoursePlan(int run_id);
 
 	//static int finishPunchCode();
 
@@ -50,7 +54,18 @@ class CardCheckerCpp : public CardChecker
 public:
 	explicit CardCheckerCpp(QObject *parent = nullptr) : Super(parent) {}
 
-	virtual quickevent::core::si::CheckedCard checkCard(const quickevent::core::si::ReadCard &read_card) = 0;
+	/// everything needed to check card besides card itself
+	struct CheckContext
+	{
+		RunCoursePlan run;
+		int stageStartSec = 0;
+		int cardCheckCheckTimeSec = 0;
+	};
+	CheckContext loadCheckContext(int run_id);
+
+	quickevent::core::si::CheckedCardData checkCard(const quickevent::core::si::ReadCardData &read_card);
+	/// check is pure function of its arguments, so it can run in worker thread
+	virtual quickevent::core::si::CheckedCardData checkCard(const quickevent::core::si::ReadCardData &read_card, const CheckContext &context) const = 0;
 };
 
 }
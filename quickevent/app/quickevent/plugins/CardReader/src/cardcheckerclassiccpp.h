@@ -13,7 +13,8 @@ private:
 public:
 	CardCheckerClassicCpp(QObject *parent = nullptr);
 
-	quickevent::core::si::CheckedCard checkCard(const quickevent::core::si::ReadCard &read_card) Q_DECL_OVERRIDE;
+	using Super::checkCard;
+	quickevent::core::si::CheckedCardData checkCard(const quickevent::core::si::ReadCardData &read_card, const CheckContext &context) const Q_DECL_OVERRIDE;
 };
 
 } // namespace CardReader
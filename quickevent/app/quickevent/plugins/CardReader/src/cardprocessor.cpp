@@ -0,0 +1,187 @@
+#include "cardprocessor.h"
+#include "cardreaderplugin.h"
+
+#include <quickevent/core/codedef.h>
+
+#include <qf/core/log.h>
+#include <qf/core/exception.h>
+#include <qf/core/sql/connection.h>
+#include <qf/core/sql/query.h>
+#include <qf/core/sql/transaction.h>
+
+//#define QF_TIMESCOPE_ENABLED
+#include <qf/core/utils/timescope.h>
+
+#include <QMutexLocker>
+
+namespace qfs = qf::core::sql;
+
+namespace CardReader {
+
+CardProcessor::CardProcessor(const QString &connection_name, QObject *parent)
+	: Super(parent)
+	, m_sourceConnectionName(connection_name)
+{
+	qRegisterMetaType<CardReader::CardProcessorResult>();
+	qfs::Connection conn = qfs::Connection::forName(connection_name);
+	m_sourceConnectionName = conn.connectionName();
+	m_connectionName = m_sourceConnectionName + QStringLiteral("_cardProcessor");
+	/// QSqlDatabase::database() and cloneDatabase() cannot be called from worker thread in Qt < 5.13,
+	/// connection parameters are read here and worker connection is created in run()
+	m_driverName = conn.driverName();
+	m_hostName = conn.hostName();
+	m_port = conn.port();
+	m_databaseName = conn.databaseName();
+	m_userName = conn.userName();
+	m_password = conn.password();
+	m_connectOptions = conn.connectOptions();
+	if(m_driverName.endsWith(QLatin1String("PSQL")))
+		m_schemaName = conn.currentSchema();
+}
+
+CardProcessor::~CardProcessor()
+{
+	stop();
+}
+
+bool CardProcessor::tryEnqueue(const CardProcessorJob &job)
+{
+	QMutexLocker locker(&m_mutex);
+	if(m_stopRequested)
+		return false;
+	if(m_queue.count() >= m_maxQueueLength)
+		return false;
+	m_queue.enqueue(job);
+	m_queueNotEmpty.wakeOne();
+	return true;
+}
+
+void CardProcessor::stop()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_stopRequested = true;
+		m_queueNotEmpty.wakeAll();
+	}
+	wait();
+}
+
+int CardProcessor::queueLength() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_queue.count();
+}
+
+bool CardProcessor::openConnection()
+{
+	qfs::Connection conn(QSqlDatabase::addDatabase(m_driverName, m_connectionName));
+	conn.setHostName(m_hostName);
+	conn.setPort(m_port);
+	conn.setDatabaseName(m_databaseName);
+	conn.setUserName(m_userName);
+	conn.setPassword(m_password);
+	QString connect_options = m_connectOptions;
+	if(conn.driverName().endsWith(QLatin1String("SQLITE")) && !connect_options.contains(QLatin1String("QSQLITE_BUSY_TIMEOUT"))) {
+		/// GUI thread connection writes to the same file
+		if(!connect_options.isEmpty())
+			connect_options += ';';
+		connect_options += QLatin1String("QSQLITE_BUSY_TIMEOUT=10000");
+	}
+	conn.setConnectOptions(connect_options);
+	if(!conn.open()) {
+		qfError() << "Card processor cannot open SQL connection:" << conn.errorString();
+		return false;
+	}
+	if(!m_schemaName.isEmpty()) {
+		if(!conn.setCurrentSchema(m_schemaName))
+			return false;
+	}
+	if(conn.driverName().endsWith(QLatin1String("SQLITE"))) {
+		qfs::Query q(conn);
+		q.exec(QStringLiteral("PRAGMA foreign_keys=ON"));
+	}
+	return true;
+}
+
+void CardProcessor::run()
+{
+	bool is_open = openConnection();
+	while(true) {
+		CardProcessorJob job;
+		{
+			QMutexLocker locker(&m_mutex);
+			while(m_queue.isEmpty() && !m_stopRequested)
+				m_queueNotEmpty.wait(&m_mutex);
+			/// queued cards are processed before stop
+			if(m_queue.isEmpty())
+				break;
+			job = m_queue.dequeue();
+		}
+		CardProcessorResult result;
+		if(is_open) {
+			result = processJob(job);
+		}
+		else {
+			result.readCard = job.readCard;
+			result.error = tr("Card processor SQL connection is not open.");
+		}
+		result.eventName = job.eventName;
+		result.latencyMs = static_cast<int>(job.enqueuedTimer.elapsed());
+		m_processedCardCount++;
+		m_lastLatencyMs = result.latencyMs;
+		if(result.latencyMs > m_maxLatencyMs)
+			m_maxLatencyMs = result.latencyMs;
+		emit cardProcessed(result);
+	}
+	{
+		qfs::Connection conn = qfs::Connection::forName(m_connectionName);
+		conn.close();
+	}
+	QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+CardProcessorResult CardProcessor::processJob(const CardProcessorJob &job)
+{
+	QF_TIME_SCOPE("CardProcessor::processJob()");
+	CardProcessorResult ret;
+	ret.readCard = job.readCard;
+	const quickevent::core::si::ReadCardData &read_card = job.readCard;
+	qfs::Connection conn = qfs::Connection::forName(m_connectionName);
+	try {
+		qfs::Transaction transaction(conn);
+		{
+			// create fake punch from finish station for speaker if it doesn't exists already
+			quickevent::core::si::PunchRecord punch;
+			punch.setsiid(read_card.cardNumber);
+			punch.setrunid(read_card.runId);
+			punch.settime(read_card.finishTime);
+			punch.setcode(quickevent::core::CodeDef::FINISH_PUNCH_CODE);
+			punch.setstageid(job.stageId);
+			punch.settimems(job.finishTimeMs);
+			int punch_id = CardReaderPlugin::insertPunchRecordSql(punch, conn);
+			if(punch_id > 0)
+				punch.setid(punch_id);
+			ret.finishPunch = punch;
+		}
+		ret.cardId = CardReaderPlugin::insertCardSql(read_card, job.stageId, job.readerConnectionId, conn);
+		if(ret.cardId > 0 && read_card.runId > 0) {
+			CardReaderPlugin::updateCardToRunAssignmentInPunchesSql(job.stageId, read_card.cardNumber, read_card.runId, conn);
+			CardReaderPlugin::saveCardAssignedRunnerIdSql(ret.cardId, read_card.runId, conn);
+			quickevent::core::si::CheckedCardData checked_card = job.cardChecker->checkCard(read_card, job.checkContext);
+			checked_card.runId = read_card.runId;
+			checked_card.cardNumber = read_card.cardNumber;
+			CardReaderPlugin::updateCheckedCardValuesSql(checked_card, conn);
+			ret.checkedCard = checked_card;
+		}
+		transaction.commit();
+	}
+	catch (const qf::core::Exception &e) {
+		ret.cardId = 0;
+		ret.checkedCard = quickevent::core::si::CheckedCardData();
+		ret.finishPunch = quickevent::core::si::PunchRecord();
+		ret.error = e.message();
+	}
+	return ret;
+}
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "cardchecker.h"
+
+#include <quickevent/core/si/carddata.h>
+#include <quickevent/core/si/punchrecord.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+
+namespace CardReader {
+
+/// Card read-out waiting for processing.
+/// Everything what needs GUI thread (plugins, caches, QML) is resolved before card is queued.
+struct CardProcessorJob
+{
+	quickevent::core::si::ReadCardData readCard;
+	QString eventName;
+	int stageId = 0;
+	int readerConnectionId = 0;
+	int finishTimeMs = 0; //< card finish time till stage start, for finish punch record
+	const CardCheckerCpp *cardChecker = nullptr;
+	CardCheckerCpp::CheckContext checkContext;
+	QElapsedTimer enqueuedTimer;
+};
+
+struct CardProcessorResult
+{
+	int cardId = 0;
+	quickevent::core::si::ReadCardData readCard;
+	/// valid when card was assigned to run
+	quickevent::core::si::CheckedCardData checkedCard;
+	/// fake punch from finish station, it has id set when saved
+	quickevent::core::si::PunchRecord finishPunch;
+	QString eventName; //< event card was saved to, result of closed event must not emit db events in the next one
+	int latencyMs = 0; //< time from enqueue till card is saved
+	QString error;
+};
+
+/// Saves and checks read-out cards in worker thread with its own SQL connection,
+/// so slow database does not block serial port and GUI.
+/// Queue between SI driver and worker is bounded, tryEnqueue() fails when it is full.
+/// Results are delivered to GUI thread by cardProcessed() signal, db events are emitted there.
+class CardProcessor : public QThread
+{
+	Q_OBJECT
+	using Super = QThread;
+public:
+	static constexpr int DEFAULT_MAX_QUEUE_LENGTH = 64;
+
+	/// worker opens its own connection with parameters of connection_name, it must be open
+	explicit CardProcessor(const QString &connection_name, QObject *parent = nullptr);
+	~CardProcessor() override;
+
+	/// does not block, returns false when queue is full or processor is stopping
+	bool tryEnqueue(const CardProcessorJob &job);
+	/// processes queued cards and stops thread
+	void stop();
+
+	int queueLength() const;
+	int maxQueueLength() const {return m_maxQueueLength;}
+	void setMaxQueueLength(int n) {m_maxQueueLength = qMax(1, n);}
+
+	int processedCardCount() const {return m_processedCardCount;}
+	int lastLatencyMs() const {return m_lastLatencyMs;}
+	int maxLatencyMs() const {return m_maxLatencyMs;}
+
+	Q_SIGNAL void cardProcessed(const CardReader::CardProcessorResult &result);
+protected:
+	void run() override;
+private:
+	bool openConnection();
+	CardProcessorResult processJob(const CardProcessorJob &job);
+private:
+	QString m_sourceConnectionName;
+	QString m_connectionName;
+	QString m_driverName;
+	QString m_hostName;
+	int m_port = -1;
+	QString m_databaseName;
+	QString m_userName;
+	QString m_password;
+	QString m_connectOptions;
+	QString m_schemaName;
+
+	mutable QMutex m_mutex;
+	QWaitCondition m_queueNotEmpty;
+	QQueue<CardProcessorJob> m_queue;
+	int m_maxQueueLength = DEFAULT_MAX_QUEUE_LENGTH;
+	bool m_stopRequested = false;
+
+	std::atomic<int> m_processedCardCount {0};
+	std::atomic<int> m_lastLatencyMs {0};
+	std::atomic<int> m_maxLatencyMs {0};
+};
+
+}
+
+Q_DECLARE_METATYPE(CardReader::CardProcessorResult)
@@ -1,11 +1,13 @@
 #include "cardreaderplugin.h"
 #include "cardcheckerclassiccpp.h"
 #include "cardcheckerfreeordercpp.h"
+#include "cardprocessor.h"
 #include "cardreaderwidget.h"
 #include "services/racomclient.h"
 
 #include <quickevent/core/og/timems.h>
 #include <quickevent/core/si/punchrecord.h>
+#include <quickevent/core/si/carddata.h>
 #include <quickevent/core/si/checkedcard.h>
 #include <quickevent/core/si/readcard.h>
 
@@ -23,6 +25,7 @@
 #include <QJSValue>
 #include <QMetaObject>
 #include <QSqlRecord>
+#include <QtConcurrent>
 
 //#define QF_TIMESCOPE_ENABLED
 #include <qf/core/utils/timescope.h>
@@ -60,6 +63,38 @@ void CardReaderPlugin::onInstalled()
 
 	services::RacomClient *racom_client = new services::RacomClient(this);
 	Event::services::Service::addService(racom_client);
+
+	connect(getPlugin<EventPlugin>(), &EventPlugin::eventOpenChanged, this, &CardReaderPlugin::clearCoursePlanCache);
+	connect(getPlugin<EventPlugin>(), &EventPlugin::eventOpenChanged, this, &CardReaderPlugin::clearRunSiIndex);
+	connect(getPlugin<EventPlugin>(), &EventPlugin::eventOpenChanged, this, &CardReaderPlugin::stopCardProcessor);
+	connect(getPlugin<EventPlugin>(), &EventPlugin::dbEventNotify, this, &CardReaderPlugin::onDbEventNotify);
+}
+
+void CardReaderPlugin::onDbEventNotify(const QString &domain, int connection_id, const QVariant &data)
+{
+	Q_UNUSED(connection_id)
+	if(domain == QLatin1String(Event::EventPlugin::DBEVENT_COURSES_CHANGED)) {
+		clearCoursePlanCache();
+	}
+	else if(domain == QLatin1String(Event::EventPlugin::DBEVENT_RUNS_CHANGED)
+			|| domain == QLatin1String(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED)
+			|| domain == QLatin1String(Event::EventPlugin::DBEVENT_REGISTRATIONS_IMPORTED)) {
+		clearRunSiIndex();
+	}
+	else if(domain == QLatin1String(Event::EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED)) {
+		quickevent::core::si::CheckedCard checked_card(data.toMap());
+		m_runSiIndex.setFinishTimeMs(checked_card.runId(), checked_card.finishTimeMs());
+	}
+}
+
+void CardReaderPlugin::clearCoursePlanCache()
+{
+	m_coursePlanCache.clear();
+}
+
+void CardReaderPlugin::clearRunSiIndex()
+{
+	m_runSiIndex.clear();
 }
 
 QQmlListProperty<CardReader::CardChecker> CardReaderPlugin::cardCheckersListProperty()
@@ -87,7 +122,8 @@ int CardReaderPlugin::currentStageId()
 
 int CardReaderPlugin::cardIdToSiId(int card_id)
 {
-	qf::core::sql::Query q = qf::core::sql::Query::fromExec("SELECT siId FROM cards WHERE id=" QF_IARG(card_id) , qf::core::Exception::Throw);
+	qf::core::sql::Query q;
+	q.execCached(QStringLiteral("SELECT siId FROM cards WHERE id=:id"), QVariantMap{{QStringLiteral(":id"), card_id}}, qf::core::Exception::Throw);
 	if(q.next())
 		return q.value(0).toInt();
 	return 0;
@@ -102,18 +138,17 @@ int CardReaderPlugin::findRunId(int si_id, int si_finish_time, QString *err_msg)
 	int finish_time_msec = getPlugin<EventPlugin>()->msecToStageStartAM(si_finish_time);
 	bool is_relays = getPlugin<EventPlugin>()->eventConfig()->isRelays();
 	if(is_relays) {
-		qf::core::sql::Query q;
-		q.exec("SELECT id, leg, startTimeMs, finishTimeMs FROM runs WHERE siId=" QF_IARG(si_id)
-			   " AND isRunning"
-			   " ORDER BY leg DESC"
-			   , qf::core::Exception::Throw);
-		while(q.next()) {
+		/// relay runs are sorted by leg descending
+		const QVector<RunSiIndex::Run> runs = m_runSiIndex.siRuns(0, si_id);
+		for(const RunSiIndex::Run &run : runs) {
+			if(!run.isRunning)
+				continue;
 			row_cnt++;
-			last_id = q.value("id").toInt();
+			last_id = run.runId;
 			if(finish_time_msec == quickevent::core::og::TimeMs::UNREAL_TIME_MSEC)
 				continue; /// skip all checks when finish time is not known
-			int st = q.value("startTimeMs").toInt();
-			int leg = q.value("leg").toInt();
+			int st = run.startTimeMs;
+			int leg = run.leg;
 			if(st == 0 && leg != 1) {
 				/// start time not set => this leg does not event start
 				continue;
@@ -122,7 +157,7 @@ int CardReaderPlugin::findRunId(int si_id, int si_finish_time, QString *err_msg)
 				/// start in future, this run cannot have this siid
 				continue;
 			}
-			int ft = q.value("finishTimeMs").toInt();
+			int ft = run.finishTimeMs;
 			if(ft == finish_time_msec)
 				qfInfo() << "Multiple reads of SI:" << si_id;
 			else if(ft > 0)
@@ -133,19 +168,15 @@ int CardReaderPlugin::findRunId(int si_id, int si_finish_time, QString *err_msg)
 	}
 	else {
 		int stage_no = currentStageId();
-		qf::core::sql::Query q;
-		q.exec("SELECT id, startTimeMs, finishTimeMs FROM runs WHERE stageId=" QF_IARG(stage_no)
-			   " AND siId=" QF_IARG(si_id)
-			   " AND isRunning"
-			   //" ORDER BY finishTimeMs"
-			   , qf::core::Exception::Throw);
-		while(q.next()) {
+		const QVector<RunSiIndex::Run> runs = m_runSiIndex.siRuns(stage_no, si_id);
+		for(const RunSiIndex::Run &run : runs) {
+			if(!run.isRunning)
+				continue;
 			row_cnt++;
-			last_id = q.value("id").toInt();
+			last_id = run.runId;
 			if(finish_time_msec == quickevent::core::og::TimeMs::UNREAL_TIME_MSEC)
 				continue; /// skip all checks when finish time is not known
-			int st = q.value("startTimeMs").toInt();
-			//int ft = q.value("finishTimeMs").toInt();
+			int st = run.startTimeMs;
 			if(st > finish_time_msec) {
 				/// start in future, this run cannot have this siid
 				continue;
@@ -155,9 +186,9 @@ int CardReaderPlugin::findRunId(int si_id, int si_finish_time, QString *err_msg)
 			}
 			else {
 				/// second possible run, give it up
-				qfWarning() << "There are more competitors with SI:" << si_id << "run id1:" << ret << "id2:" << q.value("id").toInt();
+				qfWarning() << "There are more competitors with SI:" << si_id << "run id1:" << ret << "id2:" << run.runId;
 				if(err_msg)
-					*err_msg = tr("More competitors with SI: %1, run1 id: %2, run2 id: %3").arg(si_id).arg(ret).arg(q.value("id").toInt());
+					*err_msg = tr("More competitors with SI: %1, run1 id: %2, run2 id: %3").arg(si_id).arg(ret).arg(run.runId);
 				ret = 0;
 				break;
 			}
@@ -184,84 +215,104 @@ bool CardReaderPlugin::isCardLent(int si_id, int si_finish_time, int run_id)
 	bool card_returned = false;
 	if(run_id == 0)
 		run_id = findRunId(si_id, si_finish_time);
-	qf::core::sql::Query q;
 	if(run_id > 0) {
-		q.exec("SELECT cardLent, cardReturned FROM runs WHERE id=" QF_IARG(run_id) );
-		if(q.next()) {
-			card_lent = q.value(0).toBool();
-			card_returned = q.value(1).toBool();
+		RunSiIndex::Run run = m_runSiIndex.run(run_id);
+		if(run.runId > 0) {
+			card_lent = run.cardLent;
+			card_returned = run.cardReturned;
+		}
+		else {
+			/// run is not in index, it might be from other stage or without SI
+			qf::core::sql::Query q;
+			q.execCached(QStringLiteral("SELECT cardLent, cardReturned FROM runs WHERE id=:id"), QVariantMap{{QStringLiteral(":id"), run_id}});
+			if(q.next()) {
+				card_lent = q.value(0).toBool();
+				card_returned = q.value(1).toBool();
+			}
 		}
 	}
 	if(!card_lent && !card_returned) {
-		q.exec("SELECT siId FROM lentcards WHERE NOT ignored AND siid=" QF_IARG(si_id) );
-		if(q.next())
+		if(m_runSiIndex.isInLentCards(si_id))
 			card_lent = true;
 	}
 	return (card_lent && !card_returned);
 }
 
 quickevent::core::si::ReadCard CardReaderPlugin::readCard(int card_id)
+{
+	quickevent::core::si::ReadCardData rc = readCardData(card_id);
+	if(rc.isEmpty())
+		return quickevent::core::si::ReadCard();
+	return rc.toReadCard();
+}
+
+quickevent::core::si::ReadCardData CardReaderPlugin::readCardData(int card_id)
 {
 	qfLogFuncFrame() << "card id:" << card_id;
 	qf::core::sql::Query q;
 	if(q.exec("SELECT * FROM cards WHERE id=" QF_IARG(card_id))) {
 		if(q.next()) {
-			quickevent::core::si::ReadCard rc(q.record());
-			return rc;
+			return quickevent::core::si::ReadCardData::fromSqlRecord(q.record());
 		}
 	}
 	qfWarning() << "Cannot find card record for id:" << card_id;
-	return quickevent::core::si::ReadCard();
+	return quickevent::core::si::ReadCardData();
 }
 
-quickevent::core::si::CheckedCard CardReaderPlugin::checkCard(int card_id, int run_id)
+quickevent::core::si::CheckedCardData CardReaderPlugin::checkCard(int card_id, int run_id)
 {
 	qfLogFuncFrame() << "run id:" << run_id << "card id:" << card_id;
 	QF_TIME_SCOPE("checkCard()");
-	quickevent::core::si::ReadCard rc = readCard(card_id);
+	quickevent::core::si::ReadCardData rc = readCardData(card_id);
 	if(!rc.isEmpty()) {
 		if(run_id > 0)
-			rc.setRunId(run_id);
+			rc.runId = run_id;
 		return checkCard(rc);
 	}
-	return quickevent::core::si::CheckedCard();
+	return quickevent::core::si::CheckedCardData();
 }
 
 quickevent::core::si::CheckedCard CardReaderPlugin::checkCard(const quickevent::core::si::ReadCard &read_card)
 {
-	qfLogFuncFrame() << "run id:" << read_card.runId();
+	return checkCard(quickevent::core::si::ReadCardData::fromReadCard(read_card)).toCheckedCard();
+}
+
+quickevent::core::si::CheckedCardData CardReaderPlugin::checkCard(const quickevent::core::si::ReadCardData &read_card)
+{
+	qfLogFuncFrame() << "run id:" << read_card.runId;
 	QF_TIME_SCOPE("checkCard()");
-	quickevent::core::si::CheckedCard cc;
+	quickevent::core::si::CheckedCardData cc;
 	CardReader::CardChecker *chk = currentCardChecker();
-	QF_ASSERT(chk != nullptr, "CardChecker is NULL", return quickevent::core::si::CheckedCard());
+	QF_ASSERT(chk != nullptr, "CardChecker is NULL", return quickevent::core::si::CheckedCardData());
 	CardReader::CardCheckerCpp *cpp_chk = qobject_cast<CardReader::CardCheckerCpp*>(chk);
 	if(cpp_chk) {
 		cc = cpp_chk->checkCard(read_card);
 	}
 	else {
+		/// QML checkers get and return card as JS object
 		QVariant ret_val;
 		QMetaObject::invokeMethod(chk, "checkCard", Qt::DirectConnection,
 								  Q_RETURN_ARG(QVariant, ret_val),
-								  Q_ARG(QVariant, read_card));
+								  Q_ARG(QVariant, read_card.toReadCard()));
 		QJSValue jsv = ret_val.value<QJSValue>();
 		QVariant v = jsv.toVariant();
 		QVariantMap m = v.toMap();
-		cc = quickevent::core::si::CheckedCard(m);
+		cc = quickevent::core::si::CheckedCardData::fromCheckedCard(quickevent::core::si::CheckedCard(m));
 	}
-	cc.setRunId(read_card.runId());
-	cc.setCardNumber(read_card.cardNumber());
+	cc.runId = read_card.runId;
+	cc.cardNumber = read_card.cardNumber;
 	qfDebug() << cc.toString();
 	return cc;
 }
 
-int CardReaderPlugin::saveCardToSql(const quickevent::core::si::ReadCard &read_card)
+int CardReaderPlugin::saveCardToSql(const quickevent::core::si::ReadCardData &read_card)
 {
 	{
 		// create fake punch from finish station for speaker if it doesn't exists already
 		quickevent::core::si::PunchRecord punch;
-		punch.setsiid(read_card.cardNumber());
-		punch.setrunid(read_card.runId());
-		punch.settime(read_card.finishTime());
+		punch.setsiid(read_card.cardNumber);
+		punch.setrunid(read_card.runId);
+		punch.settime(read_card.finishTime);
 		punch.setcode(quickevent::core::CodeDef::FINISH_PUNCH_CODE);
 		int punch_id = savePunchRecordToSql(punch);
 		if(punch_id > 0) {
@@ -269,27 +320,28 @@ int CardReaderPlugin::saveCardToSql(const quickevent::core::si::ReadCard &read_c
 			getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_PUNCH_RECEIVED, punch, true);
 		}
 	}
+	return insertCardSql(read_card, currentStageId(), qf::core::sql::Connection::defaultConnection().connectionId(), qf::core::sql::Connection::forName());
+}
+
+int CardReaderPlugin::insertCardSql(const quickevent::core::si::ReadCardData &read_card, int stage_id, int reader_connection_id, const qf::core::sql::Connection &conn)
+{
 	int ret = 0;
-	QStringList punches;
-	for(auto v : read_card.punches()) {
-		quickevent::core::si::ReadPunch p(v.toMap());
-		punches << p.toJsonArrayString();
-	}
-	qf::core::sql::Query q;
-	q.prepare(QStringLiteral("INSERT INTO cards (stationNumber, siId, checkTime, startTime, finishTime, punches, runId, stageId, readerConnectionId, runIdAssignError)"
-							 " VALUES (:stationNumber, :siId, :checkTime, :startTime, :finishTime, :punches, :runId, :stageId, :readerConnectionId, :runIdAssignError)")
-			  , qf::core::Exception::Throw);
-	q.bindValue(QStringLiteral(":stationNumber"), read_card.stationNumber());
-	q.bindValue(QStringLiteral(":siId"), read_card.cardNumber());
-	q.bindValue(QStringLiteral(":checkTime"), read_card.checkTime());
-	q.bindValue(QStringLiteral(":startTime"), read_card.startTime());
-	q.bindValue(QStringLiteral(":finishTime"), read_card.finishTime());
-	q.bindValue(QStringLiteral(":punches"), '[' + punches.join(", ") + ']');
-	q.bindValue(QStringLiteral(":runId"), read_card.runId());
-	q.bindValue(QStringLiteral(":stageId"), currentStageId());
-	q.bindValue(QStringLiteral(":readerConnectionId"), qf::core::sql::Connection::defaultConnection().connectionId());
-	q.bindValue(QStringLiteral(":runIdAssignError"), read_card.runIdAssignError());
-	if(q.exec()) {
+	qf::core::sql::Query q(conn);
+	bool ok = q.execCached(QStringLiteral("INSERT INTO cards (stationNumber, siId, checkTime, startTime, finishTime, punches, runId, stageId, readerConnectionId, runIdAssignError)"
+										  " VALUES (:stationNumber, :siId, :checkTime, :startTime, :finishTime, :punches, :runId, :stageId, :readerConnectionId, :runIdAssignError)")
+						   , QVariantMap {
+							   {QStringLiteral(":stationNumber"), read_card.stationNumber},
+							   {QStringLiteral(":siId"), read_card.cardNumber},
+							   {QStringLiteral(":checkTime"), read_card.checkTime},
+							   {QStringLiteral(":startTime"), read_card.startTime},
+							   {QStringLiteral(":finishTime"), read_card.finishTime},
+							   {QStringLiteral(":punches"), read_card.punchesToJsonString()},
+							   {QStringLiteral(":runId"), read_card.runId},
+							   {QStringLiteral(":stageId"), stage_id},
+							   {QStringLiteral(":readerConnectionId"), reader_connection_id},
+							   {QStringLiteral(":runIdAssignError"), read_card.runIdAssignError},
+						   });
+	if(ok) {
 		ret = q.lastInsertId().toInt();
 	}
 	else {
@@ -301,39 +353,44 @@ int CardReaderPlugin::saveCardToSql(const quickevent::core::si::ReadCard &read_c
 int CardReaderPlugin::savePunchRecordToSql(const quickevent::core::si::PunchRecord &punch_record)
 {
 	//qfInfo() << "PUNCH:" << punch_record.toString();
-	int ret = 0;
 	quickevent::core::si::PunchRecord punch = punch_record;
 	punch.setstageid(currentStageId());
 
 	int time_msec = getPlugin<EventPlugin>()->msecToStageStartAM(punch_record.time(), punch_record.msec());
 	punch.settimems(time_msec);
-	qf::core::sql::Query q;
+	punch.setcode(resolveAltCode(punch.code(), punch.stageid()));
+	return insertPunchRecordSql(punch, qf::core::sql::Connection::forName());
+}
+
+int CardReaderPlugin::insertPunchRecordSql(const quickevent::core::si::PunchRecord &punch_record, const qf::core::sql::Connection &conn)
+{
+	int ret = 0;
+	quickevent::core::si::PunchRecord punch = punch_record;
+	qf::core::sql::Query q(conn);
 	int run_id = punch.runid();
 	if(run_id > 0) {
-		q.exec("SELECT startTimeMs FROM runs WHERE id=" QF_IARG(run_id), qf::core::Exception::Throw);
+		q.execCached(QStringLiteral("SELECT startTimeMs FROM runs WHERE id=:runId"), QVariantMap{{QStringLiteral(":runId"), run_id}}, qf::core::Exception::Throw);
 		if(q.next()) {
 			QVariant v = q.value(0);
 			if(!v.isNull()) {
-				punch.setruntimems(time_msec - v.toInt());
+				punch.setruntimems(punch.timems() - v.toInt());
 			}
 		}
 	}
-
-	int code = resolveAltCode(punch.code(), punch.stageid());
-
-	q.prepare(QStringLiteral("INSERT INTO punches (siId, code, time, msec, runId, stageId, timeMs, runTimeMs)"
-							 " VALUES (:siId, :code, :time, :msec, :runId, :stageId, :timeMs, :runTimeMs)")
-							, qf::core::Exception::Throw);
-	q.bindValue(QStringLiteral(":siId"), punch.siid());
-	q.bindValue(QStringLiteral(":code"), code);
-	q.bindValue(QStringLiteral(":time"), punch.time());
-	q.bindValue(QStringLiteral(":msec"), punch.msec());
-	q.bindValue(QStringLiteral(":runId"), punch.runid());
-	q.bindValue(QStringLiteral(":stageId"), punch.stageid());
-	q.bindValue(QStringLiteral(":timeMs"), punch.timems());
-	q.bindValue(QStringLiteral(":runTimeMs"), punch.runtimems_isset()? punch.runtimems(): QVariant());
 	/// it is not possible to save punch time as date-time to be independent on start00 since it depends on start00 due to 12H time format
-	if(q.exec()) {
+	bool ok = q.execCached(QStringLiteral("INSERT INTO punches (siId, code, time, msec, runId, stageId, timeMs, runTimeMs)"
+										  " VALUES (:siId, :code, :time, :msec, :runId, :stageId, :timeMs, :runTimeMs)")
+						   , QVariantMap {
+							   {QStringLiteral(":siId"), punch.siid()},
+							   {QStringLiteral(":code"), punch.code()},
+							   {QStringLiteral(":time"), punch.time()},
+							   {QStringLiteral(":msec"), punch.msec()},
+							   {QStringLiteral(":runId"), punch.runid()},
+							   {QStringLiteral(":stageId"), punch.stageid()},
+							   {QStringLiteral(":timeMs"), punch.timems()},
+							   {QStringLiteral(":runTimeMs"), punch.runtimems_isset()? punch.runtimems(): QVariant()},
+						   });
+	if(ok) {
 		ret = q.lastInsertId().toInt();
 	}
 	else {
@@ -342,48 +399,119 @@ int CardReaderPlugin::savePunchRecordToSql(const quickevent::core::si::PunchReco
 	return ret;
 }
 
-void CardReaderPlugin::updateCheckedCardValuesSql(const quickevent::core::si::CheckedCard &checked_card) noexcept(false)
+bool CardReaderPlugin::enqueueReadCard(const quickevent::core::si::ReadCardData &read_card)
+{
+	CardReader::CardCheckerCpp *cpp_chk = qobject_cast<CardReader::CardCheckerCpp*>(currentCardChecker());
+	if(!cpp_chk)
+		return false;
+	if(getPlugin<EventPlugin>()->eventConfig()->isRelays())
+		return false;
+	if(!m_cardProcessor) {
+		qf::core::sql::Connection conn = qf::core::sql::Connection::forName();
+		if(!conn.isOpen())
+			return false;
+		m_readerConnectionId = conn.connectionId();
+		m_cardProcessor = new CardProcessor(conn.connectionName(), this);
+		connect(m_cardProcessor, &CardProcessor::cardProcessed, this, &CardReaderPlugin::onCardProcessed, Qt::QueuedConnection);
+		m_cardProcessor->start();
+	}
+	CardProcessorJob job;
+	job.readCard = read_card;
+	job.eventName = getPlugin<EventPlugin>()->eventName();
+	job.stageId = currentStageId();
+	job.readerConnectionId = m_readerConnectionId;
+	job.finishTimeMs = getPlugin<EventPlugin>()->msecToStageStartAM(read_card.finishTime);
+	job.cardChecker = cpp_chk;
+	if(read_card.runId > 0)
+		job.checkContext = cpp_chk->loadCheckContext(read_card.runId);
+	job.enqueuedTimer.start();
+	if(!m_cardProcessor->tryEnqueue(job)) {
+		/// GUI thread must not wait for worker, card is not lost, it is processed synchronously
+		qfError() << "Card processor queue is full, length:" << m_cardProcessor->queueLength()
+				  << "card SI:" << read_card.cardNumber << "will be processed in GUI thread";
+		return false;
+	}
+	return true;
+}
+
+void CardReaderPlugin::onCardProcessed(const CardProcessorResult &result)
+{
+	if(result.eventName != getPlugin<EventPlugin>()->eventName()) {
+		qfWarning() << "Card SI:" << result.readCard.cardNumber << "processed in event:" << result.eventName
+					<< "which is not open anymore, result is ignored";
+		return;
+	}
+	if(!result.error.isEmpty()) {
+		qfError() << "Process card SI:" << result.readCard.cardNumber << "ERROR:" << result.error;
+		return;
+	}
+	/// db events are emitted after card processor transaction is committed
+	if(result.finishPunch.id() > 0)
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_PUNCH_RECEIVED, result.finishPunch, true);
+	if(result.checkedCard.runId > 0)
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED, result.checkedCard.toCheckedCard(), true);
+	if(result.cardId > 0) {
+		/// receipts printer needs this
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_CARD_READ, result.cardId, true);
+	}
+	qfInfo() << "Card SI:" << result.readCard.cardNumber << "processed, latency:" << result.latencyMs << "msec,"
+			 << "queue length:" << (m_cardProcessor? m_cardProcessor->queueLength(): 0)
+			 << "max latency:" << (m_cardProcessor? m_cardProcessor->maxLatencyMs(): 0) << "msec";
+}
+
+void CardReaderPlugin::stopCardProcessor()
+{
+	if(!m_cardProcessor)
+		return;
+	/// cards in queue are saved before connection is closed
+	m_cardProcessor->stop();
+	delete m_cardProcessor;
+	m_cardProcessor = nullptr;
+}
+
+void CardReaderPlugin::updateCheckedCardValuesSql(const quickevent::core::si::CheckedCardData &checked_card, const qf::core::sql::Connection &conn) noexcept(false)
 {
 	QF_TIME_SCOPE("updateCheckedCardValuesSql()");
-	int run_id = checked_card.runId();
+	int run_id = checked_card.runId;
 	if(run_id <= 0)
 		QF_EXCEPTION("Card doesn't contain runId information!");
-	auto cc = qf::core::sql::Connection::forName();
-	qf::core::sql::Query q(cc);
+	qf::core::sql::Query q(conn);
 	{
 		QF_TIME_SCOPE("DELETE FROM runlaps");
-		q.exec("DELETE FROM runlaps WHERE runId=" + QString::number(run_id), qf::core::Exception::Throw);
+		q.execCached(QStringLiteral("DELETE FROM runlaps WHERE runId=:runId"), QVariantMap{{QStringLiteral(":runId"), run_id}}, qf::core::Exception::Throw);
 	}
-	q.prepare(QStringLiteral("INSERT INTO runlaps (runId, position, code, stpTimeMs, lapTimeMs)"
-							 " VALUES (:runId, :position, :code, :stpTimeMs, :lapTimeMs)"), qf::core::Exception::Throw);
-	auto punch_list = checked_card.punches();
-	if(punch_list.count()) {
-		QF_TIME_SCOPE("INSERT INTO runlaps, records cnt: " + QString::number(punch_list.count()));
+	if(checked_card.punches.count()) {
+		QF_TIME_SCOPE("INSERT INTO runlaps, records cnt: " + QString::number(checked_card.punches.count()));
 		int position = 0;
-		for(auto v : punch_list) {
+		for(const quickevent::core::si::CheckedPunchData &cp : checked_card.punches) {
 			position++;
-			quickevent::core::si::CheckedPunch cp(v.toMap());
-			//qfInfo() << run_id << position << cp;
-			if(cp.stpTimeMs() > 0) {
-				q.bindValue(QStringLiteral(":runId"), run_id);
-				q.bindValue(QStringLiteral(":code"), cp.code());
-				q.bindValue(QStringLiteral(":position"), position);
-				q.bindValue(QStringLiteral(":stpTimeMs"), cp.stpTimeMs());
-				q.bindValue(QStringLiteral(":lapTimeMs"), cp.lapTimeMs());
-				q.exec(qf::core::Exception::Throw);
+			if(cp.stpTimeMs > 0) {
+				q.execCached(QStringLiteral("INSERT INTO runlaps (runId, position, code, stpTimeMs, lapTimeMs)"
+											" VALUES (:runId, :position, :code, :stpTimeMs, :lapTimeMs)")
+							 , QVariantMap {
+								 {QStringLiteral(":runId"), run_id},
+								 {QStringLiteral(":code"), cp.code},
+								 {QStringLiteral(":position"), position},
+								 {QStringLiteral(":stpTimeMs"), cp.stpTimeMs},
+								 {QStringLiteral(":lapTimeMs"), cp.lapTimeMs},
+							 }
+							 , qf::core::Exception::Throw);
 			}
 		}
 	}
-	q.prepare("UPDATE runs SET checkTimeMs=:checkTimeMs, timeMs=:timeMs, finishTimeMs=:finishTimeMs, penaltyTimeMs=NULL,"
-			  " misPunch=:misPunch, badCheck=:badCheck, disqualified=:disqualified"
-			  " WHERE id=" + QString::number(run_id), qf::core::Exception::Throw);
-	q.bindValue(QStringLiteral(":checkTimeMs"), checked_card.checkTimeMs());
-	q.bindValue(QStringLiteral(":timeMs"), checked_card.timeMs());
-	q.bindValue(QStringLiteral(":finishTimeMs"), checked_card.finishTimeMs());
-	q.bindValue(QStringLiteral(":misPunch"), checked_card.isMisPunch());
-	q.bindValue(QStringLiteral(":badCheck"), checked_card.isBadCheck());
-	q.bindValue(QStringLiteral(":disqualified"), !checked_card.isOk());
-	q.exec(qf::core::Exception::Throw);
+	q.execCached(QStringLiteral("UPDATE runs SET checkTimeMs=:checkTimeMs, timeMs=:timeMs, finishTimeMs=:finishTimeMs, penaltyTimeMs=NULL,"
+								" misPunch=:misPunch, badCheck=:badCheck, disqualified=:disqualified"
+								" WHERE id=:id")
+				 , QVariantMap {
+					 {QStringLiteral(":checkTimeMs"), checked_card.checkTimeMs},
+					 {QStringLiteral(":timeMs"), checked_card.timeMs()},
+					 {QStringLiteral(":finishTimeMs"), checked_card.finishTimeMs},
+					 {QStringLiteral(":misPunch"), checked_card.misPunch},
+					 {QStringLiteral(":badCheck"), checked_card.badCheck},
+					 {QStringLiteral(":disqualified"), !checked_card.isOk()},
+					 {QStringLiteral(":id"), run_id},
+				 }
+				 , qf::core::Exception::Throw);
 	if(q.numRowsAffected() != 1)
 		QF_EXCEPTION("Update runs error!");
 	/*
@@ -407,30 +535,107 @@ void CardReaderPlugin::updateCheckedCardValuesSql(const quickevent::core::si::Ch
 	*/
 }
 
+void CardReaderPlugin::updateCheckedCardsValuesSql(const QVector<quickevent::core::si::CheckedCardData> &checked_cards) noexcept(false)
+{
+	QF_TIME_SCOPE("updateCheckedCardsValuesSql()");
+	QVariantList run_ids;
+	QVariantList lap_run_ids, lap_positions, lap_codes, lap_stp_times, lap_lap_times;
+	QVariantList check_times, times, finish_times, mis_punches, bad_checks, disqualifieds;
+	for(const quickevent::core::si::CheckedCardData &checked_card : checked_cards) {
+		int run_id = checked_card.runId;
+		if(run_id <= 0)
+			QF_EXCEPTION("Card doesn't contain runId information!");
+		run_ids << run_id;
+		int position = 0;
+		for(const quickevent::core::si::CheckedPunchData &cp : checked_card.punches) {
+			position++;
+			if(cp.stpTimeMs > 0) {
+				lap_run_ids << run_id;
+				lap_positions << position;
+				lap_codes << cp.code;
+				lap_stp_times << cp.stpTimeMs;
+				lap_lap_times << cp.lapTimeMs;
+			}
+		}
+		check_times << checked_card.checkTimeMs;
+		times << checked_card.timeMs();
+		finish_times << checked_card.finishTimeMs;
+		mis_punches << checked_card.misPunch;
+		bad_checks << checked_card.badCheck;
+		disqualifieds << !checked_card.isOk();
+	}
+	if(run_ids.isEmpty())
+		return;
+	auto cc = qf::core::sql::Connection::forName();
+	qf::core::sql::Query q(cc);
+	auto exec_batch = [&q]() {
+		if(!q.execBatch())
+			QF_EXCEPTION(q.lastErrorText());
+	};
+	{
+		QF_TIME_SCOPE("DELETE FROM runlaps");
+		q.prepare(QStringLiteral("DELETE FROM runlaps WHERE runId=:runId"), qf::core::Exception::Throw);
+		q.bindValue(QStringLiteral(":runId"), run_ids);
+		exec_batch();
+	}
+	if(!lap_run_ids.isEmpty()) {
+		QF_TIME_SCOPE("INSERT INTO runlaps, records cnt: " + QString::number(lap_run_ids.count()));
+		q.prepare(QStringLiteral("INSERT INTO runlaps (runId, position, code, stpTimeMs, lapTimeMs)"
+								 " VALUES (:runId, :position, :code, :stpTimeMs, :lapTimeMs)"), qf::core::Exception::Throw);
+		q.bindValue(QStringLiteral(":runId"), lap_run_ids);
+		q.bindValue(QStringLiteral(":position"), lap_positions);
+		q.bindValue(QStringLiteral(":code"), lap_codes);
+		q.bindValue(QStringLiteral(":stpTimeMs"), lap_stp_times);
+		q.bindValue(QStringLiteral(":lapTimeMs"), lap_lap_times);
+		exec_batch();
+	}
+	{
+		QF_TIME_SCOPE("UPDATE runs, records cnt: " + QString::number(run_ids.count()));
+		q.prepare(QStringLiteral("UPDATE runs SET checkTimeMs=:checkTimeMs, timeMs=:timeMs, finishTimeMs=:finishTimeMs, penaltyTimeMs=NULL,"
+								 " misPunch=:misPunch, badCheck=:badCheck, disqualified=:disqualified"
+								 " WHERE id=:id"), qf::core::Exception::Throw);
+		q.bindValue(QStringLiteral(":checkTimeMs"), check_times);
+		q.bindValue(QStringLiteral(":timeMs"), times);
+		q.bindValue(QStringLiteral(":finishTimeMs"), finish_times);
+		q.bindValue(QStringLiteral(":misPunch"), mis_punches);
+		q.bindValue(QStringLiteral(":badCheck"), bad_checks);
+		q.bindValue(QStringLiteral(":disqualified"), disqualifieds);
+		q.bindValue(QStringLiteral(":id"), run_ids);
+		exec_batch();
+	}
+}
+
 void CardReaderPlugin::updateCardToRunAssignmentInPunches(int stage_id, int card_id, int run_id)
 {
 	qfLogFuncFrame();
 	int si_id = cardIdToSiId(card_id);
-	if(si_id > 0) {
-		QString qs = "UPDATE punches SET runId=" QF_IARG(run_id)
-					" WHERE stageId=" QF_IARG(stage_id)
-					" AND siId=" QF_IARG(si_id)
-					" AND (runId IS NULL OR runId=0)";
-		qfDebug() << qs;
-		qf::core::sql::Query q;
-		q.execThrow(qs);
-	}
+	if(si_id > 0)
+		updateCardToRunAssignmentInPunchesSql(stage_id, si_id, run_id, qf::core::sql::Connection::forName());
 }
 
-bool CardReaderPlugin::saveCardAssignedRunnerIdSql(int card_id, int run_id)
+void CardReaderPlugin::updateCardToRunAssignmentInPunchesSql(int stage_id, int si_id, int run_id, const qf::core::sql::Connection &conn)
+{
+	qf::core::sql::Query q(conn);
+	q.execCached(QStringLiteral("UPDATE punches SET runId=:runId"
+								" WHERE stageId=:stageId AND siId=:siId AND (runId IS NULL OR runId=0)")
+				 , QVariantMap {
+					 {QStringLiteral(":runId"), run_id},
+					 {QStringLiteral(":stageId"), stage_id},
+					 {QStringLiteral(":siId"), si_id},
+				 }
+				 , qf::core::Exception::Throw);
+}
+
+bool CardReaderPlugin::saveCardAssignedRunnerIdSql(int card_id, int run_id, const qf::core::sql::Connection &conn)
 {
 	QF_TIME_SCOPE("saveCardAssignedRunnerIdSql()");
-	auto cc = qf::core::sql::Connection::forName();
-	qf::core::sql::Query q(cc);
+	qf::core::sql::Query q(conn);
 	QString now = QStringLiteral("now()");
-	if(cc.driverName().endsWith("SQLITE", Qt::CaseInsensitive))
+	if(conn.driverName().endsWith("SQLITE", Qt::CaseInsensitive))
 		now = QStringLiteral("CURRENT_TIMESTAMP");
-	bool ret = q.exec("UPDATE cards SET runId=" QF_IARG(run_id) ", runIdAssignTS=" + now + " WHERE id=" QF_IARG(card_id), !qf::core::Exception::Throw);
+	bool ret = q.execCached("UPDATE cards SET runId=:runId, runIdAssignTS=" + now + " WHERE id=:id"
+							, QVariantMap {{QStringLiteral(":runId"), run_id}, {QStringLiteral(":id"), card_id}}
+							, !qf::core::Exception::Throw);
 	return ret;
 }
 
@@ -475,7 +680,7 @@ bool CardReaderPlugin::reloadTimesFromCard(int card_id, int run_id, bool in_tran
 void CardReaderPlugin::assignCardToRun(int card_id, int run_id)
 {
 	updateCardToRunAssignmentInPunches(currentStageId(), card_id, run_id);
-	saveCardAssignedRunnerIdSql(card_id, run_id);
+	saveCardAssignedRunnerIdSql(card_id, run_id, qf::core::sql::Connection::forName());
 	processCardToRunAssignment(card_id, run_id);
 }
 
@@ -505,13 +710,14 @@ bool CardReaderPlugin::processCardToRunAssignment(int card_id, int run_id)
 						   + " WHERE relayId=" + QString::number(relay_id)
 						   + " AND leg=" + QString::number(leg)
 						   + " AND COALESCE(startTimeMs, 0)=0");
+					m_runSiIndex.setStartTimeMs(run_id, prev_finish_time);
 				}
 			}
 		}
-		quickevent::core::si::CheckedCard checked_card = checkCard(card_id, run_id);
+		quickevent::core::si::CheckedCardData checked_card = checkCard(card_id, run_id);
 		//qfDebug() << checked_card.toString();
-		updateCheckedCardValuesSql(checked_card);
-		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED, checked_card, true);
+		updateCheckedCardValuesSql(checked_card, qf::core::sql::Connection::forName());
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED, checked_card.toCheckedCard(), true);
 
 		/// if next leg is finished and has not start time set, proces it too
 		/// This covers cases when next leg is read-out before this one
@@ -529,13 +735,105 @@ bool CardReaderPlugin::processCardToRunAssignment(int card_id, int run_id)
 		}
 	}
 	else {
-		quickevent::core::si::CheckedCard checked_card = checkCard(card_id, run_id);
-		updateCheckedCardValuesSql(checked_card);
-		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED, checked_card, true);
+		quickevent::core::si::CheckedCardData checked_card = checkCard(card_id, run_id);
+		updateCheckedCardValuesSql(checked_card, qf::core::sql::Connection::forName());
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED, checked_card.toCheckedCard(), true);
 	}
 	return true;
 }
 
+int CardReaderPlugin::checkCards(int stage_id)
+{
+	qfLogFuncFrame() << "stage id:" << stage_id;
+	QF_TIME_SCOPE("checkCards()");
+	qff::MainWindow *fwk = qff::MainWindow::frameWork();
+	/// last assigned card for each run, see RunsPlugin::cardForRun()
+	QVector<int> card_ids;
+	QVector<quickevent::core::si::ReadCardData> read_cards;
+	{
+		qf::core::sql::Query q;
+		q.execThrow("SELECT * FROM cards WHERE stageId=" QF_IARG(stage_id) " AND runId>0 ORDER BY runId, runIdAssignTS DESC");
+		int prev_run_id = 0;
+		while(q.next()) {
+			quickevent::core::si::ReadCardData rc = quickevent::core::si::ReadCardData::fromSqlRecord(q.record());
+			if(rc.runId == prev_run_id)
+				continue;
+			prev_run_id = rc.runId;
+			card_ids << q.value(QStringLiteral("id")).toInt();
+			read_cards << rc;
+		}
+	}
+	const int card_cnt = read_cards.count();
+	try {
+		qf::core::sql::Transaction transaction;
+		CardReader::CardCheckerCpp *cpp_chk = qobject_cast<CardReader::CardCheckerCpp*>(currentCardChecker());
+		bool is_relays = getPlugin<EventPlugin>()->eventConfig()->isRelays();
+		if(!cpp_chk || is_relays) {
+			/// QML checker cannot leave GUI thread and relay legs depend on each other
+			for (int i = 0; i < card_cnt; ++i) {
+				fwk->showProgress(tr("Checking cards"), i + 1, card_cnt);
+				processCardToRunAssignment(card_ids[i], read_cards[i].runId);
+			}
+		}
+		else {
+			QVector<CardCheckerCpp::CheckContext> contexts;
+			contexts.reserve(card_cnt);
+			{
+				QHash<int, RunCoursePlan> run_plans = m_coursePlanCache.stageRunCoursePlans(stage_id);
+				CardCheckerCpp::CheckContext stage_context;
+				stage_context.stageStartSec = cpp_chk->stageStartSec(stage_id);
+				stage_context.cardCheckCheckTimeSec = cpp_chk->cardCheckCheckTimeSec();
+				for(const quickevent::core::si::ReadCardData &rc : read_cards) {
+					auto it = run_plans.constFind(rc.runId);
+					if(it == run_plans.constEnd()) {
+						contexts << cpp_chk->loadCheckContext(rc.runId);
+					}
+					else {
+						CardCheckerCpp::CheckContext ctx = stage_context;
+						ctx.run = it.value();
+						contexts << ctx;
+					}
+				}
+			}
+			/// checker is pure function of card and context, check cards in parallel,
+			/// chunk by chunk to be able to show progress
+			QVector<quickevent::core::si::CheckedCardData> checked_cards(card_cnt);
+			{
+				QF_TIME_SCOPE("check cards");
+				const quickevent::core::si::ReadCardData *read_cards_data = read_cards.constData();
+				const CardCheckerCpp::CheckContext *contexts_data = contexts.constData();
+				quickevent::core::si::CheckedCardData *checked_cards_data = checked_cards.data();
+				static constexpr int CHUNK_SIZE = 256;
+				for (int chunk_start = 0; chunk_start < card_cnt; chunk_start += CHUNK_SIZE) {
+					fwk->showProgress(tr("Checking cards"), chunk_start, card_cnt);
+					QVector<int> ixs;
+					for (int i = chunk_start; i < card_cnt && i < chunk_start + CHUNK_SIZE; ++i)
+						ixs << i;
+					QtConcurrent::blockingMap(ixs, [cpp_chk, read_cards_data, contexts_data, checked_cards_data](int ix) {
+						quickevent::core::si::CheckedCardData cc = cpp_chk->checkCard(read_cards_data[ix], contexts_data[ix]);
+						cc.runId = read_cards_data[ix].runId;
+						cc.cardNumber = read_cards_data[ix].cardNumber;
+						checked_cards_data[ix] = cc;
+					});
+				}
+			}
+			fwk->showProgress(tr("Saving card check results"), card_cnt, card_cnt);
+			updateCheckedCardsValuesSql(checked_cards);
+		}
+		transaction.commit();
+		/// single event for whole batch, listeners reload runs after commit instead of handling every card
+		if(card_cnt > 0)
+			getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_RUNS_CHANGED, QVariant(), true);
+	}
+	catch (const qf::core::Exception &e) {
+		qfError() << "checkCards ERROR:" << e.message();
+		fwk->hideProgress();
+		return -1;
+	}
+	fwk->hideProgress();
+	return card_cnt;
+}
+
 int CardReaderPlugin::resolveAltCode(int maybe_alt_code, int stage_id)
 {
 	int resolved_code = 0;
@@ -1,18 +1,24 @@
 #ifndef CARDREADER_CARDREADERPLUGIN_H
 #define CARDREADER_CARDREADERPLUGIN_H
 
+#include "courseplancache.h"
+#include "runsiindex.h"
+
 #include <qf/core/utils.h>
 #include <qf/qmlwidgets/framework/plugin.h>
 
 #include <QQmlListProperty>
 
-namespace quickevent { namespace core { namespace si { class PunchRecord; class ReadCard; class CheckedCard; }}}
+namespace quickevent { namespace core { namespace si { class PunchRecord; class ReadCard; class CheckedCard; struct ReadCardData; struct CheckedCardData; }}}
 
 namespace siut { class SIMessageData; }
+namespace qf { namespace core { namespace sql { class Connection; }}}
 
 namespace CardReader {
 
 class CardChecker;
+class CardProcessor;
+struct CardProcessorResult;
 class ReadCard;
 class PunchRecord;
 class CheckedCard;
@@ -43,30 +49,57 @@ public:
 	int findRunId(int si_id, int si_finish_time, QString *err_msg = nullptr);
 	bool isCardLent(int si_id, int si_finish_time, int run_id);
 	quickevent::core::si::ReadCard readCard(int card_id);
-	quickevent::core::si::CheckedCard checkCard(int card_id, int run_id = 0);
+	quickevent::core::si::ReadCardData readCardData(int card_id);
+	quickevent::core::si::CheckedCardData checkCard(int card_id, int run_id = 0);
 	quickevent::core::si::CheckedCard checkCard(const quickevent::core::si::ReadCard &read_card);
-	int saveCardToSql(const quickevent::core::si::ReadCard &read_card);
+	quickevent::core::si::CheckedCardData checkCard(const quickevent::core::si::ReadCardData &read_card);
+	int saveCardToSql(const quickevent::core::si::ReadCardData &read_card);
 	int savePunchRecordToSql(const quickevent::core::si::PunchRecord &punch_record);
+	/// SQL writes of card processing on explicit connection, they are used by CardProcessor thread too
+	static int insertCardSql(const quickevent::core::si::ReadCardData &read_card, int stage_id, int reader_connection_id, const qf::core::sql::Connection &conn);
+	/// punch stageId, timeMs and resolved code must be set already
+	static int insertPunchRecordSql(const quickevent::core::si::PunchRecord &punch_record, const qf::core::sql::Connection &conn);
+	static void updateCardToRunAssignmentInPunchesSql(int stage_id, int si_id, int run_id, const qf::core::sql::Connection &conn);
+	static bool saveCardAssignedRunnerIdSql(int card_id, int run_id, const qf::core::sql::Connection &conn);
+	static void updateCheckedCardValuesSql(const quickevent::core::si::CheckedCardData &checked_card, const qf::core::sql::Connection &conn) noexcept(false);
 	//ReadCard loadCardFromSql(int card_id);
 	//bool updateCheckedCardValuesSqlSafe(const quickevent::core::si::CheckedCard &checked_card);
 
+	/// save and check card in CardProcessor thread, returns false when card has to be processed in GUI thread
+	/// relay legs depend on each other and QML checkers cannot leave GUI thread
+	bool enqueueReadCard(const quickevent::core::si::ReadCardData &read_card);
+	CardProcessor* cardProcessor() {return m_cardProcessor;}
+	Q_SLOT void stopCardProcessor();
+
 	Q_INVOKABLE bool reloadTimesFromCard(int card_id, int run_id = 0, bool in_transaction = true);
 	void assignCardToRun(int card_id, int run_id);
 	bool processCardToRunAssignment(int card_id, int run_id);
+	/// re-check all the cards assigned to runs in stage and save results in single transaction,
+	/// returns number of checked cards or -1 on error
+	int checkCards(int stage_id);
 
 	static int resolveAltCode(int maybe_alt_code, int stage_id);
 
+	CoursePlanCache& coursePlanCache() {return m_coursePlanCache;}
+	Q_SLOT void clearCoursePlanCache();
+	Q_SLOT void clearRunSiIndex();
+
 	void emitSiTaskFinished(int task_type, QVariant result) { emit siTaskFinished(task_type, result); }
 	Q_SIGNAL void siTaskFinished(int task_type, QVariant result);
 private:
 	void onInstalled();
+	void onDbEventNotify(const QString &domain, int connection_id, const QVariant &data);
 	QQmlListProperty<CardChecker> cardCheckersListProperty();
+	void onCardProcessed(const CardReader::CardProcessorResult &result);
 
 	void updateCardToRunAssignmentInPunches(int stage_id, int card_id, int run_id);
-	bool saveCardAssignedRunnerIdSql(int card_id, int run_id);
-	void updateCheckedCardValuesSql(const quickevent::core::si::CheckedCard &checked_card) noexcept(false);
+	void updateCheckedCardsValuesSql(const QVector<quickevent::core::si::CheckedCardData> &checked_cards) noexcept(false);
 private:
 	QList<CardChecker*> m_cardCheckers;
+	CoursePlanCache m_coursePlanCache;
+	RunSiIndex m_runSiIndex;
+	CardProcessor *m_cardProcessor = nullptr;
+	int m_readerConnectionId = 0;
 };
 
 }
@@ -6,6 +6,9 @@
 #include "cardchecker.h"
 #include "cardreaderplugin.h"
 
+#include "../../../src/application.h"
+#include "../../../src/appclioptions.h"
+
 #include <quickevent/gui/og/itemdelegate.h>
 #include <quickevent/gui/audio/player.h>
 
@@ -14,6 +17,7 @@
 #include <quickevent/core/og/sqltablemodel.h>
 #include <quickevent/core/si/punchrecord.h>
 #include <quickevent/core/si/readcard.h>
+#include <quickevent/core/si/carddata.h>
 #include <quickevent/core/si/checkedcard.h>
 #include <quickevent/core/si/siid.h>
 
@@ -21,6 +25,7 @@
 #include <siut/commport.h>
 #include <siut/sicard.h>
 #include <siut/sitask.h>
+#include <siut/simulatedstation.h>
 
 #include <qf/qmlwidgets/action.h>
 #include <qf/qmlwidgets/framework/application.h>
@@ -59,6 +64,7 @@
 #include <QCheckBox>
 #include <QPushButton>
 #include <QProgressDialog>
+#include <QInputDialog>
 #include <QTimer>
 #include <QSerialPortInfo>
 
@@ -185,6 +191,8 @@ CardReaderWidget::CardReaderWidget(QWidget *parent)
 		ui->tblCards->setInlineEditSaveStrategy(qfw::TableView::OnEditedValueCommit);
 		ui->tblCards->setItemDelegate(new quickevent::gui::og::ItemDelegate(ui->tblCards));
 		auto m = new Model(this);
+		/// cards table of multi-day event can be long, show first rows immediately
+		m->setFetchChunkSize(500);
 		ui->tblCards->setTableModel(m);
 		m_cardsModel = m;
 	}
@@ -345,6 +353,23 @@ void CardReaderWidget::settleDownInPartWidget(quickevent::gui::PartWidget *part_
 				m_import_cards->addActionInto(a);
 			}
 		}
+		{
+			qfw::Action *a = new qfw::Action(tr("Recalculate times for all cards in stage"));
+			connect(a, &qf::qmlwidgets::Action::triggered, this, [this]() {
+				int stage_id = getPlugin<CardReaderPlugin>()->currentStageId();
+				int n = getPlugin<CardReaderPlugin>()->checkCards(stage_id);
+				if(n < 0)
+					qf::qmlwidgets::dialogs::MessageBox::showError(this, tr("Recalculate times error, see application log for details."));
+				reload();
+			});
+			a_tools->addActionInto(a);
+		}
+		/// simulator saves generated cards to current stage, it is not available without command line switch
+		if(Application::instance()->cliOptions()->appSiSimulator()) {
+			qfw::Action *a = new qfw::Action(tr("SI station simulator"));
+			connect(a, &qf::qmlwidgets::Action::triggered, this, &CardReaderWidget::runSimulatedStation);
+			a_tools->addActionInto(a);
+		}
 		{
 			qfw::Action *a = new qfw::Action(tr("Test audio"));
 			connect(a, &qf::qmlwidgets::Action::triggered, this, &CardReaderWidget::operatorAudioNotify);
@@ -660,13 +685,14 @@ void CardReaderWidget::processSICard(const siut::SICard &card)
 		if(card_lent)
 			operatorAudioNotify();
 	}
-	quickevent::core::si::ReadCard read_card(card);
-	read_card.setRunId(run_id);
-	read_card.setRunIdAssignError(err_msg);
-	processReadCardInTransaction(read_card);
+	quickevent::core::si::ReadCardData read_card = quickevent::core::si::ReadCardData::fromSICard(card);
+	read_card.runId = run_id;
+	read_card.runIdAssignError = err_msg;
+	if(!getPlugin<CardReaderPlugin>()->enqueueReadCard(read_card))
+		processReadCardInTransaction(read_card);
 }
 
-bool CardReaderWidget::processReadCardInTransaction(const quickevent::core::si::ReadCard &read_card)
+bool CardReaderWidget::processReadCardInTransaction(const quickevent::core::si::ReadCardData &read_card)
 {
 	try {
 		qf::core::sql::Transaction transaction;
@@ -680,11 +706,11 @@ bool CardReaderWidget::processReadCardInTransaction(const quickevent::core::si::
 	return false;
 }
 
-void CardReaderWidget::processReadCard(const quickevent::core::si::ReadCard &read_card)
+void CardReaderWidget::processReadCard(const quickevent::core::si::ReadCardData &read_card)
 {
 	int card_id = getPlugin<CardReaderPlugin>()->saveCardToSql(read_card);
-	if(card_id && read_card.runId()) {
-		getPlugin<CardReaderPlugin>()->assignCardToRun(card_id, read_card.runId());
+	if(card_id && read_card.runId) {
+		getPlugin<CardReaderPlugin>()->assignCardToRun(card_id, read_card.runId);
 	}
 	if(card_id) {
 		/// receipts printer needs this
@@ -796,6 +822,7 @@ void CardReaderWidget::assignRunnerToSelectedCard()
 			}
 			q.execThrow(qs);
 		}
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_RUNS_CHANGED);
 
 		this->ui->tblCards->reloadRow();
 
@@ -969,7 +996,7 @@ void CardReaderWidget::importCards_lapsOnlyCsv()
 			read_card.setFinishTime(quickevent::core::si::ReadPunch(punches.takeLast().toMap()).time());
 			read_card.setPunches(punches);
 			qfDebug() << read_card.toString();
-			processReadCard(read_card);
+			processReadCard(quickevent::core::si::ReadCardData::fromReadCard(read_card));
 		}
 		transaction.commit();
 	}
@@ -1154,7 +1181,7 @@ void CardReaderWidget::importCards_SIReaderBackupMemoryCsv()
 			read_card.setFinishTime(quickevent::core::si::ReadPunch(punches.takeLast().toMap()).time());
 			read_card.setPunches(punches);
 			qfDebug() << read_card.toString();
-			processReadCard(read_card);
+			processReadCard(quickevent::core::si::ReadCardData::fromReadCard(read_card));
 		}
 		transaction.commit();
 	}
@@ -1166,6 +1193,8 @@ void CardReaderWidget::importCards_SIReaderBackupMemoryCsv()
 void CardReaderWidget::readStationBackupMemory()
 {
 	siut::SiTaskReadStationBackupMemory *si_task = new siut::SiTaskReadStationBackupMemory();
+	/// keep more block requests in flight, lost ones are requested again
+	si_task->setPipelineDepth(4);
 	connect(si_task, &siut::SiTaskStationConfig::progress, this, [this, si_task](int phase, int count) {
 		QProgressDialog *progress_dlg = this->findChild<QProgressDialog*>(QString(), Qt::FindDirectChildrenOnly);
 		if(progress_dlg == nullptr) {
@@ -1269,5 +1298,78 @@ void CardReaderWidget::readStationBackupMemory()
 	siDriver()->setSiTask(si_task);
 }
 
+void CardReaderWidget::runSimulatedStation()
+{
+	if(m_simulatedStation)
+		return;
+	if(commPort()->isOpen()) {
+		qfd::MessageBox::showError(this, tr("Close COM port before SI station simulator is started."));
+		return;
+	}
+	bool ok;
+	int card_count = QInputDialog::getInt(this, tr("SI station simulator"), tr("Number of generated cards:"), 100, 1, 100000, 1, &ok);
+	if(!ok)
+		return;
+	if(!qfd::MessageBox::askYesNo(this, tr("Generated cards will be saved to current stage, "
+										   "random card numbers can match registered competitors and overwrite their results. "
+										   "Use simulator with testing event only. Continue?"), false))
+		return;
+	siut::DeviceDriver *driver = siDriver();
+	siut::SimulatedStation *station = new siut::SimulatedStation(this);
+	m_simulatedStation = station;
+	disconnect(driver, &siut::DeviceDriver::dataToSend, commPort(), &siut::CommPort::sendData);
+	driver->setTransmitRecordsEnabled(true);
+	connect(driver, &siut::DeviceDriver::dataToSend, station, &siut::SimulatedStation::processData, Qt::QueuedConnection);
+	connect(station, &siut::SimulatedStation::dataReceived, driver, &siut::DeviceDriver::processData, Qt::QueuedConnection);
+
+	QProgressDialog *progress = new QProgressDialog(tr("Reading out generated cards ..."), tr("Cancel"), 0, card_count, this);
+	progress->setWindowModality(Qt::WindowModal);
+	progress->setMinimumDuration(0);
+	connect(station, &QObject::destroyed, progress, &QObject::deleteLater);
+	connect(progress, &QProgressDialog::canceled, this, [this]() {
+		stopSimulatedStation(tr("SI station simulator canceled."));
+	});
+	/// aborted read-out is never finished, simulator is stopped when no card is read-out for a while
+	static constexpr int READ_OUT_TIMEOUT_SEC = 10;
+	QTimer *watchdog = new QTimer(station);
+	watchdog->setSingleShot(true);
+	watchdog->setInterval(READ_OUT_TIMEOUT_SEC * 1000);
+	connect(watchdog, &QTimer::timeout, this, [this]() {
+		stopSimulatedStation(tr("SI station simulator stopped, no card read-out for %1 sec.").arg(READ_OUT_TIMEOUT_SEC));
+	});
+	connect(station, &siut::SimulatedStation::cardReadOut, progress, [progress, station, watchdog]() {
+		progress->setValue(station->readOutCardCount());
+		watchdog->start();
+	});
+	connect(station, &siut::SimulatedStation::generatorFinished, this, [this]() {
+		stopSimulatedStation(QString());
+	}, Qt::QueuedConnection);
+	watchdog->start();
+	/// generate cards faster than they can be processed, generator waits when station queue is full
+	station->startGenerator(card_count, 1000);
+}
+
+void CardReaderWidget::stopSimulatedStation(const QString &reason)
+{
+	siut::SimulatedStation *station = m_simulatedStation;
+	if(!station)
+		return;
+	m_simulatedStation = nullptr;
+	station->stopGenerator();
+	siut::DeviceDriver *driver = siDriver();
+	disconnect(driver, &siut::DeviceDriver::dataToSend, station, &siut::SimulatedStation::processData);
+	disconnect(station, &siut::SimulatedStation::dataReceived, driver, &siut::DeviceDriver::processData);
+	if(!reason.isEmpty())
+		driver->abortSiTask();
+	driver->setTransmitRecordsEnabled(false);
+	connect(driver, &siut::DeviceDriver::dataToSend, commPort(), &siut::CommPort::sendData, Qt::UniqueConnection);
+	QString msg = tr("%1 cards read-out, %2 cards/sec.").arg(station->readOutCardCount()).arg(station->cardsPerSecond(), 0, 'f', 1);
+	if(!reason.isEmpty())
+		msg = reason + ' ' + msg;
+	appendLog(reason.isEmpty()? NecroLog::Level::Info: NecroLog::Level::Warning, msg);
+	station->deleteLater();
+	qfd::MessageBox::showInfo(this, msg);
+}
+
 #include "cardreaderwidget.moc"
 
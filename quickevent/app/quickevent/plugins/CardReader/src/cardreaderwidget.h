@@ -25,10 +25,10 @@ class Plugin;
 }
 }
 
-namespace siut { class DeviceDriver; class CommPort; class SICard; class SIPunch; }
+namespace siut { class DeviceDriver; class CommPort; class SICard; class SIPunch; class SimulatedStation; }
 
 namespace quickevent { namespace gui { namespace audio { class Player; }}}
-namespace quickevent { namespace core { namespace si { class ReadCard; class CheckedCard; }}}
+namespace quickevent { namespace core { namespace si { class ReadCard; class CheckedCard; struct ReadCardData; }}}
 
 namespace CardReader {
 class CardReaderPlugin;
@@ -80,6 +80,10 @@ private slots:
 	void onSiTaskFinished(int task_type, QVariant result);
 
 	void readStationBackupMemory();
+	/// read-out generated cards from simulated SI station to measure card processing throughput
+	void runSimulatedStation();
+	/// connects driver back to COM port, reason is empty when all the generated cards are read-out
+	void stopSimulatedStation(const QString &reason);
 
 	void importCards_lapsOnlyCsv();
 	void importCards_SIReaderBackupMemoryCsv();
@@ -94,8 +98,8 @@ private:
 	void processSICard(const siut::SICard &card);
 	void processSIPunch(const siut::SIPunch &rec);
 
-	bool processReadCardInTransaction(const quickevent::core::si::ReadCard &read_card);
-	void processReadCard(const quickevent::core::si::ReadCard &read_card);
+	bool processReadCardInTransaction(const quickevent::core::si::ReadCardData &read_card);
+	void processReadCard(const quickevent::core::si::ReadCardData &read_card);
 
 	void updateTableView(int card_id);
 
@@ -121,6 +125,7 @@ private:
 	quickevent::gui::audio::Player *m_audioPlayer = nullptr;
 	siut::DeviceDriver *f_siDriver = nullptr;
 	siut::CommPort *m_commPort = nullptr;
+	siut::SimulatedStation *m_simulatedStation = nullptr;
 };
 
 #endif // CARDREADERWIDGET_H
@@ -0,0 +1,172 @@
+#include "courseplancache.h"
+
+#include <quickevent/core/codedef.h>
+#include <quickevent/core/coursedef.h>
+
+#include <qf/qmlwidgets/framework/mainwindow.h>
+
+#include <plugins/Event/src/eventplugin.h>
+#include <plugins/Runs/src/runsplugin.h>
+#include <qf/core/log.h>
+#include <qf/core/sql/query.h>
+#include <qf/core/sql/querybuilder.h>
+
+namespace qfs = qf::core::sql;
+using qf::qmlwidgets::framework::getPlugin;
+using Event::EventPlugin;
+using Runs::RunsPlugin;
+
+namespace CardReader {
+
+CoursePlan CoursePlan::fromCourseDef(const quickevent::core::CourseDef &course)
+{
+	CoursePlan ret;
+	ret.courseId = course.id();
+	const QVariantList codes = course.codes();
+	ret.codes.reserve(codes.count());
+	ret.altCodes.reserve(codes.count());
+	ret.outOfOrder.reserve(codes.count());
+	ret.distances.reserve(codes.count());
+	for(const QVariant &v : codes) {
+		quickevent::core::CodeDef cd(v.toMap());
+		ret.codes << cd.code();
+		// for postgres, Query.values() returns lower case keys
+		ret.altCodes << cd.value(QStringLiteral("altcode")).toInt();
+		ret.outOfOrder << cd.value(QStringLiteral("outoforder")).toBool();
+		ret.distances << cd.distance();
+	}
+	quickevent::core::CodeDef finish_code(course.value(QStringLiteral("finishCode")).toMap());
+	ret.finishCode = finish_code.code();
+	ret.finishDistance = finish_code.distance();
+	return ret;
+}
+
+qf::core::sql::QueryBuilder CoursePlanCache::runsQueryBuilder(bool is_relays)
+{
+	qfs::QueryBuilder qb;
+	qb.select2("runs", "id, stageId, startTimeMs, leg")
+			.from("runs");
+	if(is_relays) {
+		qb.select2("relays", "number")
+				.join("runs.relayId", "relays.id");
+	}
+	else {
+		qb.select2("competitors", "classId")
+				.join("runs.competitorId", "competitors.id");
+	}
+	return qb;
+}
+
+RunCoursePlan CoursePlanCache::runCoursePlanFromQuery(const qf::core::sql::Query &q, bool is_relays)
+{
+	RunCoursePlan ret;
+	ret.runId = q.value("id").toInt();
+	ret.stageId = q.value("stageId").toInt();
+	// start list time is taken in whole seconds, see CardChecker::startTimeSec()
+	ret.startTimeMs = q.value("startTimeMs").toInt() / 1000 * 1000;
+	int course_id = is_relays
+			? relayCourseId(q.value("number").toInt(), q.value("leg").toInt())
+			: classCourseId(ret.stageId, q.value("classId").toInt());
+	ret.course = coursePlan(course_id);
+	return ret;
+}
+
+RunCoursePlan CoursePlanCache::runCoursePlan(int run_id)
+{
+	qfLogFuncFrame() << "run id:" << run_id;
+	if(run_id <= 0) {
+		qfError() << "Run ID == 0";
+		return RunCoursePlan();
+	}
+	bool is_relays = getPlugin<EventPlugin>()->eventConfig()->isRelays();
+	qfs::QueryBuilder qb = runsQueryBuilder(is_relays);
+	qb.where("runs.id=" QF_IARG(run_id));
+	qfs::Query q;
+	q.exec(qb.toString(), qf::core::Exception::Throw);
+	if(!q.next()) {
+		qfError() << "Cannot find runs record for id:" << run_id;
+		return RunCoursePlan();
+	}
+	return runCoursePlanFromQuery(q, is_relays);
+}
+
+QHash<int, RunCoursePlan> CoursePlanCache::stageRunCoursePlans(int stage_id)
+{
+	qfLogFuncFrame() << "stage id:" << stage_id;
+	QHash<int, RunCoursePlan> ret;
+	bool is_relays = getPlugin<EventPlugin>()->eventConfig()->isRelays();
+	qfs::QueryBuilder qb = runsQueryBuilder(is_relays);
+	qb.where("runs.stageId=" QF_IARG(stage_id));
+	qfs::Query q;
+	q.exec(qb.toString(), qf::core::Exception::Throw);
+	while(q.next()) {
+		RunCoursePlan run_plan = runCoursePlanFromQuery(q, is_relays);
+		ret.insert(run_plan.runId, run_plan);
+	}
+	return ret;
+}
+
+CoursePlan CoursePlanCache::coursePlan(int course_id)
+{
+	if(course_id <= 0) {
+		qfError() << "Course ID == 0";
+		return CoursePlan();
+	}
+	auto it = m_coursePlans.constFind(course_id);
+	if(it != m_coursePlans.constEnd())
+		return it.value();
+	CoursePlan ret = CoursePlan::fromCourseDef(getPlugin<RunsPlugin>()->courseForCourseId(course_id));
+	m_coursePlans.insert(course_id, ret);
+	return ret;
+}
+
+void CoursePlanCache::clear()
+{
+	m_stageClassCourses.clear();
+	m_relayCourses.clear();
+	m_relayCoursesLoaded = false;
+	m_coursePlans.clear();
+}
+
+int CoursePlanCache::classCourseId(int stage_id, int class_id)
+{
+	if(!m_stageClassCourses.contains(stage_id)) {
+		QHash<int, int> &class_courses = m_stageClassCourses[stage_id];
+		qfs::Query q;
+		q.exec("SELECT classId, courseId FROM classdefs WHERE stageId=" QF_IARG(stage_id), qf::core::Exception::Throw);
+		while (q.next()) {
+			int cls_id = q.value(0).toInt();
+			if(class_courses.contains(cls_id)) {
+				qfError() << "more courses found for class id:" << cls_id << "stage:" << stage_id;
+				class_courses[cls_id] = 0;
+				continue;
+			}
+			class_courses[cls_id] = q.value(1).toInt();
+		}
+	}
+	return m_stageClassCourses.value(stage_id).value(class_id);
+}
+
+int CoursePlanCache::relayCourseId(int relay_number, int leg)
+{
+	if(!m_relayCoursesLoaded) {
+		m_relayCoursesLoaded = true;
+		qfs::Query q;
+		q.exec("SELECT id, name FROM courses", qf::core::Exception::Throw);
+		while (q.next()) {
+			QString name = q.value(1).toString();
+			if(m_relayCourses.contains(name)) {
+				qfError() << "more courses found for name:" << name;
+				m_relayCourses[name] = 0;
+				continue;
+			}
+			m_relayCourses[name] = q.value(0).toInt();
+		}
+	}
+	int ret = m_relayCourses.value(QStringLiteral("%1.%2").arg(relay_number).arg(leg));
+	if(!ret)
+		qfWarning() << "Cannot find course for relay:" << relay_number << "leg:" << leg;
+	return ret;
+}
+
+}
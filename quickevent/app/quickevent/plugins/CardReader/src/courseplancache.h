@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace quickevent { namespace core { class CourseDef; }}
+namespace qf { namespace core { namespace sql { class Query; class QueryBuilder; }}}
+
+namespace CardReader {
+
+/// Course compiled for card checking, code arrays are indexed by control position
+struct CoursePlan
+{
+	int courseId = 0;
+	QVector<int> codes;
+	QVector<int> altCodes;
+	QVector<bool> outOfOrder;
+	QVector<int> distances;
+	int finishCode = 0;
+	int finishDistance = 0;
+
+	bool isEmpty() const {return courseId == 0;}
+	int controlCount() const {return codes.count();}
+
+	static CoursePlan fromCourseDef(const quickevent::core::CourseDef &course);
+};
+
+struct RunCoursePlan
+{
+	int runId = 0;
+	int stageId = 0;
+	int startTimeMs = 0; //< start time till stage start from start list
+	CoursePlan course;
+};
+
+/// Compiled courses and class to course assignment per stage.
+/// Card check needs single runs query then, everything else is served from memory.
+/// Cache is cleared on courses change db event and when event is opened.
+class CoursePlanCache
+{
+public:
+	RunCoursePlan runCoursePlan(int run_id);
+	/// all the runs of stage in single query, run_id -> plan
+	QHash<int, RunCoursePlan> stageRunCoursePlans(int stage_id);
+	CoursePlan coursePlan(int course_id);
+
+	void clear();
+private:
+	static qf::core::sql::QueryBuilder runsQueryBuilder(bool is_relays);
+	RunCoursePlan runCoursePlanFromQuery(const qf::core::sql::Query &q, bool is_relays);
+	int classCourseId(int stage_id, int class_id);
+	int relayCourseId(int relay_number, int leg);
+private:
+	QHash<int, QHash<int, int>> m_stageClassCourses; // stage_id -> class_id -> course_id
+	QHash<QString, int> m_relayCourses; // course name -> course_id
+	bool m_relayCoursesLoaded = false;
+	QHash<int, CoursePlan> m_coursePlans;
+};
+
+}
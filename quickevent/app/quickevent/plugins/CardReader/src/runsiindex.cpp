@@ -0,0 +1,101 @@
+#include "runsiindex.h"
+
+#include <qf/core/log.h>
+#include <qf/core/sql/query.h>
+
+//#define QF_TIMESCOPE_ENABLED
+#include <qf/core/utils/timescope.h>
+
+#include <algorithm>
+
+namespace qfs = qf::core::sql;
+
+namespace CardReader {
+
+QVector<RunSiIndex::Run> RunSiIndex::siRuns(int stage_id, int si_id)
+{
+	if(!m_stageSiRunIds.contains(stage_id))
+		loadStage(stage_id);
+	QVector<Run> ret;
+	const QVector<int> run_ids = m_stageSiRunIds.value(stage_id).value(si_id);
+	ret.reserve(run_ids.count());
+	for(int run_id : run_ids)
+		ret << m_runs.value(run_id);
+	return ret;
+}
+
+RunSiIndex::Run RunSiIndex::run(int run_id) const
+{
+	return m_runs.value(run_id);
+}
+
+bool RunSiIndex::isInLentCards(int si_id)
+{
+	if(!m_lentCardsLoaded)
+		loadLentCards();
+	return m_lentCards.contains(si_id);
+}
+
+void RunSiIndex::setStartTimeMs(int run_id, int start_time_ms)
+{
+	auto it = m_runs.find(run_id);
+	if(it != m_runs.end())
+		it.value().startTimeMs = start_time_ms;
+}
+
+void RunSiIndex::setFinishTimeMs(int run_id, int finish_time_ms)
+{
+	auto it = m_runs.find(run_id);
+	if(it != m_runs.end())
+		it.value().finishTimeMs = finish_time_ms;
+}
+
+void RunSiIndex::clear()
+{
+	m_runs.clear();
+	m_stageSiRunIds.clear();
+	m_lentCards.clear();
+	m_lentCardsLoaded = false;
+}
+
+void RunSiIndex::loadStage(int stage_id)
+{
+	qfLogFuncFrame() << "stage id:" << stage_id;
+	QF_TIME_SCOPE("RunSiIndex::loadStage()");
+	QHash<int, QVector<int>> &si_run_ids = m_stageSiRunIds[stage_id];
+	QString qs = "SELECT id, siId, leg, startTimeMs, finishTimeMs, isRunning, cardLent, cardReturned FROM runs WHERE siId IS NOT NULL";
+	if(stage_id > 0)
+		qs += " AND stageId=" QF_IARG(stage_id);
+	qfs::Query q;
+	q.exec(qs, qf::core::Exception::Throw);
+	while(q.next()) {
+		Run r;
+		r.runId = q.value(0).toInt();
+		r.leg = q.value(2).toInt();
+		r.startTimeMs = q.value(3).toInt();
+		r.finishTimeMs = q.value(4).toInt();
+		r.isRunning = q.value(5).toBool();
+		r.cardLent = q.value(6).toBool();
+		r.cardReturned = q.value(7).toBool();
+		m_runs[r.runId] = r;
+		si_run_ids[q.value(1).toInt()] << r.runId;
+	}
+	if(stage_id == 0) {
+		for(QVector<int> &run_ids : si_run_ids) {
+			std::sort(run_ids.begin(), run_ids.end(), [this](int id1, int id2) {
+				return m_runs.value(id1).leg > m_runs.value(id2).leg;
+			});
+		}
+	}
+}
+
+void RunSiIndex::loadLentCards()
+{
+	m_lentCardsLoaded = true;
+	qfs::Query q;
+	q.exec("SELECT siId FROM lentcards WHERE NOT ignored", qf::core::Exception::Throw);
+	while(q.next())
+		m_lentCards << q.value(0).toInt();
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+namespace CardReader {
+
+/// In memory index of runs by SI card, used to assign read cards and punches to runs without SQL query.
+/// Runs are loaded per stage on first lookup, relay runs are loaded all together under stage_id 0,
+/// since relay SI lookup is not restricted to stage.
+/// Index is cleared on runs changed db event, finish and start times are updated in place when card is processed.
+class RunSiIndex
+{
+public:
+	struct Run
+	{
+		int runId = 0;
+		int leg = 0;
+		int startTimeMs = 0;
+		int finishTimeMs = 0;
+		bool isRunning = false;
+		bool cardLent = false;
+		bool cardReturned = false;
+	};
+public:
+	/// relay runs are sorted by leg descending
+	QVector<Run> siRuns(int stage_id, int si_id);
+	/// runId == 0 if run is not loaded in index
+	Run run(int run_id) const;
+	bool isInLentCards(int si_id);
+
+	void setStartTimeMs(int run_id, int start_time_ms);
+	void setFinishTimeMs(int run_id, int finish_time_ms);
+
+	void clear();
+private:
+	void loadStage(int stage_id);
+	void loadLentCards();
+private:
+	QHash<int, Run> m_runs; // run_id -> run
+	QHash<int, QHash<int, QVector<int>>> m_stageSiRunIds; // stage_id -> si_id -> run_ids
+	QSet<int> m_lentCards;
+	bool m_lentCardsLoaded = false;
+};
+
+}
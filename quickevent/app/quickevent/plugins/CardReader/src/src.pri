@@ -7,6 +7,9 @@ HEADERS += \
     $$PWD/cardreaderplugin.h \
     $$PWD/cardchecker.h \
     $$PWD/cardcheckerclassiccpp.h \
+    $$PWD/courseplancache.h \
+    $$PWD/runsiindex.h \
+    $$PWD/cardprocessor.h \
 
 SOURCES += \
     $$PWD/cardcheckerfreeordercpp.cpp \
@@ -15,6 +18,9 @@ SOURCES += \
     $$PWD/cardreaderplugin.cpp \
     $$PWD/cardchecker.cpp \
     $$PWD/cardcheckerclassiccpp.cpp \
+    $$PWD/courseplancache.cpp \
+    $$PWD/runsiindex.cpp \
+    $$PWD/cardprocessor.cpp \
 
 FORMS += \
     $$PWD/cardreaderwidget.ui \
@@ -273,6 +273,7 @@ void ClassesPlugin::createCourses(int stage_id, const QList<ImportCourseDef> &co
 			}
 		}
 		transaction.commit();
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COURSES_CHANGED);
 	}
 	catch (const qf::core::Exception &e) {
 		qf::qmlwidgets::framework::MainWindow *fwk = qf::qmlwidgets::framework::MainWindow::frameWork();
@@ -194,6 +194,9 @@ ClassesWidget::ClassesWidget(QWidget *parent) :
 		ui->tblClasses->setItemDelegateForColumn(m->columnIndex("classdefs.courseId"), m_courseItemDelegate);
 
 		connect(m_courseItemDelegate, &CourseItemDelegate::courseIdChanged, ui->tblClasses, &qfw::TableView::reloadCurrentRow, Qt::QueuedConnection);
+		connect(m_courseItemDelegate, &CourseItemDelegate::courseIdChanged, this, []() {
+			getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COURSES_CHANGED);
+		}, Qt::QueuedConnection);
 
 		m_classesModel = m;
 	}
@@ -297,6 +300,7 @@ void ClassesWidget::edit_courses()
 	auto *w = new EditCoursesWidget();
 	dlg.setCentralWidget(w);
 	dlg.exec();
+	getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COURSES_CHANGED);
 	reload();
 }
 
@@ -308,6 +312,7 @@ void ClassesWidget::edit_codes()
 	//auto *bt_apply = dlg.buttonBox()->button(QDialogButtonBox::Apply);
 	//connect(bt_apply, &QPushButton::clicked, this, &MainWindow::askUserToRestartAppServer);
 	dlg.exec();
+	getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COURSES_CHANGED);
 	reload();
 }
 
@@ -39,6 +39,16 @@ bool CompetitorDocument::saveData()
 	}
 	*/
 	bool class_dirty = isDirty("competitors.classId");
+	/// columns shown on start list and results pages, listeners have to refresh competitor's class when they change
+	bool page_dirty = class_dirty
+			|| isDirty("competitors.lastName")
+			|| isDirty("competitors.firstName")
+			|| isDirty("competitors.registration");
+	/// classes touched by save are sent with db event, listeners can refresh them only
+	QVariantList class_ids;
+	if(old_mode == DataDocument::ModeEdit && class_dirty)
+		class_ids << origValue("competitors.classId");
+	class_ids << value("competitors.classId");
 	bool ret = Super::saveData();
 	qfDebug() << "Super save data:" << ret;
 	if(ret) {
@@ -58,7 +68,7 @@ bool CompetitorDocument::saveData()
 				q.exec(qf::core::Exception::Throw);
 				m_lastInsertedRunsIds << q.lastInsertId().toInt();
 			}
-			getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED);
+			getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED, class_ids);
 		}
 		else if(old_mode == DataDocument::ModeEdit) {
 			if(siid_dirty) {
@@ -71,9 +81,10 @@ bool CompetitorDocument::saveData()
 					q.bindValue(":siId", siid());
 					q.exec(qf::core::Exception::Throw);
 				}
+				getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_RUNS_CHANGED);
 			}
-			if(class_dirty)
-				getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED);
+			if(page_dirty)
+				getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED, class_ids);
 		}
 	}
 	return ret;
@@ -83,6 +94,7 @@ bool CompetitorDocument::dropData()
 {
 	bool ret = false;
 	auto id = dataId();
+	QVariantList class_ids{value("competitors.classId")};
 	{
 		qf::core::sql::Query q(model()->connectionName());
 		q.prepare("DELETE FROM runs WHERE competitorId = :competitorId");
@@ -93,7 +105,7 @@ bool CompetitorDocument::dropData()
 	}
 	if(ret) {
 		ret = Super::dropData();
-		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED);
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED, class_ids);
 	}
 	return ret;
 }
@@ -16,6 +16,7 @@
 #include <qf/core/assert.h>
 #include <plugins/Event/src/eventplugin.h>
 
+#include <QElapsedTimer>
 #include <QQmlEngine>
 
 namespace qfw = qf::qmlwidgets;
@@ -114,6 +115,7 @@ void CompetitorsPlugin::reloadRegistrationsModel()
 		registrationsModel()->clearRows();
 	// clear registration table to be regenerated when registrationsTable() will be called
 	m_registrationsTable = qf::core::utils::Table();
+	m_registrationsSearchIndex.clear();
 }
 
 qf::core::model::SqlTableModel* CompetitorsPlugin::registrationsModel()
@@ -141,6 +143,7 @@ const qf::core::utils::Table &CompetitorsPlugin::registrationsTable()
 	qf::core::model::SqlTableModel *m = registrationsModel();
 	if(m_registrationsTable.isNull() && !m->table().isNull()) {
 		m_registrationsTable = m->table();
+		m_registrationsTable.setReadOnly(true);
 		auto c_nsk = QStringLiteral("competitorNameAscii7");
 		m_registrationsTable.appendColumn(c_nsk, QVariant::String);
 		int ix_nsk = m_registrationsTable.fields().fieldIndex(c_nsk);
@@ -151,8 +154,27 @@ const qf::core::utils::Table &CompetitorsPlugin::registrationsTable()
 			nsk = QString::fromLatin1(qf::core::Collator::toAscii7(QLocale::Czech, nsk, true));
 			row_ref.setValue(ix_nsk, nsk);
 		}
+		QElapsedTimer tmr;
+		tmr.start();
+		m_registrationsSearchIndex.clear();
+		for (int i = 0; i < m_registrationsTable.rowCount(); ++i)
+			m_registrationsSearchIndex.insert(i, registrationSearchText(m_registrationsTable.row(i)));
+		qfInfo() << "registrations search index of" << m_registrationsSearchIndex.count() << "rows built in" << tmr.elapsed() << "msec";
 	}
 	return m_registrationsTable;
 }
 
+const qf::core::utils::TrigramIndex &CompetitorsPlugin::registrationsSearchIndex()
+{
+	registrationsTable();
+	return m_registrationsSearchIndex;
+}
+
+QString CompetitorsPlugin::registrationSearchText(const qf::core::utils::TableRow &row)
+{
+	return row.value(QStringLiteral("competitorNameAscii7")).toString() + ' '
+			+ row.value(QStringLiteral("registration")).toString() + ' '
+			+ QStringLiteral("SI:") + row.value(QStringLiteral("siId")).toString();
+}
+
 }
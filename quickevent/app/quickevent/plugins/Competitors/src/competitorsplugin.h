@@ -5,6 +5,7 @@
 
 #include <qf/core/utils.h>
 #include <qf/core/utils/table.h>
+#include <qf/core/utils/trigramindex.h>
 
 namespace qf {
 
@@ -43,12 +44,16 @@ public:
 	Q_SIGNAL int editCompetitorOnPunch(int siid);
 	Q_SIGNAL void dbEventNotify(const QString &domain, int connection_id, const QVariant &payload);
 	Q_SIGNAL void competitorEdited(); // used to clear caches with competitors
+	Q_SIGNAL void competitorSaved(int competitor_id); // used to update caches with competitors incrementally
 
 	Q_SIGNAL void nativeInstalled();
 
 	Q_SLOT void reloadRegistrationsModel();
 	qf::core::model::SqlTableModel* registrationsModel();
 	const qf::core::utils::Table& registrationsTable();
+	/// substring search index of registrationsTable() rows, row number is id
+	const qf::core::utils::TrigramIndex& registrationsSearchIndex();
+	static QString registrationSearchText(const qf::core::utils::TableRow &row);
 
 	Q_SLOT void onInstalled();
 private:
@@ -59,6 +64,7 @@ private:
 	qf::qmlwidgets::framework::DockWidget *m_registrationsDockWidget = nullptr;
 	qf::core::model::SqlTableModel *m_registrationsModel = nullptr;
 	qf::core::utils::Table m_registrationsTable;
+	qf::core::utils::TrigramIndex m_registrationsSearchIndex;
 };
 
 }
@@ -46,6 +46,27 @@ using qf::qmlwidgets::framework::getPlugin;
 using Event::EventPlugin;
 using Competitors::CompetitorsPlugin;
 
+namespace {
+class CompetitorsModel : public qfm::SqlTableModel
+{
+private:
+	using Super = qfm::SqlTableModel;
+public:
+	CompetitorsModel(QObject *parent = nullptr) : Super(parent) {}
+
+	bool postRow(int row_no, bool throw_exc) Q_DECL_OVERRIDE
+	{
+		/// registration is shown on start list and results pages
+		bool page_dirty = isDirty(row_no, QStringLiteral("registration"));
+		QVariantList class_ids{tableRow(row_no).value(QStringLiteral("competitors.classId"))};
+		bool ret = Super::postRow(row_no, throw_exc);
+		if(ret && page_dirty)
+			getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED, class_ids);
+		return ret;
+	}
+};
+}
+
 CompetitorsWidget::CompetitorsWidget(QWidget *parent) :
 	Super(parent),
 	ui(new Ui::CompetitorsWidget)
@@ -58,7 +79,7 @@ CompetitorsWidget::CompetitorsWidget(QWidget *parent) :
 	ui->tblCompetitors->setPersistentSettingsId("tblCompetitors");
 	ui->tblCompetitors->setRowEditorMode(qfw::TableView::EditRowsMixed);
 	ui->tblCompetitors->setInlineEditSaveStrategy(qfw::TableView::OnEditedValueCommit);
-	qfm::SqlTableModel *m = new qfm::SqlTableModel(this);
+	qfm::SqlTableModel *m = new CompetitorsModel(this);
 	m->addColumn("id").setReadOnly(true);
 	m->addColumn("classes.name", tr("Class"));
 	m->addColumn("competitors.startNumber", tr("SN", "start number")).setToolTip(tr("Start number"));
@@ -133,6 +154,7 @@ void CompetitorsWidget::settleDownInPartWidget(quickevent::gui::PartWidget *part
 			auto *w = new LentCardsWidget();
 			dlg.setCentralWidget(w);
 			dlg.exec();
+			getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_RUNS_CHANGED);
 		});
 	}
 
@@ -244,6 +266,10 @@ void CompetitorsWidget::editCompetitor_helper(const QVariant &id, int mode, int
 		}
 		connect(doc, &Competitors::CompetitorDocument::saved, ui->tblCompetitors, &qf::qmlwidgets::TableView::rowExternallySaved, Qt::QueuedConnection);
 		connect(doc, &Competitors::CompetitorDocument::saved, getPlugin<CompetitorsPlugin>(), &Competitors::CompetitorsPlugin::competitorEdited, Qt::QueuedConnection);
+		connect(doc, &Competitors::CompetitorDocument::saved, getPlugin<CompetitorsPlugin>(), [](const QVariant &id, int mode) {
+			Q_UNUSED(mode)
+			emit getPlugin<CompetitorsPlugin>()->competitorSaved(id.toInt());
+		}, Qt::QueuedConnection);
 		ok = dlg.exec();
 		//if(ok)
 		//	transaction.commit();
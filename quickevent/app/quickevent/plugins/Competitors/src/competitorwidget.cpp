@@ -222,9 +222,20 @@ bool CompetitorWidget::saveRunsTable()
 	if(is_running_set)
 		throw BadDataInputException(tr("Canont set not running flag for competitor with valid finish time."));
 	*/
+	bool is_dirty = false;
+	const qf::core::utils::Table &runs_table = m_runsModel->table();
+	for (int i = 0; i < runs_table.rowCount(); ++i) {
+		if(runs_table.row(i).isDirty()) {
+			is_dirty = true;
+			break;
+		}
+	}
 	bool ret = m_runsModel->postAll(true);
-	if(ret)
-		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED);
+	if(ret && is_dirty) {
+		/// listeners can refresh competitor's class only
+		QVariantList class_ids{dataController()->document()->value(QStringLiteral("competitors.classId"))};
+		getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED, class_ids);
+	}
 	return ret;
 }
 /*
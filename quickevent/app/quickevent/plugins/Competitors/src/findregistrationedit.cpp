@@ -6,6 +6,7 @@
 #include <qf/qmlwidgets/log.h>
 
 #include <qf/core/model/sqltablemodel.h>
+#include <qf/core/utils/trigramindex.h>
 #include <qf/core/assert.h>
 
 #include <QCompleter>
@@ -27,14 +28,28 @@ public:
 	int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
 	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
 	const qf::core::utils::Table& registrationsTable() const;
+	/// registrationsTable() row number of found row
+	int tableRow(int found_row) const {return m_foundRows.value(found_row, -1);}
+	void setFilter(const QString &text);
 private:
 	mutable qf::core::utils::Table m_registrationsTable;
+	qf::core::utils::TrigramIndex m_searchIndex;
+	QVector<int> m_foundRows;
 };
 
 FindRegistrationsModel::FindRegistrationsModel(QObject *parent)
 	: Super(parent)
 {
-	m_registrationsTable = getPlugin<CompetitorsPlugin>()->registrationsTable();
+	CompetitorsPlugin *plugin = getPlugin<CompetitorsPlugin>();
+	m_registrationsTable = plugin->registrationsTable();
+	m_searchIndex = plugin->registrationsSearchIndex();
+}
+
+void FindRegistrationsModel::setFilter(const QString &text)
+{
+	beginResetModel();
+	m_foundRows = m_searchIndex.search(text, FindRegistrationEdit::MAX_FOUND_ROWS);
+	endResetModel();
 }
 
 const qf::core::utils::Table &FindRegistrationsModel::registrationsTable() const
@@ -45,14 +60,13 @@ const qf::core::utils::Table &FindRegistrationsModel::registrationsTable() const
 int FindRegistrationsModel::rowCount(const QModelIndex &parent) const
 {
 	Q_UNUSED(parent)
-	const qf::core::utils::Table &table = registrationsTable();
-	return table.rowCount();
+	return m_foundRows.count();
 }
 
 QVariant FindRegistrationsModel::data(const QModelIndex &index, int role) const
 {
 	const qf::core::utils::Table &table = registrationsTable();
-	int row_no = index.row();
+	int row_no = tableRow(index.row());
 	if(row_no >= 0 && row_no < table.rowCount()) {
 		qf::core::utils::TableRow table_row = table.row(row_no);
 		const qf::core::utils::Table::FieldList &fields = table.fields();
@@ -84,7 +98,16 @@ FindRegistrationEdit::FindRegistrationEdit(QWidget *parent)
 	cmpl->setCompletionRole(CompletionRole);
 	cmpl->setCaseSensitivity(Qt::CaseInsensitive);
 	cmpl->setFilterMode(Qt::MatchContains);
+	/// rows are filtered by trigram index, completer shows them all
+	cmpl->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
 	setCompleter(cmpl);
+	/// textEdited is emitted before QLineEdit updates completer popup
+	connect(this, &FindRegistrationEdit::textEdited, this, &FindRegistrationEdit::onTextEdited);
+}
+
+void FindRegistrationEdit::onTextEdited(const QString &text)
+{
+	m_findRegistrationsModel->setFilter(text);
 }
 
 void FindRegistrationEdit::focusInEvent(QFocusEvent *event)
@@ -105,7 +128,7 @@ void FindRegistrationEdit::onCompleterActivated(const QModelIndex &index)
 	QF_ASSERT(proxy_model != nullptr, "Bad proxy model!", return);
 	QModelIndex ix = proxy_model->mapToSource(index);
 	const qf::core::utils::Table &table = m_findRegistrationsModel->registrationsTable();
-	int row_no = ix.row();
+	int row_no = m_findRegistrationsModel->tableRow(ix.row());
 	if(row_no >= 0 && row_no < table.rowCount()) {
 		qf::core::utils::TableRow table_row = table.row(row_no);
 		emit registrationSelected(table_row.valuesMap(false));
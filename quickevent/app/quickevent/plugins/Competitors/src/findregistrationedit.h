@@ -12,6 +12,7 @@ private:
 	typedef QLineEdit Super;
 public:
 	static constexpr int CompletionRole = Qt::UserRole + 1;
+	static constexpr int MAX_FOUND_ROWS = 200;
 
 	FindRegistrationEdit(QWidget *parent = nullptr);
 
@@ -20,6 +21,7 @@ protected:
 	void focusInEvent(QFocusEvent * event) Q_DECL_OVERRIDE;
 private:
 	Q_SLOT void onCompleterActivated(const QModelIndex &index);
+	void onTextEdited(const QString &text);
 private:
 	FindRegistrationsModel *m_findRegistrationsModel = nullptr;
 };
@@ -46,7 +46,9 @@
 #include <QDirIterator>
 #include <QJsonParseError>
 #include <QJsonDocument>
+#include <QElapsedTimer>
 
+#include <functional>
 #include <regex>
 
 namespace qfw = qf::qmlwidgets;
@@ -102,6 +104,8 @@ const char* EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED = "cardProcessedAnd
 const char* EventPlugin::DBEVENT_PUNCH_RECEIVED = "punchReceived";
 const char* EventPlugin::DBEVENT_REGISTRATIONS_IMPORTED = "registrationsImported";
 const char* EventPlugin::DBEVENT_STAGE_START_CHANGED = "stageStartChanged";
+const char* EventPlugin::DBEVENT_COURSES_CHANGED = "coursesChanged";
+const char* EventPlugin::DBEVENT_RUNS_CHANGED = "runsChanged";
 
 static QString singleFileStorageDir()
 {
@@ -988,7 +992,9 @@ void EventPlugin::setSqlServerConnected(bool ok)
 	}
 }
 
-static QString copy_sql_table(const QString &table_name, const QSqlRecord &dest_rec, qfs::Connection &from_conn, qfs::Connection &to_conn)
+/// rows are inserted in batches using multi-row INSERT, so one statement is parsed and executed per batch
+/// PSQL COPY cannot be used, since Qt SQL driver does not provide access to it
+static QString copy_sql_table(const QString &table_name, const QSqlRecord &dest_rec, qfs::Connection &from_conn, qfs::Connection &to_conn, const std::function<void (int copied_cnt, int total_cnt)> &progress = nullptr)
 {
 	qfLogFuncFrame() << table_name;
 	qfInfo() << "Copying table:" << table_name;
@@ -996,78 +1002,156 @@ static QString copy_sql_table(const QString &table_name, const QSqlRecord &dest_
 		qfWarning() << "Destination table" << table_name << "doesn't exist!";
 		return QString();
 	}
+	QElapsedTimer elapsed_timer;
+	elapsed_timer.start();
+	int total_cnt = 0;
+	{
+		qfs::Query q(from_conn);
+		if(q.exec(QString("SELECT COUNT(*) FROM %1").arg(table_name)) && q.next())
+			total_cnt = q.value(0).toInt();
+	}
 	qfs::Query from_q(from_conn);
+	from_q.setForwardOnly(true);
 	if(!from_q.exec(QString("SELECT * FROM %1").arg(table_name))) {
 		qfWarning() << "Source table" << table_name << "doesn't exist!";
 		return QString();
 	}
 	const QSqlRecord src_rec = from_q.record();
 	// copy only fields which can be found in both records
+	// column mapping and types are resolved once per table
 	QSqlRecord rec;
+	QVector<int> src_indexes;
 	for (int i = 0; i < dest_rec.count(); ++i) {
 		QString fld_name = dest_rec.fieldName(i);
-		if(src_rec.indexOf(fld_name) >= 0) {
+		int src_ix = src_rec.indexOf(fld_name);
+		if(src_ix >= 0) {
 			qfDebug() << fld_name << "\t added to imported fields since it is present in both databases";
 			rec.append(dest_rec.field(i));
+			src_indexes << src_ix;
 		}
 	}
-	bool is_import_offrace = false;
+	/// offRace column was replaced by isRunning = !offRace
+	int offrace_src_ix = -1;
 	if(table_name == QLatin1String("runs")) {
 		if(!src_rec.contains("isRunning") && dest_rec.contains("isRunning") && src_rec.contains("offRace")) {
-			is_import_offrace = true;
+			offrace_src_ix = src_rec.indexOf("offRace");
 			rec.append(dest_rec.field("isRunning"));
+			src_indexes << -1;
+		}
+	}
+	const int col_cnt = rec.count();
+	if(col_cnt == 0)
+		return QString();
+	QVector<int> types(col_cnt);
+	bool has_id_int = false;
+	for (int i = 0; i < col_cnt; ++i) {
+		const QSqlField fld = rec.field(i);
+		types[i] = fld.type();
+		if((fld.type() == QVariant::Int
+			|| fld.type() == QVariant::UInt
+			|| fld.type() == QVariant::LongLong
+			|| fld.type() == QVariant::ULongLong)
+				&& fld.name() == QLatin1String("id")) {
+			// probably ID INT AUTO_INCREMENT
+			has_id_int = true;
 		}
 	}
+
 	auto *sqldrv = to_conn.driver();
-	QString qs = sqldrv->sqlStatement(QSqlDriver::InsertStatement, table_name, rec, true);
-	qfDebug() << qs;
-	qfs::Query to_q(to_conn);
-	if(!to_q.prepare(qs)) {
-		QString ret = QString("Cannot prepare insert table SQL statement, table: %1.\n%2").arg(table_name).arg(to_q.lastErrorText());
-		qfInfo() << qs;
-		return ret;
+	QString row_placeholders;
+	{
+		QStringList sl;
+		for (int i = 0; i < col_cnt; ++i)
+			sl << QStringLiteral("?");
+		row_placeholders = '(' + sl.join(", ") + ')';
 	}
-	bool has_id_int = false;
+	QString insert_prefix;
+	{
+		QString qs = sqldrv->sqlStatement(QSqlDriver::InsertStatement, table_name, rec, true);
+		int ix = qs.lastIndexOf(QLatin1String(" VALUES "), -1, Qt::CaseInsensitive);
+		if(ix < 0)
+			return QString("Cannot create insert table SQL statement, table: %1.\n%2").arg(table_name).arg(qs);
+		insert_prefix = qs.mid(0, ix) + QStringLiteral(" VALUES ");
+	}
+	auto insert_statement = [insert_prefix, row_placeholders](int row_cnt) {
+		QString qs = insert_prefix;
+		for (int i = 0; i < row_cnt; ++i) {
+			if(i > 0)
+				qs += QStringLiteral(", ");
+			qs += row_placeholders;
+		}
+		return qs;
+	};
+	/// SQLite older than 3.32 has limit of 999 host parameters per statement
+	const int max_params = to_conn.driverName().endsWith(QLatin1String("SQLITE"), Qt::CaseInsensitive)? 999: 32767;
+	const int batch_size = qBound(1, max_params / col_cnt, 500);
+
+	qfs::Query to_q(to_conn);
+	int prepared_batch_size = 0;
+	QVariantList batch_values;
+	batch_values.reserve(batch_size * col_cnt);
+	int copied_cnt = 0;
+	auto flush_batch = [&]() -> QString {
+		int row_cnt = batch_values.count() / col_cnt;
+		if(row_cnt == 0)
+			return QString();
+		if(row_cnt != prepared_batch_size) {
+			QString qs = insert_statement(row_cnt);
+			if(!to_q.prepare(qs)) {
+				qfInfo() << qs;
+				return QString("Cannot prepare insert table SQL statement, table: %1.\n%2").arg(table_name).arg(to_q.lastErrorText());
+			}
+			prepared_batch_size = row_cnt;
+		}
+		for(const QVariant &v : batch_values)
+			to_q.addBindValue(v);
+		batch_values.clear();
+		if(!to_q.exec())
+			return QString("SQL Error: %1").arg(to_q.lastError().text());
+		copied_cnt += row_cnt;
+		if(progress)
+			progress(copied_cnt, total_cnt);
+		return QString();
+	};
 	while(from_q.next()) {
 		if(table_name == QLatin1String("config")) {
 			if(from_q.value(0).toString() == QLatin1String("db.version"))
 				continue;
 		}
-		for (int i = 0; i < rec.count(); ++i) {
-			QSqlField fld = rec.field(i);
-			QString fld_name = fld.name();
-			//qfDebug() << "copy:" << fld_name << from_q.value(fld_name);
+		for (int i = 0; i < col_cnt; ++i) {
 			QVariant v;
-			if((fld_name.compare(QLatin1String("isRunning"), Qt::CaseInsensitive) == 0) && is_import_offrace) {
-				bool offrace = from_q.value(QStringLiteral("offRace")).toBool();
+			int src_ix = src_indexes[i];
+			if(src_ix < 0) {
+				bool offrace = from_q.value(offrace_src_ix).toBool();
 				v = offrace? QVariant(): QVariant(true);
 			}
 			else {
-				v = from_q.value(fld_name);
-				v.convert(rec.field(i).type());
+				v = from_q.value(src_ix);
+				v.convert(types[i]);
 			}
-			if(!has_id_int
-					&& (fld.type() == QVariant::Int
-						|| fld.type() == QVariant::UInt
-						|| fld.type() == QVariant::LongLong
-						|| fld.type() == QVariant::ULongLong)
-					&& fld_name == QLatin1String("id")) {
-				// probably ID INT AUTO_INCREMENT
-				//max_id = qMax(max_id, v.toInt());
-				has_id_int = true;
-			}
-			to_q.addBindValue(v);
+			batch_values << v;
 		}
-		if(!to_q.exec())
-			return QString("SQL Error: %1").arg(to_q.lastError().text());
+		if(batch_values.count() >= batch_size * col_cnt) {
+			QString err = flush_batch();
+			if(!err.isEmpty())
+				return err;
+		}
+	}
+	{
+		QString err = flush_batch();
+		if(!err.isEmpty())
+			return err;
 	}
-	if(has_id_int && to_conn.driverName().endsWith(QLatin1String("PSQL"), Qt::CaseInsensitive)) {
+	if(has_id_int && copied_cnt > 0 && to_conn.driverName().endsWith(QLatin1String("PSQL"), Qt::CaseInsensitive)) {
 		// set sequence current value when importing to PSQL
 		qfInfo() << "updating seq number table:" << table_name;
 		if(!to_q.exec("SELECT pg_catalog.setval(pg_get_serial_sequence(" QF_SARG(table_name) ", 'id'), MAX(id)) FROM " QF_CARG(table_name), !qf::core::Exception::Throw)) {
 			return QString("Cannot update sequence counter, table: %1.").arg(table_name);
 		}
 	}
+	qint64 msec = elapsed_timer.elapsed();
+	qfInfo() << "Table:" << table_name << "rows copied:" << copied_cnt << "in:" << msec << "msec,"
+			 << (msec > 0? copied_cnt * 1000 / msec: copied_cnt) << "rows/sec, batch size:" << batch_size;
 	return QString();
 }
 
@@ -1120,7 +1204,9 @@ void EventPlugin::exportEvent_qbe()
 			qfDebug() << "Copying table" << table_name;
 			fwk->showProgress(tr("Copying table %1").arg(table_name), ++step_no, step_cnt);
 			QSqlRecord rec = db_schema->sqlRecord(table);
-			err_str = copy_sql_table(table_name, rec, conn, ex_conn);
+			err_str = copy_sql_table(table_name, rec, conn, ex_conn, [fwk, table_name](int copied_cnt, int total_cnt) {
+				fwk->showProgress(tr("Copying table %1, %2 of %3 records").arg(table_name).arg(copied_cnt).arg(total_cnt), copied_cnt, total_cnt);
+			});
 			if(!err_str.isEmpty())
 				break;
 		}
@@ -1218,7 +1304,9 @@ void EventPlugin::importEvent_qbe()
 			qfDebug() << "Copying table" << table_name;
 			fwk->showProgress(tr("Copying table %1").arg(table_name), ++step_no, step_cnt);
 			QSqlRecord rec = db_schema->sqlRecord(table, true);
-			err_str = copy_sql_table(table_name, rec, imp_conn, exp_conn);
+			err_str = copy_sql_table(table_name, rec, imp_conn, exp_conn, [fwk, table_name](int copied_cnt, int total_cnt) {
+				fwk->showProgress(tr("Copying table %1, %2 of %3 records").arg(table_name).arg(copied_cnt).arg(total_cnt), copied_cnt, total_cnt);
+			});
 			if(!err_str.isEmpty())
 				break;
 			if(table_name == QLatin1String("stages")) {
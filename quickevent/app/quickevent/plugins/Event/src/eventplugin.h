@@ -39,13 +39,15 @@ public:
 	QF_PROPERTY_IMPL(QString, e, E, ventName)
 
 	static const char *DBEVENT_NOTIFY_NAME;
-	static const char* DBEVENT_COMPETITOR_COUNTS_CHANGED; //< number of competitors in classes changed
+	static const char* DBEVENT_COMPETITOR_COUNTS_CHANGED; //< number of competitors in classes changed, data: list of affected class ids or null if not known
 	static const char* DBEVENT_CARD_READ;
 	//static const char* DBEVENT_CARD_CHECKED;
 	static const char* DBEVENT_CARD_PROCESSED_AND_ASSIGNED;
 	static const char* DBEVENT_PUNCH_RECEIVED;
 	static const char* DBEVENT_REGISTRATIONS_IMPORTED;
 	static const char* DBEVENT_STAGE_START_CHANGED;
+	static const char* DBEVENT_COURSES_CHANGED; //< courses, codes or class course assignment edited
+	static const char* DBEVENT_RUNS_CHANGED; //< runs SI, start time, running flag or lent cards edited
 
 	Q_INVOKABLE void initEventConfig();
 	Event::EventConfig* eventConfig(bool reload = false);
@@ -278,13 +278,19 @@ void EmmaClient::exportFinish()
 
 	qfs::Query q2;
 	q2.execThrow(qb.toString());
+	const qfs::Query::FieldHandle fld_si_id("cards.siId");
+	const qfs::Query::FieldHandle fld_finish_time("runs.finishTimeMs");
+	const qfs::Query::FieldHandle fld_mis_punch("runs.misPunch");
+	const qfs::Query::FieldHandle fld_bad_check("runs.badCheck");
+	const qfs::Query::FieldHandle fld_disqualified("runs.disqualified");
+	const qfs::Query::FieldHandle fld_not_competing("runs.notCompeting");
 	while(q2.next()) {
-		int si = q2.value("cards.siId").toInt();
-		int finTime = q2.value("runs.finishTimeMs").toInt();
-		bool isMisPunch = q2.value("runs.misPunch").toBool();
-		bool isBadCheck = q2.value("runs.badCheck").toBool();
-		bool isDisq = q2.value("runs.disqualified").toBool();
-        bool notCompeting = q2.value("runs.notCompeting").toBool();
+		int si = q2.value(fld_si_id).toInt();
+		int finTime = q2.value(fld_finish_time).toInt();
+		bool isMisPunch = q2.value(fld_mis_punch).toBool();
+		bool isBadCheck = q2.value(fld_bad_check).toBool();
+		bool isDisq = q2.value(fld_disqualified).toBool();
+        bool notCompeting = q2.value(fld_not_competing).toBool();
 		QString s = QString("%1").arg(si , 8, 10, QChar(' '));
 		s += QStringLiteral(": FIN/");
 		int msec = start00 + finTime;
@@ -295,6 +295,7 @@ void OrisImporter::syncRelaysEntries(int oris_id)
 			q.execThrow("DELETE FROM competitors WHERE importId=1");
 			q.execThrow("DELETE FROM relays WHERE importId=1");
 			transaction.commit();
+			getPlugin<EventPlugin>()->emitDbEvent(EventPlugin::DBEVENT_RUNS_CHANGED, QVariant(), true);
 			qf::qmlwidgets::dialogs::MessageBox::showInfo(fwk, tr("Import finished successfully."));
 		}
 		catch (qf::core::Exception &e) {
@@ -712,6 +713,7 @@ void OrisImporter::importEventOrisEntries(int event_id)
 					}
 				}
 				transaction.commit();
+				getPlugin<EventPlugin>()->emitDbEvent(EventPlugin::DBEVENT_RUNS_CHANGED, QVariant(), true);
 			}
 			qDeleteAll(doc_lst);
 			emit getPlugin<EventPlugin>()->reloadDataRequest();
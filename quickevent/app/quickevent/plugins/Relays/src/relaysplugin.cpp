@@ -19,6 +19,7 @@
 #include <qf/core/assert.h>
 #include <plugins/Event/src/eventplugin.h>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QQmlEngine>
 
@@ -65,7 +66,10 @@ int RelaysPlugin::editRelay(int id, int mode)
 	dlg.setDefaultButton(QDialogButtonBox::Save);
 	dlg.setCentralWidget(w);
 	w->load(id, (qfm::DataDocument::RecordEditMode)mode);
-	return dlg.exec();
+	int ret = dlg.exec();
+	/// legs are edited directly in runs table
+	getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_RUNS_CHANGED);
+	return ret;
 }
 
 void RelaysPlugin::onInstalled()
@@ -196,158 +200,13 @@ struct Relay
 	}
 #endif
 };
-}
 
-qf::core::utils::TreeTable RelaysPlugin::nLegsResultsTable(const QString &where_option, int leg_count, int places, bool exclude_not_finish)
+/// computes overall legs positions and relays order of one class
+qf::core::utils::TreeTable relaysResultsTable(QList<Relay> &relays, int leg_count, int max_places, bool exclude_not_finish)
 {
-	qfLogFuncFrame() << "leg cnt:" << leg_count;
-	qf::core::utils::TreeTable tt;
-	tt.setValue("event", getPlugin<EventPlugin>()->eventConfig()->value("event"));
-	tt.setValue("stageStart", getPlugin<EventPlugin>()->stageStartDateTime(1));
-	tt.appendColumn("className", QVariant::String);
-	qfs::QueryBuilder qb;
-	qb.select2("classes", "id, name")
-			.from("classes")
-			.orderBy("classes.name");
-	if(!where_option.isEmpty()) {
-		qb.where(where_option);
-	}
-	qfs::Query q;
-	q.execThrow(qb.toString());
-	while(q.next()) {
-		int ix = tt.appendRow();
-		qf::core::utils::TreeTableRow tt_row = tt.row(ix);
-		tt_row.setValue("className", q.value("classes.name"));
-		qf::core::utils::TreeTable tt2 = nLegsClassResultsTable(q.value("classes.id").toInt(), leg_count, places, exclude_not_finish);
-		tt_row.appendTable(tt2);
-		tt.setRow(ix, tt_row);
-		//qfDebug() << tt2.toString();
-	}
-	auto wt = [tt]() {
-		QFile f("/home/fanda/t/relays.json");
-		f.open(QFile::WriteOnly);
-		f.write(tt.toString().toUtf8());
-		return f.fileName();
-	};
-	qfDebug() << "nLegsResultsTable table:" << wt();
-	return tt;
-}
-
-qf::core::utils::TreeTable RelaysPlugin::nLegsClassResultsTable(int class_id, int leg_count, int max_places, bool exclude_not_finish)
-{
-	int max_leg = 0;
-	qfs::Query q;
-	{
-		qfs::QueryBuilder qb;
-		qb.select("relayLegCount")
-			.from("classdefs")
-			.where("classId=" QF_IARG(class_id));
-		q.execThrow(qb.toString());
-		if(q.next())
-			max_leg = q.value(0).toInt();
-	}
-	if(max_leg == 0) {
-		qfError() << "Leg count not defined for class id:" << class_id;
-		return qf::core::utils::TreeTable();
-	}
-	if(leg_count > max_leg)
-		leg_count = max_leg;
-
-	QList<Relay> relays;
-	//QStringList relay_ids;
-	{
-		qfs::QueryBuilder qb;
-		qb.select2("relays", "id, club, name, number")
-				.select2("clubs", "name")
-				.from("relays")
-				.join("relays.club", "clubs.abbr")
-				.where("relays.classId=" QF_IARG(class_id));
-		q.execThrow(qb.toString());
-		while(q.next()) {
-			Relay r;
-			r.relayId = q.value("relays.id").toInt();
-			r.relayNumber = q.value("relays.number").toInt();
-			r.name = (q.value("relays.number").toString()
-					+ ' ' + q.value("relays.club").toString()
-					+ ' ' + q.value("relays.name").toString()
-					+ ' ' + q.value("clubs.name").toString()).trimmed();
-			for (int i = 0; i < leg_count; ++i)
-				r.legs << Leg();
-			relays << r;
-			qfDebug() << r.name;
-			//relay_ids << QString::number(r.relayId);
-		}
-	}
-	{
-		qfs::QueryBuilder qb;
-		qb.select2("competitors", "id, registration")
-				.select2("runs", "id, relayId, leg")
-				.select2("competitors", "firstName, lastName")
-				.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
-				.from("runs")
-				.join("runs.competitorId", "competitors.id")
-				.joinRestricted("runs.relayId", "relays.id", "relays.classId=" QF_IARG(class_id), qfs::QueryBuilder::INNER_JOIN)
-				//.where("runs.relayId IN (" + relay_ids.join(',') + ")")
-				.where("runs.leg>0 AND runs.leg<=" + QString::number(leg_count))
-				.orderBy("runs.relayId, runs.leg");
-		q.execThrow(qb.toString());
-		while(q.next()) {
-			int relay_id = q.value("runs.relayId").toInt();
-			for (int i = 0; i < relays.count(); ++i) {
-				if(relays[i].relayId == relay_id) {
-					Relay &relay = relays[i];
-					int legno = q.value("runs.leg").toInt();
-					Leg &leg = relay.legs[legno - 1];
-					leg.fullName = q.value("competitorName").toString();
-					leg.firstName = q.value("firstName").toString();
-					leg.lastName = q.value("lastName").toString();
-					leg.runId = q.value("runs.id").toInt();
-					leg.reg = q.value("competitors.registration").toString();
-					//leg.courseId = getPlugin<RunsPlugin>()->courseForRun(leg.runId);
-					break;
-				}
-			}
-		}
-	}
-	for (int legno = 1; legno <= leg_count; ++legno) {
-		qfs::QueryBuilder qb;
-		qb.select2("runs", "id, relayId, timeMs, disqualified, notCompeting")
-				.from("runs")
-				.joinRestricted("runs.relayId", "relays.id",
-								"relays.classId=" QF_IARG(class_id)
-								" AND runs.leg=" QF_IARG(legno)
-								" AND runs.isRunning"
-								" AND NOT runs.notCompeting"
-								" AND runs.finishTimeMs>0"
-								, qfs::QueryBuilder::INNER_JOIN)
-				.orderBy("runs.disqualified, runs.timeMs");
-		q.execThrow(qb.toString());
-		int run_pos = 1;
-		while(q.next()) {
-			int relay_id = q.value("runs.relayId").toInt();
-			for (int i = 0; i < relays.count(); ++i) {
-				if(relays[i].relayId == relay_id) {
-					int run_id = q.value("runs.id").toInt();
-					Relay &relay = relays[i];
-					Leg &leg = relay.legs[legno - 1];
-					if(leg.runId != run_id) {
-						qfError() << "internal error, leg:" << legno << "runId check:" << leg.runId << "should equal" << run_id;
-					}
-					else {
-						leg.notfinish = false;
-						leg.nc = q.value("runs.notCompeting").toBool();
-						leg.disq = q.value("runs.disqualified").toBool();
-						leg.time = q.value("timeMs").toInt();
-						leg.pos = leg.disq? 0: run_pos;
-						run_pos++;
-					}
-					break;
-				}
-			}
-		}
-	}
 	/// compute overal legs positions
 	for (int legno = 1; legno <= leg_count; ++legno) {
+		/// relay index, leg time from start
 		QList<QPair<int, int>> relay_stime;
 		for (int i = 0; i < relays.count(); ++i) {
 			Relay &relay = relays[i];
@@ -359,21 +218,12 @@ qf::core::utils::TreeTable RelaysPlugin::nLegsClassResultsTable(int class_id, in
 					leg.stime = leg.time + relay.legs[legno-2].stime;
 			}
 			if(leg.stime > 0)
-				relay_stime << QPair<int, int>(relay.relayId, leg.stime);
+				relay_stime << QPair<int, int>(i, leg.stime);
 		}
 		std::sort(relay_stime.begin(), relay_stime.end(), [](const QPair<int, int> &a, const QPair<int, int> &b) {return a.second < b.second;});
 		int pos = 0;
-		for(const QPair<int, int> &p : relay_stime) {
-			int relay_id = p.first;
-			for (int i = 0; i < relays.count(); ++i) {
-				if(relays[i].relayId == relay_id) {
-					Relay &relay = relays[i];
-					Leg &leg = relay.legs[legno - 1];
-					leg.spos = ++pos;
-					break;
-				}
-			}
-		}
+		for(const QPair<int, int> &p : relay_stime)
+			relays[p.first].legs[legno - 1].spos = ++pos;
 	}
 	if(exclude_not_finish) {
 		/*
@@ -463,3 +313,210 @@ qf::core::utils::TreeTable RelaysPlugin::nLegsClassResultsTable(int class_id, in
 }
 
 }
+
+qf::core::utils::TreeTable RelaysPlugin::nLegsResultsTable(const QString &where_option, int leg_count, int places, bool exclude_not_finish)
+{
+	qfLogFuncFrame() << "leg cnt:" << leg_count;
+	qf::core::utils::TreeTable tt;
+	tt.setValue("event", getPlugin<EventPlugin>()->eventConfig()->value("event"));
+	tt.setValue("stageStart", getPlugin<EventPlugin>()->stageStartDateTime(1));
+	tt.appendColumn("className", QVariant::String);
+	qfs::QueryBuilder qb;
+	qb.select2("classes", "id, name")
+			.from("classes")
+			.orderBy("classes.name");
+	if(!where_option.isEmpty()) {
+		qb.where(where_option);
+	}
+	qfs::Query q;
+	q.execThrow(qb.toString());
+	QList<QPair<int, QVariant>> classes;
+	while(q.next())
+		classes << QPair<int, QVariant>(q.value("classes.id").toInt(), q.value("classes.name"));
+	QList<int> class_ids;
+	for(const QPair<int, QVariant> &c : classes)
+		class_ids << c.first;
+	QMap<int, qf::core::utils::TreeTable> class_results = nLegsClassResultsTables(class_ids, leg_count, places, exclude_not_finish);
+	for(const QPair<int, QVariant> &c : classes) {
+		int ix = tt.appendRow();
+		qf::core::utils::TreeTableRow tt_row = tt.row(ix);
+		tt_row.setValue("className", c.second);
+		qf::core::utils::TreeTable tt2 = class_results.value(c.first);
+		tt_row.appendTable(tt2);
+		tt.setRow(ix, tt_row);
+		//qfDebug() << tt2.toString();
+	}
+	auto wt = [tt]() {
+		QFile f("/home/fanda/t/relays.json");
+		f.open(QFile::WriteOnly);
+		f.write(tt.toString().toUtf8());
+		return f.fileName();
+	};
+	qfDebug() << "nLegsResultsTable table:" << wt();
+	return tt;
+}
+
+qf::core::utils::TreeTable RelaysPlugin::nLegsClassResultsTable(int class_id, int leg_count, int max_places, bool exclude_not_finish)
+{
+	return nLegsClassResultsTables(QList<int>{class_id}, leg_count, max_places, exclude_not_finish).value(class_id);
+}
+
+QMap<int, qf::core::utils::TreeTable> RelaysPlugin::nLegsClassResultsTables(const QList<int> &class_ids, int leg_count, int max_places, bool exclude_not_finish)
+{
+	QElapsedTimer tmr;
+	tmr.start();
+	QMap<int, qf::core::utils::TreeTable> ret;
+	if(class_ids.isEmpty())
+		return ret;
+	QStringList class_id_list;
+	for(int class_id : class_ids)
+		class_id_list << QString::number(class_id);
+	const QString class_ids_str = class_id_list.join(',');
+	qfs::Query q;
+	/// class id -> legs count
+	QHash<int, int> class_leg_counts;
+	int max_leg_count = 0;
+	{
+		qfs::QueryBuilder qb;
+		qb.select2("classdefs", "classId, relayLegCount")
+			.from("classdefs")
+			.where("classdefs.classId IN (" + class_ids_str + ")");
+		q.execThrow(qb.toString());
+		while(q.next()) {
+			int class_id = q.value("classdefs.classId").toInt();
+			if(class_leg_counts.contains(class_id))
+				continue;
+			int class_leg_count = qMin(leg_count, q.value("classdefs.relayLegCount").toInt());
+			class_leg_counts[class_id] = class_leg_count;
+			max_leg_count = qMax(max_leg_count, class_leg_count);
+		}
+	}
+	for(int class_id : class_ids) {
+		if(class_leg_counts.value(class_id) <= 0) {
+			qfError() << "Leg count not defined for class id:" << class_id;
+			class_leg_counts.remove(class_id);
+		}
+	}
+	if(class_leg_counts.isEmpty())
+		return ret;
+
+	/// relays of all the classes, they are split per class when legs are loaded
+	QVector<Relay> relays;
+	QVector<int> relay_class_ids;
+	QHash<int, int> relay_id_to_index;
+	{
+		qfs::QueryBuilder qb;
+		qb.select2("relays", "id, classId, club, name, number")
+				.select2("clubs", "name")
+				.from("relays")
+				.join("relays.club", "clubs.abbr")
+				.where("relays.classId IN (" + class_ids_str + ")");
+		q.execThrow(qb.toString());
+		while(q.next()) {
+			int class_id = q.value("relays.classId").toInt();
+			if(!class_leg_counts.contains(class_id))
+				continue;
+			Relay r;
+			r.relayId = q.value("relays.id").toInt();
+			r.relayNumber = q.value("relays.number").toInt();
+			r.name = (q.value("relays.number").toString()
+					+ ' ' + q.value("relays.club").toString()
+					+ ' ' + q.value("relays.name").toString()
+					+ ' ' + q.value("clubs.name").toString()).trimmed();
+			r.legs.resize(class_leg_counts.value(class_id));
+			relay_id_to_index[r.relayId] = relays.count();
+			relays << r;
+			relay_class_ids << class_id;
+			qfDebug() << r.name;
+		}
+	}
+	{
+		qfs::QueryBuilder qb;
+		qb.select2("competitors", "id, registration")
+				.select2("runs", "id, relayId, leg")
+				.select2("competitors", "firstName, lastName")
+				.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
+				.from("runs")
+				.join("runs.competitorId", "competitors.id")
+				.joinRestricted("runs.relayId", "relays.id", "relays.classId IN (" + class_ids_str + ")", qfs::QueryBuilder::INNER_JOIN)
+				.where("runs.leg>0 AND runs.leg<=" + QString::number(max_leg_count))
+				.orderBy("runs.relayId, runs.leg");
+		q.execThrow(qb.toString());
+		while(q.next()) {
+			int relay_ix = relay_id_to_index.value(q.value("runs.relayId").toInt(), -1);
+			if(relay_ix < 0)
+				continue;
+			Relay &relay = relays[relay_ix];
+			int legno = q.value("runs.leg").toInt();
+			if(legno > relay.legs.count())
+				continue;
+			Leg &leg = relay.legs[legno - 1];
+			leg.fullName = q.value("competitorName").toString();
+			leg.firstName = q.value("firstName").toString();
+			leg.lastName = q.value("lastName").toString();
+			leg.runId = q.value("runs.id").toInt();
+			leg.reg = q.value("competitors.registration").toString();
+			//leg.courseId = getPlugin<RunsPlugin>()->courseForRun(leg.runId);
+		}
+	}
+	{
+		/// finished legs of all the classes, positions are counted per class and leg
+		qfs::QueryBuilder qb;
+		qb.select2("runs", "id, relayId, leg, timeMs, disqualified, notCompeting")
+				.select2("relays", "classId")
+				.from("runs")
+				.joinRestricted("runs.relayId", "relays.id",
+								"relays.classId IN (" + class_ids_str + ")"
+								" AND runs.leg>0 AND runs.leg<=" + QString::number(max_leg_count) +
+								" AND runs.isRunning"
+								" AND NOT runs.notCompeting"
+								" AND runs.finishTimeMs>0"
+								, qfs::QueryBuilder::INNER_JOIN)
+				.orderBy("relays.classId, runs.leg, runs.disqualified, runs.timeMs");
+		q.execThrow(qb.toString());
+		int prev_class_id = -1;
+		int prev_legno = -1;
+		int run_pos = 1;
+		while(q.next()) {
+			int class_id = q.value("relays.classId").toInt();
+			int legno = q.value("runs.leg").toInt();
+			if(class_id != prev_class_id || legno != prev_legno) {
+				prev_class_id = class_id;
+				prev_legno = legno;
+				run_pos = 1;
+			}
+			int relay_ix = relay_id_to_index.value(q.value("runs.relayId").toInt(), -1);
+			if(relay_ix < 0)
+				continue;
+			Relay &relay = relays[relay_ix];
+			if(legno > relay.legs.count())
+				continue;
+			int run_id = q.value("runs.id").toInt();
+			Leg &leg = relay.legs[legno - 1];
+			if(leg.runId != run_id) {
+				qfError() << "internal error, leg:" << legno << "runId check:" << leg.runId << "should equal" << run_id;
+			}
+			else {
+				leg.notfinish = false;
+				leg.nc = q.value("runs.notCompeting").toBool();
+				leg.disq = q.value("runs.disqualified").toBool();
+				leg.time = q.value("timeMs").toInt();
+				leg.pos = leg.disq? 0: run_pos;
+				run_pos++;
+			}
+		}
+	}
+	QHash<int, QList<Relay>> class_relays;
+	for (int i = 0; i < relays.count(); ++i)
+		class_relays[relay_class_ids[i]] << relays[i];
+	for(int class_id : class_ids) {
+		if(!class_leg_counts.contains(class_id) || ret.contains(class_id))
+			continue;
+		QList<Relay> &cl_relays = class_relays[class_id];
+		ret[class_id] = relaysResultsTable(cl_relays, class_leg_counts.value(class_id), max_places, exclude_not_finish);
+	}
+	qfInfo() << "relays results of" << ret.count() << "classes and" << relays.count() << "relays computed in" << tmr.elapsed() << "msec";
+	return ret;
+}
+
+}
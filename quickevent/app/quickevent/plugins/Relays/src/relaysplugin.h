@@ -4,6 +4,8 @@
 
 #include <qf/core/utils.h>
 
+#include <QMap>
+
 namespace qf {
 
 namespace core {  namespace model { class SqlTableModel; }}
@@ -44,6 +46,8 @@ public:
 
 	qf::core::utils::TreeTable nLegsResultsTable(const QString &where_option, int leg_count, int places, bool exclude_not_finish);
 	qf::core::utils::TreeTable nLegsClassResultsTable(int class_id, int leg_count, int places, bool exclude_not_finish);
+	/// results of more classes loaded by one query per table, class id -> results
+	QMap<int, qf::core::utils::TreeTable> nLegsClassResultsTables(const QList<int> &class_ids, int leg_count, int places, bool exclude_not_finish);
 private:
 	Q_SLOT void onInstalled();
 	void onDbEventNotify(const QString &domain, int connection_id, const QVariant &data);
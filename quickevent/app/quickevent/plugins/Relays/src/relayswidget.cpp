@@ -251,6 +251,8 @@ void RelaysWidget::editRelay(const QVariant &id, int mode)
 	}
 	connect(doc, &Relays:: RelayDocument::saved, ui->tblRelays, &qf::qmlwidgets::TableView::rowExternallySaved, Qt::QueuedConnection);
 	bool ok = dlg.exec();
+	/// legs are edited directly in runs table
+	getPlugin<EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_RUNS_CHANGED);
 	//if(ok)
 	//	transaction.commit();
 	//else
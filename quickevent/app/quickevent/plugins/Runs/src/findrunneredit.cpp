@@ -6,6 +6,7 @@
 #include <qf/qmlwidgets/log.h>
 
 #include <qf/core/utils/table.h>
+#include <qf/core/utils/trigramindex.h>
 #include <qf/core/model/sqltablemodel.h>
 #include <qf/core/assert.h>
 
@@ -24,9 +25,14 @@ public:
 	int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
 	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
 	const qf::core::utils::Table& runnersTable() const {return m_runnersTable;}
-	void setRunnersTable(const qf::core::utils::Table &t);
+	void setRunnersTable(const qf::core::utils::Table &t, const qf::core::utils::TrigramIndex &search_index);
+	/// runnersTable() row number of found row
+	int tableRow(int found_row) const {return m_foundRows.value(found_row, -1);}
+	void setFilter(const QString &text);
 private:
 	qf::core::utils::Table m_runnersTable;
+	qf::core::utils::TrigramIndex m_searchIndex;
+	QVector<int> m_foundRows;
 };
 
 FindRunnersModel::FindRunnersModel(QObject *parent)
@@ -34,22 +40,32 @@ FindRunnersModel::FindRunnersModel(QObject *parent)
 {
 }
 
-void FindRunnersModel::setRunnersTable(const qf::core::utils::Table &t)
+void FindRunnersModel::setRunnersTable(const qf::core::utils::Table &t, const qf::core::utils::TrigramIndex &search_index)
 {
+	beginResetModel();
 	m_runnersTable = t;
+	m_searchIndex = search_index;
+	m_foundRows.clear();
+	endResetModel();
+}
+
+void FindRunnersModel::setFilter(const QString &text)
+{
+	beginResetModel();
+	m_foundRows = m_searchIndex.search(text, FindRunnerEdit::MAX_FOUND_ROWS);
+	endResetModel();
 }
 
 int FindRunnersModel::rowCount(const QModelIndex &parent) const
 {
 	Q_UNUSED(parent)
-	const qf::core::utils::Table &table = runnersTable();
-	return table.rowCount();
+	return m_foundRows.count();
 }
 
 QVariant FindRunnersModel::data(const QModelIndex &index, int role) const
 {
 	const qf::core::utils::Table &table = runnersTable();
-	int row_no = index.row();
+	int row_no = tableRow(index.row());
 	if(row_no >= 0 && row_no < table.rowCount()) {
 		qf::core::utils::TableRow table_row = table.row(row_no);
 		const qf::core::utils::Table::FieldList &fields = table.fields();
@@ -81,18 +97,28 @@ FindRunnerEdit::FindRunnerEdit(QWidget *parent)
 {	
 }
 
-void FindRunnerEdit::setTable(const qf::core::utils::Table &t)
+void FindRunnerEdit::setTable(const qf::core::utils::Table &t, const qf::core::utils::TrigramIndex &search_index)
 {
 	//QF_SAFE_DELETE(m_findRunnersModel);
 	QF_SAFE_DELETE(m_completer);
 	m_completer = new QCompleter(this);
 	m_completer->setCaseSensitivity(Qt::CaseInsensitive);
 	m_completer->setFilterMode(Qt::MatchContains);
+	/// rows are filtered by trigram index, completer shows them all
+	m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
 	m_findRunnersModel = new FindRunnersModel(m_completer);
-	m_findRunnersModel->setRunnersTable(t);
+	m_findRunnersModel->setRunnersTable(t, search_index);
 	m_completer->setModel(m_findRunnersModel);
 	connect(m_completer, SIGNAL(activated(QModelIndex)), this, SLOT(onCompleterActivated(QModelIndex)));
 	setCompleter(m_completer);
+	/// textEdited is emitted before QLineEdit updates completer popup
+	connect(this, &FindRunnerEdit::textEdited, this, &FindRunnerEdit::onTextEdited, Qt::UniqueConnection);
+}
+
+void FindRunnerEdit::onTextEdited(const QString &text)
+{
+	if(m_findRunnersModel)
+		m_findRunnersModel->setFilter(text);
 }
 
 QVariantMap FindRunnerEdit::selectedRunner() const
@@ -107,7 +133,7 @@ void FindRunnerEdit::onCompleterActivated(const QModelIndex &index)
 	QF_ASSERT(proxy_model != nullptr, "Bat proxy model!", return);
 	QModelIndex ix = proxy_model->mapToSource(index);
 	const qf::core::utils::Table &table = m_findRunnersModel->runnersTable();
-	int row_no = ix.row();
+	int row_no = m_findRunnersModel->tableRow(ix.row());
 	if(row_no >= 0 && row_no < table.rowCount()) {
 		qf::core::utils::TableRow table_row = table.row(row_no);
 		m_selectedRunner = table_row.valuesMap(false);
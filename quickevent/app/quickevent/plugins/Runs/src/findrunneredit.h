@@ -6,7 +6,7 @@
 class QCompleter;
 class FindRunnersModel;
 
-namespace qf { namespace core { namespace utils { class Table; }}}
+namespace qf { namespace core { namespace utils { class Table; class TrigramIndex; }}}
 
 class FindRunnerEdit : public QLineEdit
 {
@@ -14,16 +14,20 @@ class FindRunnerEdit : public QLineEdit
 private:
 	typedef QLineEdit Super;
 public:
+	static constexpr int MAX_FOUND_ROWS = 200;
+
 	FindRunnerEdit(QWidget *parent = nullptr);
 
 	//const qf::core::utils::Table& table() const {return m_table;}
-	void setTable(const qf::core::utils::Table &t);
+	/// search_index ids are table row numbers
+	void setTable(const qf::core::utils::Table &t, const qf::core::utils::TrigramIndex &search_index);
 
 	QVariantMap selectedRunner() const;
 
 	Q_SIGNAL void runnerSelected(const QVariantMap &runner_values);
 private:
 	Q_SLOT void onCompleterActivated(const QModelIndex &index);
+	void onTextEdited(const QString &text);
 private:
 	FindRunnersModel *m_findRunnersModel = nullptr;
 	QCompleter *m_completer = nullptr;
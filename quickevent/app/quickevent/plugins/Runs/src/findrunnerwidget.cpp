@@ -24,7 +24,8 @@ FindRunnerWidget::FindRunnerWidget(int stage_id, QWidget *parent)
 {
 	ui->setupUi(this);
 	ui->edFindRunner->setFocus();
-	ui->edFindRunner->setTable(getPlugin<RunsPlugin>()->runnersTable(stage_id));
+	RunsPlugin *plugin = getPlugin<RunsPlugin>();
+	ui->edFindRunner->setTable(plugin->runnersTable(stage_id), plugin->runnersSearchIndex(stage_id));
 	//connect(ui->edFindRunner, &FindRunnerEdit::runnerSelected, this, &FindRunnerWidget::onRunnerSelected);
 }
 
@@ -8,6 +8,7 @@
 
 #include <quickevent/core/codedef.h>
 #include <quickevent/core/utils.h>
+#include <quickevent/core/si/checkedcard.h>
 #include <quickevent/core/si/punchrecord.h>
 
 #include <qf/qmlwidgets/framework/mainwindow.h>
@@ -32,12 +33,14 @@
 #include <quickevent/gui/partwidget.h>
 
 #include <QDesktopServices>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QInputDialog>
 #include <QDir>
 #include <QUrl>
 #include <QTextStream>
 
+#include <algorithm>
 #include <math.h>
 
 namespace qfw = qf::qmlwidgets;
@@ -73,22 +76,35 @@ RunsPlugin::~RunsPlugin()
 {
 }
 
+static qfs::QueryBuilder runnersTableQueryBuilder(int stage_id)
+{
+	qfs::QueryBuilder qb;
+	qb.select2("competitors", "registration")
+			.select("COALESCE(lastName, '') || ' ' || COALESCE(firstName, '') AS competitorName")
+			.select2("runs", "id, siId, competitorId")
+			.select("runs.id AS runId")
+			.select2("classes", "name")
+			.from("competitors")
+			.join("competitors.classId", "classes.id")
+			.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId=" QF_IARG(stage_id), "JOIN")
+			.orderBy("classes.name, lastName, firstName");
+	return qb;
+}
+
+static void setRunnerNameAscii7(qf::core::utils::TableRow &row_ref, int ix_nsk, int ix_cname)
+{
+	QString nsk = row_ref.value(ix_cname).toString();
+	nsk = QString::fromLatin1(qf::core::Collator::toAscii7(QLocale::Czech, nsk, true));
+	row_ref.setValue(ix_nsk, nsk);
+}
+
 const qf::core::utils::Table &RunsPlugin::runnersTable(int stage_id)
 {
 	if(m_runnersTableCacheStageId != stage_id) {
-		qfs::QueryBuilder qb;
-		qb.select2("competitors", "registration")
-				.select("COALESCE(lastName, '') || ' ' || COALESCE(firstName, '') AS competitorName")
-				.select2("runs", "id, siId, competitorId")
-				.select("runs.id AS runId")
-				.select2("classes", "name")
-				.from("competitors")
-				.join("competitors.classId", "classes.id")
-				.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId=" QF_IARG(stage_id), "JOIN")
-				.orderBy("classes.name, lastName, firstName");
 		qf::core::model::SqlTableModel m;
-		m.setQueryBuilder(qb, false);
+		m.setQueryBuilder(runnersTableQueryBuilder(stage_id), false);
 		m.reload();
+		m.tableRef().setReadOnly(true);
 		m_runnersTableCache = m.table();
 
 		auto c_nsk = QStringLiteral("competitorNameAscii7");
@@ -97,19 +113,111 @@ const qf::core::utils::Table &RunsPlugin::runnersTable(int stage_id)
 		int ix_cname = m_runnersTableCache.fields().fieldIndex(QStringLiteral("competitorName"));
 		for (int i = 0; i < m_runnersTableCache.rowCount(); ++i) {
 			qf::core::utils::TableRow &row_ref = m_runnersTableCache.rowRef(i);
-			QString nsk = row_ref.value(ix_cname).toString();
-			nsk = QString::fromLatin1(qf::core::Collator::toAscii7(QLocale::Czech, nsk, true));
-			row_ref.setValue(ix_nsk, nsk);
+			setRunnerNameAscii7(row_ref, ix_nsk, ix_cname);
 		}
+		/// runners of saved competitor are looked up in updateRunnersTableCache()
+		m_runnersTableCache.addIndex(QStringLiteral("runs.competitorId"));
+		m_runnersSearchIndex.clear();
+		for (int i = 0; i < m_runnersTableCache.rowCount(); ++i)
+			m_runnersSearchIndex.insert(i, runnerSearchText(m_runnersTableCache.row(i)));
 		m_runnersTableCacheStageId = stage_id;
 	}
 	return m_runnersTableCache;
 }
 
+const qf::core::utils::TrigramIndex &RunsPlugin::runnersSearchIndex(int stage_id)
+{
+	runnersTable(stage_id);
+	return m_runnersSearchIndex;
+}
+
+QString RunsPlugin::runnerSearchText(const qf::core::utils::TableRow &row)
+{
+	return row.value(QStringLiteral("classes.name")).toString() + ' '
+			+ row.value(QStringLiteral("competitorNameAscii7")).toString() + ' '
+			+ row.value(QStringLiteral("registration")).toString() + ' '
+			+ QStringLiteral("SI:") + row.value(QStringLiteral("runs.siId")).toString();
+}
+
 void RunsPlugin::clearRunnersTableCache()
 {
 	//qfInfo() << QF_FUNC_NAME;
 	m_runnersTableCacheStageId = 0;
+	m_runnersSearchIndex.clear();
+}
+
+void RunsPlugin::updateRunnersTableCache(int competitor_id)
+{
+	qfLogFuncFrame() << "competitor id:" << competitor_id;
+	if(m_runnersTableCacheStageId == 0)
+		return;
+	if(competitor_id <= 0) {
+		clearRunnersTableCache();
+		return;
+	}
+	qfs::QueryBuilder qb = runnersTableQueryBuilder(m_runnersTableCacheStageId);
+	qb.where("competitors.id=" QF_IARG(competitor_id));
+	qf::core::model::SqlTableModel m;
+	m.setQueryBuilder(qb, false);
+	m.reload();
+	const qf::core::utils::Table &t = m.table();
+	int ix_competitor_id = m_runnersTableCache.fields().fieldIndex(QStringLiteral("runs.competitorId"));
+	int ix_nsk = m_runnersTableCache.fields().fieldIndex(QStringLiteral("competitorNameAscii7"));
+	int ix_cname = m_runnersTableCache.fields().fieldIndex(QStringLiteral("competitorName"));
+	/// runners of deleted competitor stay in table, but they cannot be found any more
+	/// row numbers must not change, they are ids in search index
+	QList<int> row_nos = m_runnersTableCache.findAll(ix_competitor_id, competitor_id);
+	for(int row_no : row_nos)
+		m_runnersSearchIndex.remove(row_no);
+	for (int i = 0; i < t.rowCount(); ++i) {
+		qf::core::utils::TableRow src_row = t.row(i);
+		int row_no = (i < row_nos.count())? row_nos.value(i): m_runnersTableCache.rowCount();
+		if(row_no == m_runnersTableCache.rowCount())
+			m_runnersTableCache.appendRow();
+		/// values are set through table to keep competitorId index up to date
+		for (int j = 0; j < t.columnCount(); ++j)
+			m_runnersTableCache.setValue(row_no, j, src_row.value(j));
+		qf::core::utils::TableRow &row_ref = m_runnersTableCache.rowRef(row_no);
+		setRunnerNameAscii7(row_ref, ix_nsk, ix_cname);
+		m_runnersSearchIndex.insert(row_no, runnerSearchText(row_ref));
+	}
+}
+
+void RunsPlugin::clearStageResultsCache()
+{
+	m_stageResultsCache.clear();
+}
+
+void RunsPlugin::onDbEventNotify(const QString &domain, int connection_id, const QVariant &data)
+{
+	Q_UNUSED(connection_id)
+	if(domain == QLatin1String(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED)
+			|| domain == QLatin1String(Event::EventPlugin::DBEVENT_RUNS_CHANGED)) {
+		/// payload does not identify competitors, runners table and its search index are reloaded on next search
+		/// local competitor edits without db event, like name changes, are updated incrementally in updateRunnersTableCache()
+		clearRunnersTableCache();
+	}
+	if(domain == QLatin1String(Event::EventPlugin::DBEVENT_CARD_PROCESSED_AND_ASSIGNED)) {
+		quickevent::core::si::CheckedCard checked_card(data.toMap());
+		int run_id = checked_card.runId();
+		qfs::Query q;
+		q.exec("SELECT runs.stageId, competitors.classId FROM runs"
+			   " JOIN competitors ON runs.competitorId=competitors.id"
+			   " WHERE runs.id=" QF_IARG(run_id));
+		if(q.next())
+			m_stageResultsCache.invalidateClass(q.value(0).toInt(), q.value(1).toInt());
+		else
+			clearStageResultsCache();
+	}
+	else if(domain == QLatin1String(Event::EventPlugin::DBEVENT_COMPETITOR_COUNTS_CHANGED)
+			|| domain == QLatin1String(Event::EventPlugin::DBEVENT_RUNS_CHANGED)
+			|| domain == QLatin1String(Event::EventPlugin::DBEVENT_COURSES_CHANGED)) {
+		/// laps results keep course definitions
+		clearStageResultsCache();
+	}
+	else if(domain == QLatin1String(Event::EventPlugin::DBEVENT_STAGE_START_CHANGED)) {
+		m_stageResultsCache.invalidateStage(data.toInt());
+	}
 }
 
 void RunsPlugin::onInstalled()
@@ -118,7 +226,10 @@ void RunsPlugin::onInstalled()
 	qff::MainWindow *fwk = qff::MainWindow::frameWork();
 	qff::initPluginWidget<RunsWidget, PartWidget>(tr("&Runs"), featureId());
 
-	connect(getPlugin<CompetitorsPlugin>(), SIGNAL(competitorEdited()), this, SLOT(clearRunnersTableCache()));
+	connect(getPlugin<CompetitorsPlugin>(), &CompetitorsPlugin::competitorSaved, this, &RunsPlugin::updateRunnersTableCache);
+	connect(getPlugin<CompetitorsPlugin>(), SIGNAL(competitorEdited()), this, SLOT(clearStageResultsCache()));
+	connect(getPlugin<EventPlugin>(), &EventPlugin::eventOpenChanged, this, &RunsPlugin::clearStageResultsCache);
+	connect(getPlugin<EventPlugin>(), &EventPlugin::dbEventNotify, this, &RunsPlugin::onDbEventNotify);
 
 	{
 		m_eventStatisticsDockWidget = new qff::DockWidget(nullptr);
@@ -189,11 +300,11 @@ quickevent::core::CourseDef RunsPlugin::courseCodesForRunId(int run_id)
 quickevent::core::CourseDef RunsPlugin::courseForCourseId(int course_id)
 {
 	qfLogFuncFrame() << "course id:" << course_id;
-	quickevent::core::CourseDef ret;
 	if(course_id <= 0) {
 		qfError() << "Course ID == 0";
-		return ret;
+		return quickevent::core::CourseDef();
 	}
+	QVariantMap course_record;
 	{
 		qfs::QueryBuilder qb;
 		qb.select2("courses", "*")
@@ -202,11 +313,9 @@ quickevent::core::CourseDef RunsPlugin::courseForCourseId(int course_id)
 		qfs::Query q;
 		q.exec(qb.toString(), qf::core::Exception::Throw);
 		if(q.next())
-			ret = q.values();
+			course_record = q.values();
 	}
-	quickevent::core::CodeDef start_code;
-	QVariantList codes;
-	quickevent::core::CodeDef finish_code;
+	QList<quickevent::core::CodeDef> course_codes;
 	{
 		qfs::QueryBuilder qb;
 		qb.select2("coursecodes", "position")
@@ -219,17 +328,28 @@ quickevent::core::CourseDef RunsPlugin::courseForCourseId(int course_id)
 		//qfWarning() << qb.toString();
 		q.exec(qb.toString(), qf::core::Exception::Throw);
 		while (q.next()) {
-			quickevent::core::CodeDef cd(q.values());
-			quickevent::core::CodeDef::Type control_type = cd.type();
-			if(control_type == quickevent::core::CodeDef::Type::Start) {
-				start_code = cd;
-			}
-			else if(control_type == quickevent::core::CodeDef::Type::Finish) {
-				finish_code = cd;
-			}
-			else if(control_type == quickevent::core::CodeDef::Type::Control) {
-				codes << cd;
-			}
+			course_codes << quickevent::core::CodeDef(q.values());
+		}
+	}
+	return courseDefFromCodes(course_record, course_codes);
+}
+
+quickevent::core::CourseDef RunsPlugin::courseDefFromCodes(const QVariantMap &course_record, const QList<quickevent::core::CodeDef> &course_codes)
+{
+	quickevent::core::CourseDef ret(course_record);
+	quickevent::core::CodeDef start_code;
+	QVariantList codes;
+	quickevent::core::CodeDef finish_code;
+	for(const quickevent::core::CodeDef &cd : course_codes) {
+		quickevent::core::CodeDef::Type control_type = cd.type();
+		if(control_type == quickevent::core::CodeDef::Type::Start) {
+			start_code = cd;
+		}
+		else if(control_type == quickevent::core::CodeDef::Type::Finish) {
+			finish_code = cd;
+		}
+		else if(control_type == quickevent::core::CodeDef::Type::Control) {
+			codes << cd;
 		}
 	}
 
@@ -270,9 +390,10 @@ int RunsPlugin::courseForRun_Classic(int run_id)
 			.from("runs")
 			.join("runs.competitorId", "competitors.id")
 			.joinRestricted("competitors.classId", "classdefs.classId", "classdefs.stageId=runs.stageId")
-			.where("runs.id=" QF_IARG(run_id));
+			.where("runs.id=:runId")
+			.bindValue(QStringLiteral(":runId"), run_id);
 	qfs::Query q;
-	q.exec(qb.toString(), qf::core::Exception::Throw);
+	q.execCached(qb, qf::core::Exception::Throw);
 	int cnt = 0;
 	int ret = 0;
 	while (q.next()) {
@@ -294,9 +415,10 @@ int RunsPlugin::courseForRun_Relays(int run_id)
 			.select2("runs", "leg")
 			.from("runs")
 			.join("runs.relayId", "relays.id")
-			.where("runs.id=" QF_IARG(run_id));
+			.where("runs.id=:runId")
+			.bindValue(QStringLiteral(":runId"), run_id);
 	qfs::Query q;
-	q.exec(qb.toString(), qf::core::Exception::Throw);
+	q.execCached(qb, qf::core::Exception::Throw);
 	if(q.next()) {
 		int relay_num = q.value("number").toInt();
 		int leg = q.value("leg").toInt();
@@ -385,13 +507,28 @@ int RunsPlugin::cardForRun(int run_id)
 
 qf::core::utils::Table RunsPlugin::nstagesClassResultsTable(int stages_count, int class_id, int places, bool exclude_disq)
 {
+	return nstagesClassResultsTables(stages_count, QList<int>{class_id}, places, exclude_disq).value(class_id);
+}
+
+QMap<int, qf::core::utils::Table> RunsPlugin::nstagesClassResultsTables(int stages_count, const QList<int> &class_ids, int places, bool exclude_disq)
+{
+	QElapsedTimer tmr;
+	tmr.start();
+	QMap<int, qf::core::utils::Table> ret;
+	if(class_ids.isEmpty())
+		return ret;
+	QStringList class_id_list;
+	for(int class_id : class_ids)
+		class_id_list << QString::number(class_id);
+	const QString class_ids_where = "competitors.classId IN (" + class_id_list.join(',') + ")";
+
 	qfs::QueryBuilder qb;
 	qb.select2("competitors", "id, registration, licence")
 			.select2("clubs","name")
 			.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
 			.from("competitors")
 			.join("LEFT JOIN clubs ON substr(competitors.registration, 1, 3) = clubs.abbr")
-			.where("competitors.classId=" QF_IARG(class_id));
+			.where(class_ids_where);
 	for (int stage_id = 1; stage_id <= stages_count; ++stage_id) {
 		//qb.select("0 AS runId" QF_IARG(stage_id));
 		qb.select(QF_IARG(UNREAL_TIME_MSEC) " AS timeMs" QF_IARG(stage_id));
@@ -400,88 +537,137 @@ qf::core::utils::Table RunsPlugin::nstagesClassResultsTable(int stages_count, in
 	qb.select(QF_IARG(UNREAL_TIME_MSEC) " AS timeMs");
 	qb.select(QF_IARG(UNREAL_TIME_MSEC) " AS timeLossMs");
 	qb.select("'' AS pos");
+	qb.select2("competitors", "classId");
 	qf::core::model::SqlTableModel mod;
 	mod.setQueryBuilder(qb, false);
 	mod.reload();
-	QMap<int, int> competitor_id_to_row;
-	for (int j = 0; j < mod.rowCount(); ++j) {
-		competitor_id_to_row[mod.value(j, "competitors.id").toInt()] = j;
-	}
+	const qfu::Table competitors = mod.table();
+	const qfu::Table::FieldList &fields = competitors.fields();
+	const int col_competitor_id = fields.fieldIndex(QStringLiteral("competitors.id"));
+	const int col_class_id = fields.fieldIndex(QStringLiteral("competitors.classId"));
+	const int col_time = fields.fieldIndex(QStringLiteral("timeMs"));
+	const int col_loss = fields.fieldIndex(QStringLiteral("timeLossMs"));
+	const int col_pos = fields.fieldIndex(QStringLiteral("pos"));
+	QVector<int> col_stage_time(stages_count + 1, -1);
+	QVector<int> col_stage_pos(stages_count + 1, -1);
 	for (int stage_id = 1; stage_id <= stages_count; ++stage_id) {
+		col_stage_time[stage_id] = fields.fieldIndex(QStringLiteral("timeMs") + QString::number(stage_id));
+		col_stage_pos[stage_id] = fields.fieldIndex(QStringLiteral("pos") + QString::number(stage_id));
+	}
+
+	/// flat per competitor and stage arrays, competitor index is competitors table row number
+	const int competitor_count = competitors.rowCount();
+	QHash<int, int> competitor_id_to_index;
+	competitor_id_to_index.reserve(competitor_count);
+	for (int j = 0; j < competitor_count; ++j)
+		competitor_id_to_index[competitors.row(j).value(col_competitor_id).toInt()] = j;
+	QVector<int> stage_times(competitor_count * stages_count, UNREAL_TIME_MSEC);
+	QVector<QString> stage_positions(competitor_count * stages_count);
+	QVector<bool> stage_ok(competitor_count * stages_count, false);
+	{
+		/// runs of all the stages and classes, positions are counted per class and stage
 		qfs::QueryBuilder qb;
-		qb.select2("runs", "competitorId, timeMs, notCompeting, disqualified")
+		qb.select2("runs", "competitorId, stageId, timeMs, notCompeting, disqualified")
+				.select2("competitors", "classId")
 				.from("competitors")
-				.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId=" QF_IARG(stage_id) " AND runs.isRunning AND runs.finishTimeMs>0", "JOIN")
-				.where("competitors.classId=" QF_IARG(class_id))
-				.orderBy("runs.notCompeting, runs.disqualified, runs.timeMs");
+				.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId>=1 AND runs.stageId<=" QF_IARG(stages_count) " AND runs.isRunning AND runs.finishTimeMs>0", "JOIN")
+				.where(class_ids_where)
+				.orderBy("competitors.classId, runs.stageId, runs.notCompeting, runs.disqualified, runs.timeMs");
 		qfs::Query q;
 		q.exec(qb.toString());
+		int prev_class_id = -1;
+		int prev_stage_id = -1;
 		int pos = 0;
 		while (q.next()) {
+			int class_id = q.value(5).toInt();
+			int stage_id = q.value(1).toInt();
+			if(class_id != prev_class_id || stage_id != prev_stage_id) {
+				prev_class_id = class_id;
+				prev_stage_id = stage_id;
+				pos = 0;
+			}
 			++pos;
-			int competitor_id = q.value("competitorId").toInt();
-			int row_ix = competitor_id_to_row.value(competitor_id, -1);
-			QF_ASSERT(row_ix >= 0, "Bad row index!", continue);
+			int competitor_id = q.value(0).toInt();
+			int competitor_ix = competitor_id_to_index.value(competitor_id, -1);
+			QF_ASSERT(competitor_ix >= 0, "Bad row index!", continue);
+			int ix = competitor_ix * stages_count + stage_id - 1;
+			bool not_competing = q.value(3).toBool();
+			bool disqualified = q.value(4).toBool();
 			QString p = QString::number(pos);
-			if(q.value("notCompeting").toBool())
+			if(not_competing)
 				p = "N";
-			if(q.value("disqualified").toBool())
+			if(disqualified)
 				p = "D";
-			mod.setValue(row_ix, QString("pos%1").arg(stage_id), p);
-			mod.setValue(row_ix, QString("timeMs%1").arg(stage_id), q.value("timeMs"));
+			stage_positions[ix] = p;
+			stage_times[ix] = q.value(2).toInt();
+			stage_ok[ix] = !not_competing && !disqualified;
 		}
 	}
-	for (int j = 0; j < mod.rowCount(); ++j) {
+
+	/// class id -> competitor indexes sorted by overall time
+	QHash<int, QVector<int>> class_competitors;
+	QVector<int> overall_times(competitor_count, UNREAL_TIME_MSEC);
+	for (int j = 0; j < competitor_count; ++j) {
 		int time_ms = 0;
-		for (int stage_id = 1; stage_id <= stages_count; ++stage_id) {
-			QString pos_str = mod.value(j, QString("pos%1").arg(stage_id)).toString();
-			int pos = pos_str.toInt();
-			int tms = mod.value(j, QString("timeMs%1").arg(stage_id)).toInt();
-			if(pos > 0 && tms < UNREAL_TIME_MSEC && time_ms < UNREAL_TIME_MSEC)
+		for (int stage_ix = 0; stage_ix < stages_count; ++stage_ix) {
+			int ix = j * stages_count + stage_ix;
+			int tms = stage_times[ix];
+			if(stage_ok[ix] && tms < UNREAL_TIME_MSEC && time_ms < UNREAL_TIME_MSEC)
 				time_ms += tms;
 			else
 				time_ms = UNREAL_TIME_MSEC;
 		}
-		mod.setValue(j, "timeMs", time_ms);
-	}
-	qfu::Table t = mod.table();
-	t.sort("timeMs");
-	int pos = 0;
-	int time_ms1 = 0;
-	//const bool trim_disq = false;
-	int trim_at = -1;
-	for (int j = 0; j < t.rowCount(); ++j) {
-		++pos;
-		QString p = QString::number(pos) + '.';
-		int time_ms = t.row(j).value("timeMs").toInt();
-		int loss_ms = UNREAL_TIME_MSEC;
-		if(time_ms < UNREAL_TIME_MSEC) {
-			if(time_ms1 == 0)
-				time_ms1 = time_ms;
-			loss_ms = time_ms - time_ms1;
-		}
-		else {
-			if(exclude_disq) {
-				trim_at = j;
+		overall_times[j] = time_ms;
+		class_competitors[competitors.row(j).value(col_class_id).toInt()] << j;
+	}
+	for(int class_id : class_ids) {
+		if(ret.contains(class_id))
+			continue;
+		QVector<int> &competitor_ixs = class_competitors[class_id];
+		std::stable_sort(competitor_ixs.begin(), competitor_ixs.end(), [&overall_times](int a, int b) {
+			return overall_times[a] < overall_times[b];
+		});
+		qfu::Table t(fields);
+		/// results are computed in table, they are never posted back
+		t.setReadOnly(true);
+		int pos = 0;
+		int time_ms1 = 0;
+		for(int competitor_ix : competitor_ixs) {
+			if(places > 0 && pos >= places)
 				break;
+			++pos;
+			QString p = QString::number(pos) + '.';
+			int time_ms = overall_times[competitor_ix];
+			int loss_ms = UNREAL_TIME_MSEC;
+			if(time_ms < UNREAL_TIME_MSEC) {
+				if(time_ms1 == 0)
+					time_ms1 = time_ms;
+				loss_ms = time_ms - time_ms1;
 			}
-			p = "";
+			else {
+				if(exclude_disq)
+					break;
+				p = "";
+			}
+			const qfu::TableRow src_row = competitors.row(competitor_ix);
+			qfu::TableRow &row = t.appendRow();
+			for (int col = 0; col < fields.count(); ++col)
+				row.setValue(col, src_row.value(col));
+			for (int stage_id = 1; stage_id <= stages_count; ++stage_id) {
+				int ix = competitor_ix * stages_count + stage_id - 1;
+				if(!stage_positions[ix].isEmpty()) {
+					row.setValue(col_stage_pos[stage_id], stage_positions[ix]);
+					row.setValue(col_stage_time[stage_id], stage_times[ix]);
+				}
+			}
+			row.setValue(col_time, time_ms);
+			row.setValue(col_pos, p);
+			row.setValue(col_loss, loss_ms);
 		}
-		t.rowRef(j).setValue("pos", p);
-		t.rowRef(j).setValue("timeLossMs", loss_ms);
-	}
-	if(trim_at < 0) {
-		if(places > 0)
-			trim_at = places;
-	}
-	else {
-		if(places > 0 && trim_at > places)
-			trim_at = places;
+		ret[class_id] = t;
 	}
-	if(trim_at >= 0)
-		while(t.rowCount() > trim_at)
-			t.removeRow(trim_at);
-	return t;
+	qfDebug() << "n-stages results of" << ret.count() << "classes and" << competitor_count << "competitors computed in" << tmr.elapsed() << "msec";
+	return ret;
 }
 
 qf::core::utils::TreeTable RunsPlugin::nstagesResultsTable(const QString &class_filter, int stages_count, int places, bool exclude_disq)
@@ -502,11 +688,15 @@ qf::core::utils::TreeTable RunsPlugin::nstagesResultsTable(const QString &class_
 	}
 	mod.reload();
 	qf::core::utils::TreeTable tt = mod.toTreeTable();
+	QList<int> class_ids;
+	for(int i=0; i<tt.rowCount(); i++)
+		class_ids << tt.row(i).value(QStringLiteral("id")).toInt();
+	QMap<int, qf::core::utils::Table> class_results = nstagesClassResultsTables(stages_count, class_ids, places, exclude_disq);
 	for(int i=0; i<tt.rowCount(); i++) {
 		//qfInfo() << "Processing class:" << tt_row.value("name").toString();
 		qf::core::utils::TreeTableRow tt_row = tt.row(i);
 		int class_id = tt_row.value(QStringLiteral("id")).toInt();
-		qf::core::utils::Table t = nstagesClassResultsTable(stages_count, class_id, places, exclude_disq);
+		qf::core::utils::Table t = class_results.value(class_id);
 		qf::core::utils::TreeTable tt2 = t.toTreeTable();
 		tt_row.appendTable(tt2);
 		tt.setRow(i, tt_row);
@@ -535,206 +725,11 @@ qf::core::utils::TreeTable RunsPlugin::currentStageResultsTable(const QString &c
 qf::core::utils::TreeTable RunsPlugin::stageResultsTable(int stage_id, const QString &class_filter, int max_competitors_in_class, bool exclude_disq, bool add_laps)
 {
 	qfLogFuncFrame();
-	qf::core::model::SqlTableModel model;
-	{
-		qf::core::sql::QueryBuilder qb;
-		qb.select2("classes", "id, name")
-			.select2("courses", "id, length, climb")
-			.from("classes")
-			//.where("classes.name NOT IN ('D21B', 'H40B', 'H35C', 'H55B')")
-			.joinRestricted("classes.id", "classdefs.classId", "classdefs.stageId={{stage_id}}")
-			.join("classdefs.courseId", "courses.id")
-			.orderBy("classes.name");//.limit(1);
-		//if(add_laps)
-		//	qb.where("classes.name='H40C'");
-		if(!class_filter.isEmpty()) {
-			qb.where(class_filter);
-		}
-		model.setQueryBuilder(qb, true);
-	}
-	{
-		QVariantMap qm;
-		qm["stage_id"] = stage_id;
-		model.setQueryParameters(qm);
-	}
-	//console.info("currentStageTable query:", reportModel.effectiveQuery());
-	model.reload();
-	qf::core::utils::TreeTable tt = model.toTreeTable();
-	tt.setValue("stageId", stage_id);
-	tt.setValue("event", getPlugin<EventPlugin>()->eventConfig()->value("event"));
-	tt.setValue("stageStart", getPlugin<EventPlugin>()->stageStartDateTime(stage_id));
-
-	{
-		qf::core::sql::QueryBuilder qb;
-		qb.select2("competitors", "registration, lastName, firstName")
-			.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
-			.select2("runs", "*")
-			.select2("clubs", "name")
-			.from("competitors")
-			.join("LEFT JOIN clubs ON substr(competitors.registration, 1, 3) = clubs.abbr")
-			.joinRestricted("competitors.id"
-							, "runs.competitorId"
-							, QStringLiteral("runs.stageId={{stage_id}}"
-											 " AND runs.isRunning"
-											 " AND (runs.finishTimeMs>0 OR runs.checkTimeMs IS NOT NULL)")
-							+ (exclude_disq? " AND NOT runs.disqualified": "")
-							, "JOIN")
-			.where("competitors.classId={{class_id}}")
-			.orderBy("runs.notCompeting, runs.disqualified, runs.timeMs");
-		if(max_competitors_in_class > 0)
-			qb.limit(max_competitors_in_class);
-		qfDebug() << qb.toString();
-		model.setQueryBuilder(qb, true);
-	}
-	for(int i=0; i<tt.rowCount(); i++) {
-		qf::core::utils::TreeTableRow tt_row = tt.row(i);
-		int class_id = tt_row.value("classes.id").toInt();
-		//console.debug("class id:", class_id);
-		QVariantMap qm;
-		qm["stage_id"] = stage_id;
-		qm["class_id"] = class_id;
-		model.setQueryParameters(qm);
-		model.reload();
-		qf::core::utils::TreeTable tt2 = model.toTreeTable();
-		tt2.appendColumn("pos", QVariant::String);
-		tt2.appendColumn("npos", QVariant::Int);
-		tt2.appendColumn("loss", QVariant::Int);
-		int first_time_ms = 0;
-		int prev_time_ms = 0;
-		int prev_pos = 0;
-		for(int j=0; j<tt2.rowCount(); j++) {
-			qf::core::utils::TreeTableRow tt2_row = tt2.row(j);
-			bool has_pos = !tt2_row.value(QStringLiteral("disqualified")).toBool() && !tt2_row.value(QStringLiteral("notCompeting")).toBool();
-			int time_ms = tt2_row.value(QStringLiteral("timeMs")).toInt();
-			if(first_time_ms == 0)
-				first_time_ms = time_ms;
-			if(has_pos) {
-				int pos = j+1;
-				if(time_ms == prev_time_ms)
-					pos = prev_pos;
-				else
-					prev_pos = pos;
-				tt2_row.setValue(QStringLiteral( "pos"), QString::number(pos) + '.');
-				tt2_row.setValue(QStringLiteral( "npos"), pos);
-				tt2_row.setValue(QStringLiteral( "loss"), time_ms - first_time_ms);
-			}
-			else {
-				tt2_row.setValue(QStringLiteral( "pos"), QString());
-				tt2_row.setValue(QStringLiteral( "npos"), 0);
-			}
-			prev_time_ms = time_ms;
-			tt2.setRow(j, tt2_row);
-		}
-		//qfDebug() << tt2.toString();
-		if(add_laps) {
-			int course_id = tt_row.value("courses.id").toInt();
-			QString class_name = tt_row.value("classes.name").toString();
-			tt2 = addLapsToStageResultsTable(course_id, tt2);
-			tt2.setValue("className", class_name);
-			tt2.setValue("stageId", tt.value("stageId"));
-			tt2.setValue("event", tt.value("event"));
-			tt2.setValue("stageStart", tt.value("stageStart"));
-		}
-		tt.appendTable(i, tt2);
-	}
-	return tt;
-}
-
-qf::core::utils::TreeTable RunsPlugin::addLapsToStageResultsTable(int course_id, const qf::core::utils::TreeTable &class_results)
-{
-	qf::core::utils::TreeTable tt = class_results;
-	int col_stp_time0_ix = tt.columnCount();
-	quickevent::core::CourseDef course = courseForCourseId(course_id);
-	tt.setValue("course", course);
-	QVariantList course_codes = course.codes();
-	quickevent::core::CodeDef finish_code = course.finishCode();
-	course_codes << finish_code;
-	for (int i = 0; i < course_codes.count(); ++i) {
-		quickevent::core::CodeDef cd(course_codes[i].toMap());
-		tt.appendColumn(QStringLiteral("stpTime_%1").arg(i), QVariant::Int, QStringLiteral("%1 (%2)").arg(i+1).arg(cd.code()));
-		tt.appendColumn(QStringLiteral("stpPos_%1").arg(i), QVariant::Int);
-		tt.appendColumn(QStringLiteral("lapTime_%1").arg(i), QVariant::Int);
-		tt.appendColumn(QStringLiteral("lapPos_%1").arg(i), QVariant::Int);
-	}
-	QStringList run_ids;
-	for(int i=0; i<tt.rowCount(); i++) {
-		qf::core::utils::TreeTableRow tt_row = tt.row(i);
-		int run_id = tt_row.value(QStringLiteral("runs.id")).toInt();
-		if(run_id > 0)
-			run_ids << QString::number(run_id);
-	}
-	struct RunStp
-	{
-		int runId = 0;
-		int time = 0;
-		int pos = 0;
-	};
-	using RunStpMap = QMap<int, RunStp>; // run_id -> time
-	QMap<int, RunStpMap> stp_times;
-	QMap<int, RunStpMap> lap_times;
-	if(run_ids.count()) {
-		qf::core::sql::QueryBuilder qb;
-		qb.select2("runlaps", "runId, position, code, stpTimeMs, lapTimeMs")
-				.from("runlaps").where("runId IN (" + run_ids.join(',') + ')');
-		qf::core::sql::Query q;
-		q.execThrow(qb.toString());
-		while(q.next()) {
-			int run_id = q.value(0).toInt();
-			if(run_id <= 0)
-				continue;
-			int pos = q.value(1).toInt();
-			int code = q.value(2).toInt();
-			if(pos <= 0 || pos > course_codes.count()) {
-				qfWarning() << "Invalid code:" << code << "position:" << pos;
-				continue;
-			}
-			if(pos < course_codes.count()) {
-				// check code except of the finish one
-				quickevent::core::CodeDef cd(course_codes.value(pos - 1).toMap());
-				if(cd.isEmpty() || cd.code() != code) {
-					qfWarning() << "Invalid code:" << code << "for pos:" << pos;
-					continue;
-				}
-			}
-			int stp = q.value(3).toInt();
-			if(stp <= 0)
-				continue;
-			stp_times[pos][run_id] = RunStp{run_id, stp};
-			int lap = q.value(4).toInt();
-			if(lap <= 0)
-				continue;
-			lap_times[pos][run_id] = RunStp{run_id, lap};
-		}
-	}
-	auto make_pos = [](QMap<int, RunStpMap> &times) {
-		for(int pos : times.keys()) {
-			RunStpMap &map = times[pos];
-			QList<RunStp> lst = map.values();
-			std::sort(lst.begin(), lst.end(), [](const RunStp &a, const RunStp &b) { return a.time < b.time; });
-			for (int i = 0; i < lst.size(); ++i) {
-				const RunStp &rs = lst[i];
-				map[rs.runId].pos = i+1;
-			}
-		}
-	};
-	make_pos(stp_times);
-	make_pos(lap_times);
-	for(int i=0; i<tt.rowCount(); i++) {
-		qf::core::utils::TreeTableRow tt_row = tt.row(i);
-		int run_id = tt_row.value(QStringLiteral("runs.id")).toInt();
-		for (int j = 0; j < course_codes.count(); ++j) {
-			const RunStpMap &stps = stp_times.value(j+1);
-			const RunStp &stprun = stps.value(run_id);
-			const RunStpMap &laps = lap_times.value(j+1);
-			const RunStp &laprun = laps.value(run_id);
-			tt_row.setValue(col_stp_time0_ix + 4*j + 0, stprun.time);
-			tt_row.setValue(col_stp_time0_ix + 4*j + 1, stprun.pos);
-			tt_row.setValue(col_stp_time0_ix + 4*j + 2, laprun.time);
-			tt_row.setValue(col_stp_time0_ix + 4*j + 3, laprun.pos);
-		}
-		tt.setRow(i, tt_row);
-	}
-	return tt;
+	if(class_filter.isEmpty())
+		return m_stageResultsCache.stageResults(stage_id, exclude_disq, add_laps).toTreeTable(max_competitors_in_class);
+	StageResults results(stage_id);
+	results.load(class_filter, exclude_disq, add_laps);
+	return results.toTreeTable(max_competitors_in_class);
 }
 
 QVariant RunsPlugin::stageResultsTableData(int stage_id, const QString &class_filter, int max_competitors_in_class, bool exclude_disq)
@@ -998,10 +993,16 @@ bool RunsPlugin::exportResultsCsosOverall(int stage_count, const QString &file_n
 
 	qfs::Query q;
 	q.exec("SELECT id, name FROM classes ORDER BY name");
+	QList<QPair<int, QString>> classes;
+	QList<int> class_ids;
 	while(q.next()) {
-		int class_id = q.value(0).toInt();
-		QString class_name = q.value(1).toString();
-		qf::core::utils::Table tt = nstagesClassResultsTable(stage_count, class_id, -1, false);
+		classes << QPair<int, QString>(q.value(0).toInt(), q.value(1).toString());
+		class_ids << classes.last().first;
+	}
+	QMap<int, qf::core::utils::Table> class_results = nstagesClassResultsTables(stage_count, class_ids, -1, false);
+	for(const QPair<int, QString> &cls : classes) {
+		const QString &class_name = cls.second;
+		qf::core::utils::Table tt = class_results.value(cls.first);
 		for (int i = 0; i < tt.rowCount(); ++i) {
 			qf::core::utils::TableRow row = tt.row(i);
 			ts << make_width(class_name, -10);
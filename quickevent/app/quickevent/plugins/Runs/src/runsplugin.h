@@ -1,6 +1,8 @@
 #ifndef RUNS_RUNSPLUGIN_H
 #define RUNS_RUNSPLUGIN_H
 
+#include "stageresults.h"
+
 #include <quickevent/core/og/timems.h>
 #include <quickevent/core/coursedef.h>
 #include <quickevent/gui/reportoptionsdialog.h>
@@ -9,6 +11,7 @@
 
 #include <qf/core/utils.h>
 #include <qf/core/utils/table.h>
+#include <qf/core/utils/trigramindex.h>
 
 namespace qf {
 	namespace core {
@@ -50,12 +53,19 @@ public:
 	//Q_SIGNAL void nativeInstalled();
 
 	const qf::core::utils::Table& runnersTable(int stage_id);
+	/// substring search index of runnersTable() rows, row number is id
+	const qf::core::utils::TrigramIndex& runnersSearchIndex(int stage_id);
+	static QString runnerSearchText(const qf::core::utils::TableRow &row);
 	Q_SLOT void clearRunnersTableCache();
+	/// update competitor runner in runners table cache and search index without reloading whole table
+	Q_SLOT void updateRunnersTableCache(int competitor_id);
+	Q_SLOT void clearStageResultsCache();
 
 	Q_INVOKABLE int courseForRun(int run_id);
 	int courseForRelay(int relay_number, int leg);
 	quickevent::core::CourseDef courseCodesForRunId(int run_id);
 	quickevent::core::CourseDef courseForCourseId(int course_id);
+	static quickevent::core::CourseDef courseDefFromCodes(const QVariantMap &course_record, const QList<quickevent::core::CodeDef> &course_codes);
 
 	Q_INVOKABLE int cardForRun(int run_id);
 	qf::core::utils::TreeTable currentStageResultsTable(const QString &class_filter = QString(), int max_competitors_in_class = 0, bool exclude_disq = false);
@@ -65,6 +75,8 @@ public:
 	qf::core::utils::TreeTable stageResultsTable(int stage_id, const QString &class_filter = QString(), int max_competitors_in_class = 0, bool exclude_disq = false, bool add_laps = false);
 
 	qf::core::utils::Table nstagesClassResultsTable(int stages_count, int class_id, int places = -1, bool exclude_disq = true);
+	/// results of more classes computed from one competitors and one runs query, class id -> results
+	QMap<int, qf::core::utils::Table> nstagesClassResultsTables(int stages_count, const QList<int> &class_ids, int places = -1, bool exclude_disq = true);
 	qf::core::utils::TreeTable nstagesResultsTable(const QString &class_filter, int stages_count, int places = -1, bool exclude_disq = true);
 	//Q_INVOKABLE QVariant nstagesResultsTableData(int stages_count, int places = -1, bool exclude_disq = true);
 	Q_INVOKABLE void showRunsTable(int stage_id, int class_id, bool show_offrace, const QString &sort_column = QString(), int select_competitor_id = 0);
@@ -109,8 +121,8 @@ public:
 	void export_resultsHtmlStageWithLaps();
 private:
 	Q_SLOT void onInstalled();
+	void onDbEventNotify(const QString &domain, int connection_id, const QVariant &data);
 
-	qf::core::utils::TreeTable addLapsToStageResultsTable(int course_id, const qf::core::utils::TreeTable &class_results);
 	void exportHtmlStageWithLaps(const QString &laps_file_name, const qf::core::utils::TreeTable &tt);
 
 	int courseForRun_Classic(int run_id);
@@ -123,7 +135,9 @@ private:
 private:
 	qf::qmlwidgets::framework::PartWidget *m_partWidget = nullptr;
 	qf::core::utils::Table m_runnersTableCache;
+	qf::core::utils::TrigramIndex m_runnersSearchIndex;
 	int m_runnersTableCacheStageId = 0;
+	StageResultsCache m_stageResultsCache;
 	qf::qmlwidgets::framework::DockWidget *m_eventStatisticsDockWidget = nullptr;
 };
 
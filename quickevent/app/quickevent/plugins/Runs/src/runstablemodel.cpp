@@ -1,4 +1,7 @@
 #include "runstablemodel.h"
+#include "runsplugin.h"
+
+#include <plugins/Event/src/eventplugin.h>
 
 #include <quickevent/core/og/timems.h>
 #include <quickevent/core/si/siid.h>
@@ -289,6 +292,18 @@ void RunsTableModel::onDataChanged(const QModelIndex &top_left, const QModelInde
 }
 
 bool RunsTableModel::postRow(int row_no, bool throw_exc)
+{
+	bool ret = postRowImpl(row_no, throw_exc);
+	if(ret) {
+		/// manual edits of times and flags are not announced by other db events
+		/// event is sent after row is written, other clients would reload old values otherwise
+		qf::qmlwidgets::framework::getPlugin<Runs::RunsPlugin>()->clearStageResultsCache();
+		qf::qmlwidgets::framework::getPlugin<Event::EventPlugin>()->emitDbEvent(Event::EventPlugin::DBEVENT_RUNS_CHANGED);
+	}
+	return ret;
+}
+
+bool RunsTableModel::postRowImpl(int row_no, bool throw_exc)
 {
 	bool is_single_user = sqlConnection().driverName().endsWith(QLatin1String("SQLITE"), Qt::CaseInsensitive);
 	if(is_single_user)
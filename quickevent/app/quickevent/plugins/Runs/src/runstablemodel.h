@@ -61,6 +61,7 @@ public:
 	Q_SIGNAL void runnerSiIdEdited();
 	Q_SIGNAL void badDataInput(const QString &message);
 private:
+	bool postRowImpl(int row_no, bool throw_exc);
 	void onDataChanged(const QModelIndex &top_left, const QModelIndex &bottom_right, const QVector<int> &roles);
 };
 
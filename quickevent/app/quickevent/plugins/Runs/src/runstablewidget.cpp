@@ -295,6 +295,7 @@ void RunsTableWidget::onCustomContextMenuRequest(const QPoint &pos)
 					q.exec(qf::core::Exception::Throw);
 				}
 				transaction.commit();
+				getPlugin<EventPlugin>()->emitDbEvent(EventPlugin::DBEVENT_RUNS_CHANGED);
 				runsModel()->reload();
 			}
 		}
@@ -316,6 +317,7 @@ void RunsTableWidget::onCustomContextMenuRequest(const QPoint &pos)
 				q.exec(qf::core::Exception::Throw);
 			}
 			transaction.commit();
+			getPlugin<EventPlugin>()->emitDbEvent(EventPlugin::DBEVENT_RUNS_CHANGED);
 			runsModel()->reload();
 		}
 		catch (const qf::core::Exception &e) {
@@ -523,6 +523,7 @@ void RunsWidget::import_start_times_ob2000()
 					}
 				}
 				transaction.commit();
+				getPlugin<EventPlugin>()->emitDbEvent(EventPlugin::DBEVENT_RUNS_CHANGED);
 			}
 			catch (const qf::core::Exception &e) {
 				qf::qmlwidgets::dialogs::MessageBox::showException(this, e);
@@ -885,6 +886,7 @@ void RunsWidget::on_btDraw_clicked()
 			}
 		}
 		transaction.commit();
+		getPlugin<EventPlugin>()->emitDbEvent(EventPlugin::DBEVENT_RUNS_CHANGED);
 	}
 	catch (const qf::core::Exception &e) {
 		qf::qmlwidgets::dialogs::MessageBox::showException(this, e);
@@ -910,6 +912,7 @@ void RunsWidget::on_btDrawRemove_clicked()
 		int stage_id = selectedStageId();
 		saveLockedForDrawing(class_id, stage_id, false, 0);
 		transaction.commit();
+		getPlugin<EventPlugin>()->emitDbEvent(EventPlugin::DBEVENT_RUNS_CHANGED);
 		runs_model->reload();
 	}
 	catch (const qf::core::Exception &e) {
@@ -4,6 +4,7 @@ include($$PWD/services/services.pri)
 
 HEADERS += \
     $$PWD/runsplugin.h \
+    $$PWD/stageresults.h \
     $$PWD/findrunneredit.h \
     $$PWD/findrunnerwidget.h \
     $$PWD/nstagesreportoptionsdialog.h \
@@ -18,6 +19,7 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/runsplugin.cpp \
+    $$PWD/stageresults.cpp \
     $$PWD/findrunneredit.cpp \
     $$PWD/findrunnerwidget.cpp \
     $$PWD/nstagesreportoptionsdialog.cpp \
@@ -0,0 +1,473 @@
+#include "stageresults.h"
+#include "runsplugin.h"
+
+#include <quickevent/core/codedef.h>
+
+#include <qf/qmlwidgets/framework/mainwindow.h>
+
+#include <qf/core/log.h>
+#include <qf/core/sql/query.h>
+#include <qf/core/sql/querybuilder.h>
+#include <qf/core/utils/table.h>
+#include <qf/core/utils/timescope.h>
+#include <qf/core/model/sqltablemodel.h>
+
+#include <plugins/Event/src/eventplugin.h>
+
+#include <QSet>
+
+#include <algorithm>
+
+namespace qfu = qf::core::utils;
+namespace qfs = qf::core::sql;
+using qf::qmlwidgets::framework::getPlugin;
+using Event::EventPlugin;
+
+namespace Runs {
+
+static QString join_ids(const QList<int> &ids)
+{
+	QStringList sl;
+	for(int id : ids)
+		sl << QString::number(id);
+	return sl.join(',');
+}
+
+static QVariantList columns_from_fields(const qfu::Table::FieldList &fields, int skip_ix = -1)
+{
+	QVariantList ret;
+	for (int i = 0; i < fields.count(); ++i) {
+		if(i == skip_ix)
+			continue;
+		const qfu::Table::Field &fld = fields[i];
+		qfu::TreeTableColumn cd;
+		cd.setName(fld.name());
+		cd.setType((int)fld.type());
+		ret << cd.values();
+	}
+	return ret;
+}
+
+static QVariantMap column_def(const QString &name, QVariant::Type type, const QString &caption = QString())
+{
+	qfu::TreeTableColumn cd;
+	cd.setName(name);
+	cd.setType((int)type);
+	cd.setHeader(caption);
+	return cd.values();
+}
+
+StageResults::StageResults(int stage_id)
+	: m_stageId(stage_id)
+{
+}
+
+void StageResults::load(const QString &class_filter, bool exclude_disq, bool with_laps)
+{
+	qfLogFuncFrame() << "stage:" << m_stageId << "class filter:" << class_filter;
+	QF_TIME_SCOPE("StageResults::load()");
+	m_excludeDisq = exclude_disq;
+	m_withLaps = with_laps;
+	m_classes.clear();
+	m_classIndex.clear();
+	m_courses.clear();
+	m_runLaps.clear();
+	m_runColumns.clear();
+
+	m_keyvals.clear();
+	m_keyvals[QStringLiteral("stageId")] = m_stageId;
+	m_keyvals[QStringLiteral("event")] = getPlugin<EventPlugin>()->eventConfig()->value("event");
+	m_keyvals[QStringLiteral("stageStart")] = getPlugin<EventPlugin>()->stageStartDateTime(m_stageId);
+	{
+		qfs::QueryBuilder qb;
+		qb.select2("classes", "id, name")
+			.select2("courses", "id, length, climb")
+			.from("classes")
+			.joinRestricted("classes.id", "classdefs.classId", "classdefs.stageId=" QF_IARG(m_stageId))
+			.join("classdefs.courseId", "courses.id")
+			.orderBy("classes.name");
+		if(!class_filter.isEmpty()) {
+			qb.where(class_filter);
+		}
+		qf::core::model::SqlTableModel model;
+		model.setQueryBuilder(qb, false);
+		model.reload();
+		const qfu::Table &t = model.table();
+		m_classColumns = columns_from_fields(t.fields());
+		int ix_class_id = t.fields().fieldIndex(QStringLiteral("classes.id"));
+		int ix_class_name = t.fields().fieldIndex(QStringLiteral("classes.name"));
+		int ix_course_id = t.fields().fieldIndex(QStringLiteral("courses.id"));
+		m_classes.resize(t.rowCount());
+		for (int i = 0; i < t.rowCount(); ++i) {
+			const qfu::TableRow row = t.row(i);
+			ClassResults &cr = m_classes[i];
+			cr.classValues = row.values().toList();
+			cr.className = row.value(ix_class_name).toString();
+			cr.courseId = row.value(ix_course_id).toInt();
+			m_classIndex[row.value(ix_class_id).toInt()] = i;
+		}
+	}
+	QList<int> class_ids = class_filter.isEmpty()? QList<int>(): m_classIndex.keys();
+	if(!class_filter.isEmpty() && class_ids.isEmpty()) {
+		/// empty class_ids means whole stage for loadRuns() and loadLaps()
+		m_loaded = true;
+		return;
+	}
+	if(m_withLaps) {
+		loadCourses();
+		loadLaps(class_ids);
+	}
+	loadRuns(class_ids);
+	for(ClassResults &cr : m_classes) {
+		rankClass(cr);
+		if(m_withLaps)
+			addLapsToClass(cr);
+	}
+	m_loaded = true;
+}
+
+void StageResults::reloadClass(int class_id)
+{
+	qfLogFuncFrame() << "class id:" << class_id;
+	int ix = m_classIndex.value(class_id, -1);
+	if(ix < 0)
+		return;
+	ClassResults &cr = m_classes[ix];
+	cr.rows.clear();
+	const QList<int> class_ids{class_id};
+	if(m_withLaps)
+		loadLaps(class_ids);
+	loadRuns(class_ids);
+	rankClass(cr);
+	if(m_withLaps)
+		addLapsToClass(cr);
+}
+
+void StageResults::loadRuns(const QList<int> &class_ids)
+{
+	qfs::QueryBuilder qb;
+	qb.select2("competitors", "classId, registration, lastName, firstName")
+		.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
+		.select2("runs", "*")
+		.select2("clubs", "name")
+		.from("competitors")
+		.join("LEFT JOIN clubs ON substr(competitors.registration, 1, 3) = clubs.abbr")
+		.joinRestricted("competitors.id"
+						, "runs.competitorId"
+						, "runs.stageId=" QF_IARG(m_stageId)
+						  " AND runs.isRunning"
+						  " AND (runs.finishTimeMs>0 OR runs.checkTimeMs IS NOT NULL)"
+						+ (m_excludeDisq? " AND NOT runs.disqualified": "")
+						, "JOIN")
+		.orderBy("competitors.classId, runs.notCompeting, runs.disqualified, runs.timeMs");
+	if(!class_ids.isEmpty())
+		qb.where("competitors.classId IN (" + join_ids(class_ids) + ')');
+	qf::core::model::SqlTableModel model;
+	model.setQueryBuilder(qb, false);
+	model.reload();
+	const qfu::Table &t = model.table();
+	const qfu::Table::FieldList &fields = t.fields();
+	int ix_class_id = fields.fieldIndex(QStringLiteral("competitors.classId"));
+	/// classId is used for grouping only, it is not part of the results table
+	auto ix_without_class_id = [ix_class_id](int ix) { return (ix > ix_class_id)? ix - 1: ix; };
+	if(m_runColumns.isEmpty()) {
+		m_runColumns = columns_from_fields(fields, ix_class_id);
+		m_runIdColumn = ix_without_class_id(fields.fieldIndex(QStringLiteral("runs.id")));
+		m_disqualifiedColumn = ix_without_class_id(fields.fieldIndex(QStringLiteral("runs.disqualified")));
+		m_notCompetingColumn = ix_without_class_id(fields.fieldIndex(QStringLiteral("runs.notCompeting")));
+		m_timeMsColumn = ix_without_class_id(fields.fieldIndex(QStringLiteral("runs.timeMs")));
+		m_posColumn = m_runColumns.count();
+		m_runColumns << column_def(QStringLiteral("pos"), QVariant::String);
+		m_runColumns << column_def(QStringLiteral("npos"), QVariant::Int);
+		m_runColumns << column_def(QStringLiteral("loss"), QVariant::Int);
+	}
+	ClassResults *cr = nullptr;
+	int current_class_id = 0;
+	for (int i = 0; i < t.rowCount(); ++i) {
+		const qfu::TableRow row = t.row(i);
+		int class_id = row.value(ix_class_id).toInt();
+		if(class_id != current_class_id || !cr) {
+			current_class_id = class_id;
+			int ix = m_classIndex.value(class_id, -1);
+			cr = (ix < 0)? nullptr: &m_classes[ix];
+		}
+		if(!cr)
+			continue;
+		const QVector<QVariant> &vals = row.values();
+		QVariantList rv;
+		rv.reserve(m_runColumns.count());
+		for (int j = 0; j < vals.count(); ++j) {
+			if(j != ix_class_id)
+				rv << vals[j];
+		}
+		rv << QVariant() << QVariant() << QVariant();
+		cr->rows << rv;
+	}
+}
+
+void StageResults::rankClass(ClassResults &cr)
+{
+	int first_time_ms = 0;
+	int prev_time_ms = 0;
+	int prev_pos = 0;
+	for (int j = 0; j < cr.rows.count(); ++j) {
+		QVariantList &rv = cr.rows[j];
+		bool has_pos = !rv.value(m_disqualifiedColumn).toBool() && !rv.value(m_notCompetingColumn).toBool();
+		int time_ms = rv.value(m_timeMsColumn).toInt();
+		if(first_time_ms == 0)
+			first_time_ms = time_ms;
+		if(has_pos) {
+			int pos = j+1;
+			if(time_ms == prev_time_ms)
+				pos = prev_pos;
+			else
+				prev_pos = pos;
+			rv[m_posColumn] = QString::number(pos) + '.';
+			rv[m_posColumn + 1] = pos;
+			rv[m_posColumn + 2] = time_ms - first_time_ms;
+		}
+		else {
+			rv[m_posColumn] = QString();
+			rv[m_posColumn + 1] = 0;
+		}
+		prev_time_ms = time_ms;
+	}
+}
+
+void StageResults::loadCourses()
+{
+	const QString stage_courses = "SELECT courseId FROM classdefs WHERE stageId=" QF_IARG(m_stageId);
+	QMap<int, QVariantMap> course_records;
+	{
+		qfs::QueryBuilder qb;
+		qb.select2("courses", "*")
+				.from("courses")
+				.where("courses.id IN (" + stage_courses + ')');
+		qfs::Query q;
+		q.execThrow(qb.toString());
+		while(q.next()) {
+			QVariantMap rec = q.values();
+			course_records[rec.value(QStringLiteral("id")).toInt()] = rec;
+		}
+	}
+	QMap<int, QList<quickevent::core::CodeDef>> course_codes;
+	{
+		qfs::QueryBuilder qb;
+		qb.select2("coursecodes", "courseId, position")
+				.select2("codes", "*")
+				.from("coursecodes")
+				.join("coursecodes.codeId", "codes.id")
+				.where("coursecodes.courseId IN (" + stage_courses + ')')
+				.orderBy("coursecodes.courseId, coursecodes.position");
+		qfs::Query q;
+		q.execThrow(qb.toString());
+		while(q.next()) {
+			QVariantMap rec = q.values();
+			int course_id = rec.take(QStringLiteral("courseid")).toInt();
+			course_codes[course_id] << quickevent::core::CodeDef(rec);
+		}
+	}
+	for(auto it = course_records.constBegin(); it != course_records.constEnd(); ++it) {
+		m_courses[it.key()] = RunsPlugin::courseDefFromCodes(it.value(), course_codes.value(it.key()));
+	}
+}
+
+void StageResults::loadLaps(const QList<int> &class_ids)
+{
+	/// runs without laps are selected too, so laps of every run in classes are replaced, not appended
+	qfs::QueryBuilder qb;
+	qb.select2("runs", "id")
+			.select2("runlaps", "position, code, stpTimeMs, lapTimeMs")
+			.from("runs")
+			.join("runs.id", "runlaps.runId")
+			.where("runs.stageId=" QF_IARG(m_stageId));
+	if(!class_ids.isEmpty()) {
+		qb.join("runs.competitorId", "competitors.id", "JOIN");
+		qb.where("competitors.classId IN (" + join_ids(class_ids) + ')');
+	}
+	qfs::Query q;
+	q.execThrow(qb.toString());
+	QSet<int> cleared_run_ids;
+	while(q.next()) {
+		int run_id = q.value(0).toInt();
+		if(run_id <= 0)
+			continue;
+		if(!cleared_run_ids.contains(run_id)) {
+			cleared_run_ids << run_id;
+			m_runLaps.remove(run_id);
+		}
+		if(q.value(1).isNull())
+			continue;
+		Lap lap;
+		lap.position = q.value(1).toInt();
+		lap.code = q.value(2).toInt();
+		lap.stpTimeMs = q.value(3).toInt();
+		lap.lapTimeMs = q.value(4).toInt();
+		m_runLaps[run_id] << lap;
+	}
+}
+
+void StageResults::addLapsToClass(ClassResults &cr) const
+{
+	const quickevent::core::CourseDef course = m_courses.value(cr.courseId);
+	QVariantList course_codes = course.codes();
+	course_codes << course.finishCode();
+	const int codes_count = course_codes.count();
+	QVector<int> codes(codes_count);
+	for (int i = 0; i < codes_count; ++i)
+		codes[i] = quickevent::core::CodeDef(course_codes[i].toMap()).code();
+
+	struct RunTime
+	{
+		int rowIndex;
+		int time;
+	};
+	/// position in course -> runs sorted by split time
+	QVector<QVector<RunTime>> stp_times(codes_count);
+	QVector<QVector<RunTime>> lap_times(codes_count);
+	const int col0 = m_runColumns.count();
+	for (int i = 0; i < cr.rows.count(); ++i) {
+		QVariantList &rv = cr.rows[i];
+		while(rv.count() > col0)
+			rv.removeLast();
+		for (int j = 0; j < 4 * codes_count; ++j)
+			rv << 0;
+		int run_id = rv.value(m_runIdColumn).toInt();
+		for(const Lap &lap : m_runLaps.value(run_id)) {
+			int pos = lap.position;
+			if(pos <= 0 || pos > codes_count) {
+				qfWarning() << "Invalid code:" << lap.code << "position:" << pos;
+				continue;
+			}
+			if(pos < codes_count) {
+				// check code except of the finish one
+				if(codes[pos - 1] != lap.code) {
+					qfWarning() << "Invalid code:" << lap.code << "for pos:" << pos;
+					continue;
+				}
+			}
+			if(lap.stpTimeMs <= 0)
+				continue;
+			stp_times[pos - 1] << RunTime{i, lap.stpTimeMs};
+			rv[col0 + 4*(pos - 1) + 0] = lap.stpTimeMs;
+			if(lap.lapTimeMs <= 0)
+				continue;
+			lap_times[pos - 1] << RunTime{i, lap.lapTimeMs};
+			rv[col0 + 4*(pos - 1) + 2] = lap.lapTimeMs;
+		}
+	}
+	auto make_pos = [&cr, col0](QVector<QVector<RunTime>> &times, int col_offset) {
+		for (int pos = 0; pos < times.count(); ++pos) {
+			QVector<RunTime> &lst = times[pos];
+			std::stable_sort(lst.begin(), lst.end(), [](const RunTime &a, const RunTime &b) { return a.time < b.time; });
+			for (int i = 0; i < lst.count(); ++i)
+				cr.rows[lst[i].rowIndex][col0 + 4*pos + col_offset] = i + 1;
+		}
+	};
+	make_pos(stp_times, 1);
+	make_pos(lap_times, 3);
+}
+
+QVariantMap StageResults::makeTableVariant(const QVariantList &columns, const QVariantList &rows, const QVariantMap &keyvals) const
+{
+	QVariantMap ret;
+	ret[qfu::TreeTable::KEY_COLUMNS] = columns;
+	ret[qfu::TreeTable::KEY_ROWS] = rows;
+	if(!keyvals.isEmpty())
+		ret[qfu::TreeTable::KEY_KEYVALS] = keyvals;
+	return ret;
+}
+
+qfu::TreeTable StageResults::createClassTable(const ClassResults &cr, int max_competitors_in_class) const
+{
+	QVariantList columns = m_runColumns;
+	QVariantMap keyvals;
+	if(m_withLaps) {
+		const quickevent::core::CourseDef course = m_courses.value(cr.courseId);
+		QVariantList course_codes = course.codes();
+		course_codes << course.finishCode();
+		for (int i = 0; i < course_codes.count(); ++i) {
+			quickevent::core::CodeDef cd(course_codes[i].toMap());
+			columns << column_def(QStringLiteral("stpTime_%1").arg(i), QVariant::Int, QStringLiteral("%1 (%2)").arg(i+1).arg(cd.code()));
+			columns << column_def(QStringLiteral("stpPos_%1").arg(i), QVariant::Int);
+			columns << column_def(QStringLiteral("lapTime_%1").arg(i), QVariant::Int);
+			columns << column_def(QStringLiteral("lapPos_%1").arg(i), QVariant::Int);
+		}
+		keyvals = m_keyvals;
+		keyvals[QStringLiteral("course")] = course;
+		keyvals[QStringLiteral("className")] = cr.className;
+	}
+	int n = cr.rows.count();
+	if(max_competitors_in_class > 0 && n > max_competitors_in_class)
+		n = max_competitors_in_class;
+	QVariantList rows;
+	rows.reserve(n);
+	for (int i = 0; i < n; ++i)
+		rows << QVariant(cr.rows[i]);
+	return qfu::TreeTable(makeTableVariant(columns, rows, keyvals));
+}
+
+qfu::TreeTable StageResults::classResultsTable(int class_id, int max_competitors_in_class) const
+{
+	int ix = m_classIndex.value(class_id, -1);
+	if(ix < 0)
+		return qfu::TreeTable();
+	return createClassTable(m_classes[ix], max_competitors_in_class);
+}
+
+qfu::TreeTable StageResults::toTreeTable(int max_competitors_in_class) const
+{
+	QF_TIME_SCOPE("StageResults::toTreeTable()");
+	QVariantList rows;
+	rows.reserve(m_classes.count());
+	for(const ClassResults &cr : m_classes) {
+		QVariantMap rm;
+		rm[qfu::TreeTable::KEY_ROW] = cr.classValues;
+		rm[qfu::TreeTable::KEY_TABLES] = QVariantList{createClassTable(cr, max_competitors_in_class).toVariant()};
+		rows << rm;
+	}
+	return qfu::TreeTable(makeTableVariant(m_classColumns, rows, m_keyvals));
+}
+
+//=================================================
+// StageResultsCache
+//=================================================
+const StageResults &StageResultsCache::stageResults(int stage_id, bool exclude_disq, bool with_laps)
+{
+	Entry &entry = m_entries[entryKey(stage_id, exclude_disq, with_laps)];
+	if(!entry.valid) {
+		entry.results = StageResults(stage_id);
+		entry.results.load(QString(), exclude_disq, with_laps);
+		entry.valid = true;
+	}
+	else {
+		for(int class_id : entry.dirtyClasses)
+			entry.results.reloadClass(class_id);
+	}
+	entry.dirtyClasses.clear();
+	return entry.results;
+}
+
+void StageResultsCache::invalidateClass(int stage_id, int class_id)
+{
+	for(auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+		Entry &entry = it.value();
+		if(entry.results.stageId() != stage_id)
+			continue;
+		if(entry.results.containsClass(class_id))
+			entry.dirtyClasses << class_id;
+		else
+			entry.valid = false;
+	}
+}
+
+void StageResultsCache::invalidateStage(int stage_id)
+{
+	for(auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+		Entry &entry = it.value();
+		if(entry.results.stageId() == stage_id)
+			entry.valid = false;
+	}
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <quickevent/core/coursedef.h>
+
+#include <qf/core/utils/treetable.h>
+
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QVector>
+
+namespace Runs {
+
+/// Stage results computed from bulk loaded data.
+/// Classes, runs, and optionally courses and runlaps for the whole stage are loaded
+/// in a fixed number of queries, positions, losses and split ranks are computed in memory
+/// and per-class TreeTables are handed out afterwards.
+class StageResults
+{
+public:
+	StageResults(int stage_id = 0);
+
+	int stageId() const {return m_stageId;}
+	bool isLoaded() const {return m_loaded;}
+	bool isWithLaps() const {return m_withLaps;}
+
+	void load(const QString &class_filter = QString(), bool exclude_disq = false, bool with_laps = false);
+	/// reload and re-rank single class, other classes are left untouched
+	void reloadClass(int class_id);
+
+	QList<int> classIds() const {return m_classIndex.keys();}
+	bool containsClass(int class_id) const {return m_classIndex.contains(class_id);}
+
+	qf::core::utils::TreeTable classResultsTable(int class_id, int max_competitors_in_class = 0) const;
+	qf::core::utils::TreeTable toTreeTable(int max_competitors_in_class = 0) const;
+private:
+	struct ClassResults
+	{
+		QVariantList classValues;
+		int courseId = 0;
+		QString className;
+		QVector<QVariantList> rows;
+	};
+
+	void loadRuns(const QList<int> &class_ids);
+	void loadCourses();
+	void loadLaps(const QList<int> &class_ids);
+	void rankClass(ClassResults &cr);
+	void addLapsToClass(ClassResults &cr) const;
+	qf::core::utils::TreeTable createClassTable(const ClassResults &cr, int max_competitors_in_class) const;
+	QVariantMap makeTableVariant(const QVariantList &columns, const QVariantList &rows, const QVariantMap &keyvals) const;
+private:
+	int m_stageId = 0;
+	bool m_loaded = false;
+	bool m_excludeDisq = false;
+	bool m_withLaps = false;
+
+	QVariantList m_classColumns;
+	QVariantList m_runColumns;
+	int m_runIdColumn = -1;
+	int m_disqualifiedColumn = -1;
+	int m_notCompetingColumn = -1;
+	int m_timeMsColumn = -1;
+	int m_posColumn = -1;
+	QVariantMap m_keyvals;
+
+	QVector<ClassResults> m_classes;
+	QMap<int, int> m_classIndex; // class_id -> index in m_classes
+
+	QMap<int, quickevent::core::CourseDef> m_courses;
+
+	struct Lap
+	{
+		int position = 0;
+		int code = 0;
+		int stpTimeMs = 0;
+		int lapTimeMs = 0;
+	};
+	QHash<int, QVector<Lap>> m_runLaps; // run_id -> laps
+};
+
+/// Results cache for stages, it is kept coherent by db events.
+/// Invalidated classes are re-ranked lazily on the next access,
+/// so that a card read costs O(class size) instead of O(event size).
+class StageResultsCache
+{
+public:
+	const StageResults& stageResults(int stage_id, bool exclude_disq = false, bool with_laps = false);
+
+	void invalidateClass(int stage_id, int class_id);
+	void invalidateStage(int stage_id);
+	void clear() {m_entries.clear();}
+private:
+	struct Entry
+	{
+		StageResults results;
+		QSet<int> dirtyClasses;
+		bool valid = false;
+	};
+	static int entryKey(int stage_id, bool exclude_disq, bool with_laps) {return (stage_id << 2) | (exclude_disq? 1: 0) | (with_laps? 2: 0);}
+private:
+	QMap<int, Entry> m_entries;
+};
+
+}
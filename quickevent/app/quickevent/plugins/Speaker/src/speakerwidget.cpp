@@ -81,6 +81,8 @@ SpeakerWidget::SpeakerWidget(QWidget *parent) :
 	m->addColumn("classes.name", tr("Class"));
 	m->addColumn("competitors.registration", tr("Registration"));
 	m->addColumn("competitorName", tr("Competitor"));
+	/// punches table of multi-day event can be long, show first rows immediately
+	m->setFetchChunkSize(500);
 	ui->tblPunches->setTableModel(m);
 	m_punchesModel = m;
 
@@ -1,6 +1,6 @@
 message(including $$PWD)
 
-QT += core gui qml widgets sql xml sql printsupport serialport
+QT += core gui qml widgets sql xml sql printsupport serialport concurrent
 
 CONFIG += lrelease embed_translations
 
@@ -6,4 +6,5 @@ AppCliOptions::AppCliOptions(QObject *parent)
 	addOption("locale").setType(QVariant::String).setNames("--locale").setComment(tr("Application locale")).setDefaultValue("system");
 	addOption("profile").setType(QVariant::String).setNames("--profile").setComment(tr("Application profile, see: https://github.com/fvacek/quickbox/wiki/Application-profiles"));
 	addOption("app.fontScale").setType(QVariant::Double).setNames("--font-scale").setComment(tr("Application font scale")).setDefaultValue(1);
+	addOption("app.siSimulator").setType(QVariant::Bool).setNames("--si-simulator").setComment(tr("Enable SI station simulator in card reader tools, use it with testing event only"));
 }
@@ -19,6 +19,7 @@ public:
 	CLIOPTION_GETTER_SETTER(QString, l, setL, ocale)
 	CLIOPTION_GETTER_SETTER(QString, p, setP, rofile)
 	CLIOPTION_GETTER_SETTER2(double, "app.fontScale", a, setA, ppFontScale)
+	CLIOPTION_GETTER_SETTER2(bool, "app.siSimulator", a, setA, ppSiSimulator)
 };
 
 #endif // APPCLIOPTIONS_H
@@ -1,32 +1,61 @@
 #include "application.h"
 #include "appclioptions.h"
 #include "httpserver.h"
+#include "pagestore.h"
 
 #include <quickevent/core/exporters/stagestartlisthtmlexporter.h>
 #include <quickevent/core/exporters/stageresultshtmlexporter.h>
+#include <quickevent/core/si/checkedcard.h>
 
 #include <qf/core/log.h>
 #include <qf/core/sql/connection.h>
+#include <qf/core/sql/query.h>
 
+#include <QJsonDocument>
 #include <QSqlError>
 #include <QTimer>
 
+/// must be the same as in Event::EventPlugin
+static const auto DBEVENT_NOTIFY_NAME = QStringLiteral("quickbox_db_event");
+static const auto DBEVENT_COMPETITOR_COUNTS_CHANGED = QStringLiteral("competitorCountsChanged");
+static const auto DBEVENT_CARD_READ = QStringLiteral("cardRead");
+static const auto DBEVENT_CARD_PROCESSED_AND_ASSIGNED = QStringLiteral("cardProcessedAndAssigned");
+static const auto DBEVENT_PUNCH_RECEIVED = QStringLiteral("punchReceived");
+
+static constexpr int REGENERATE_DELAY_MSEC = 1000;
+static constexpr int SAFETY_REFRESH_TIME_MSEC = 5 * 60 * 1000;
+
 Application::Application(int &argc, char **argv, AppCliOptions *cli_opts)
 	: Super(argc, argv)
 	, m_cliOptions(cli_opts)
 {
+	/// exporters fill page store, HTTP server does not need to read generated files from disk
+	m_pageStore = new PageStore(cli_opts->htmlDir(), this);
 	int refresh_time_msec = cli_opts->refreshTime();
-	qfInfo() << "HTML dir refresh time:" << refresh_time_msec << "msec";
-	if(refresh_time_msec >= 1000) {
+	if(refresh_time_msec < 1000) {
+		generateHtml();
+		quit();
+		return;
+	}
+	generateHtml();
+	if(subscribeDbEvents()) {
+		qfInfo() << "HTML dir is refreshed on db events";
+		m_regenerateTimer = new QTimer(this);
+		m_regenerateTimer->setSingleShot(true);
+		m_regenerateTimer->setInterval(REGENERATE_DELAY_MSEC);
+		connect(m_regenerateTimer, &QTimer::timeout, this, &Application::regenerateDirtyPages);
+		/// slow full refresh catches changes made without db event (SQL console, imports, older clients)
+		int safety_refresh_time_msec = qMax(refresh_time_msec, SAFETY_REFRESH_TIME_MSEC);
+		qfInfo() << "HTML dir full refresh time:" << safety_refresh_time_msec << "msec";
 		QTimer *rft = new QTimer(this);
 		connect(rft, &QTimer::timeout, this, &Application::generateHtml);
-		rft->start(refresh_time_msec);
-		generateHtml();
+		rft->start(safety_refresh_time_msec);
 	}
 	else {
-		generateHtml();
-		quit();
-		return;
+		qfInfo() << "HTML dir refresh time:" << refresh_time_msec << "msec";
+		QTimer *rft = new QTimer(this);
+		connect(rft, &QTimer::timeout, this, &Application::generateHtml);
+		rft->start(refresh_time_msec);
 	}
 	if(cli_opts->httpPort() > 0) {
 		HttpServer *srv = new HttpServer(this);
@@ -86,25 +115,125 @@ qf::core::sql::Connection Application::sqlConnetion()
 	return db;
 }
 
+static void initExporter(quickevent::core::exporters::HtmlFileExporter &exp, Application *app)
+{
+	exp.setSqlConnection(app->sqlConnetion());
+	exp.setOutDir(app->cliOptions()->htmlDir());
+	exp.setClassesLike(app->cliOptions()->classesLike());
+	exp.setClassesNotLike(app->cliOptions()->classesNotLike());
+	QObject::connect(&exp, &quickevent::core::exporters::HtmlFileExporter::htmlFileGenerated, app->pageStore(), &PageStore::setPage);
+}
+
 void Application::generateHtml()
 {
 	{
 		quickevent::core::exporters::StageStartListHtmlExporter exp;
-		exp.setSqlConnection(sqlConnetion());
-		exp.setOutDir(cliOptions()->htmlDir());
-		exp.setClassesLike(cliOptions()->classesLike());
-		exp.setClassesNotLike(cliOptions()->classesNotLike());
+		initExporter(exp, this);
 		exp.generateHtml();
 	}
 	{
 		quickevent::core::exporters::StageResultsHtmlExporter exp;
-		exp.setSqlConnection(sqlConnetion());
-		exp.setOutDir(cliOptions()->htmlDir());
-		exp.setClassesLike(cliOptions()->classesLike());
-		exp.setClassesNotLike(cliOptions()->classesNotLike());
+		initExporter(exp, this);
 		exp.generateHtml();
 	}
 }
 
+void Application::generateClassesHtml(const QList<int> &start_list_class_ids, const QList<int> &results_class_ids)
+{
+	if(!start_list_class_ids.isEmpty()) {
+		quickevent::core::exporters::StageStartListHtmlExporter exp;
+		initExporter(exp, this);
+		exp.generateClassesHtml(start_list_class_ids);
+	}
+	if(!results_class_ids.isEmpty()) {
+		quickevent::core::exporters::StageResultsHtmlExporter exp;
+		initExporter(exp, this);
+		exp.generateClassesHtml(results_class_ids);
+	}
+}
+
+bool Application::subscribeDbEvents()
+{
+	qf::core::sql::Connection db = sqlConnetion();
+	if(!db.isOpen() || !db.driverName().endsWith(QLatin1String("PSQL")))
+		return false;
+	bool ok = connect(db.driver(), SIGNAL(notification(QString, QSqlDriver::NotificationSource,QVariant)), this, SLOT(onDbEvent(QString,QSqlDriver::NotificationSource, QVariant)));
+	if(ok)
+		ok = db.driver()->subscribeToNotification(DBEVENT_NOTIFY_NAME);
+	if(!ok)
+		qfError() << "Failed to subscribe db notification:" << DBEVENT_NOTIFY_NAME << ", falling back to periodic refresh";
+	else
+		qfInfo() << "Successfully subscribe db notification:" << DBEVENT_NOTIFY_NAME;
+	return ok;
+}
+
+void Application::onDbEvent(const QString &name, QSqlDriver::NotificationSource source, const QVariant &payload)
+{
+	Q_UNUSED(source)
+	qfLogFuncFrame() << "name:" << name << "payload:" << payload;
+	if(name != DBEVENT_NOTIFY_NAME)
+		return;
+	QJsonParseError error;
+	QJsonDocument jsd = QJsonDocument::fromJson(payload.toString().toUtf8(), &error);
+	if(error.error != QJsonParseError::NoError) {
+		qfWarning() << "DbNotify JSON parse error:" << error.errorString() << "payload:" << payload.toString();
+		return;
+	}
+	QVariantMap m = jsd.toVariant().toMap();
+	if(m.value(QStringLiteral("eventName")).toString() != cliOptions()->eventName())
+		return;
+	processDbEvent(m.value(QStringLiteral("domain")).toString(), m.value(QStringLiteral("data")));
+}
 
+void Application::processDbEvent(const QString &domain, const QVariant &data)
+{
+	if(domain == DBEVENT_CARD_READ || domain == DBEVENT_PUNCH_RECEIVED)
+		return;
+	if(domain == DBEVENT_CARD_PROCESSED_AND_ASSIGNED) {
+		/// start list does not change, results of runner's class only
+		quickevent::core::si::CheckedCard checked_card(data.toMap());
+		qf::core::sql::Query q(sqlConnetion());
+		q.exec("SELECT competitors.classId FROM runs"
+			   " JOIN competitors ON runs.competitorId=competitors.id"
+			   " WHERE runs.id=" + QString::number(checked_card.runId()));
+		if(q.next())
+			m_dirtyResultsClasses << q.value(0).toInt();
+		else
+			m_regenerateAll = true;
+	}
+	else if(domain == DBEVENT_COMPETITOR_COUNTS_CHANGED) {
+		/// data is list of affected classes, it is null when sender does not know them
+		const QVariantList class_ids = data.toList();
+		if(class_ids.isEmpty())
+			m_regenerateAll = true;
+		for(const QVariant &v : class_ids) {
+			int class_id = v.toInt();
+			if(class_id > 0) {
+				m_dirtyStartListClasses << class_id;
+				m_dirtyResultsClasses << class_id;
+			}
+		}
+	}
+	else {
+		/// runs changed, stage start changed, registrations imported, ..., it is not known which classes are affected
+		m_regenerateAll = true;
+	}
+	/// timer is not restarted, pages are not postponed forever during card read-out burst
+	if(!m_regenerateTimer->isActive())
+		m_regenerateTimer->start();
+}
 
+void Application::regenerateDirtyPages()
+{
+	if(m_regenerateAll) {
+		qfInfo() << "Regenerating all classes";
+		generateHtml();
+	}
+	else {
+		qfInfo() << "Regenerating start list classes:" << m_dirtyStartListClasses.count() << "results classes:" << m_dirtyResultsClasses.count();
+		generateClassesHtml(m_dirtyStartListClasses.values(), m_dirtyResultsClasses.values());
+	}
+	m_regenerateAll = false;
+	m_dirtyStartListClasses.clear();
+	m_dirtyResultsClasses.clear();
+}
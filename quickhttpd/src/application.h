@@ -4,6 +4,8 @@
 #include <qf/core/utils.h>
 
 #include <QCoreApplication>
+#include <QSet>
+#include <QSqlDriver>
 
 class QVariant;
 class QSqlDatabase;
@@ -11,6 +13,8 @@ class QSqlQuery;
 class QSqlRecord;
 class AppCliOptions;
 class QDir;
+class QTimer;
+class PageStore;
 
 namespace qf {
 	namespace core {
@@ -33,11 +37,25 @@ public:
 
 	static Application *instance();
 	AppCliOptions* cliOptions() {return m_cliOptions;}
+	PageStore* pageStore() {return m_pageStore;}
 	qf::core::sql::Connection sqlConnetion();
 private:
 	void generateHtml();
+	void generateClassesHtml(const QList<int> &start_list_class_ids, const QList<int> &results_class_ids);
+
+	/// PSQL only, pages are regenerated when quickevent sends db event
+	bool subscribeDbEvents();
+	Q_SLOT void onDbEvent(const QString &name, QSqlDriver::NotificationSource source, const QVariant &payload);
+	void processDbEvent(const QString &domain, const QVariant &data);
+	void regenerateDirtyPages();
 private:
 	AppCliOptions *m_cliOptions;
+	PageStore *m_pageStore;
+	/// db events are coalesced, card read-outs come in bursts
+	QTimer *m_regenerateTimer = nullptr;
+	bool m_regenerateAll = false;
+	QSet<int> m_dirtyStartListClasses;
+	QSet<int> m_dirtyResultsClasses;
 };
 
 #endif // APPLICATION_H
@@ -1,84 +1,227 @@
 #include "httpconnection.h"
+#include "httpserver.h"
 
 #include "application.h"
 #include "appclioptions.h"
+#include "pagestore.h"
 
 #include <qf/core/log.h>
 #include <qf/core/utils/htmlutils.h>
 
 #include <QDir>
+#include <QTimer>
+#include <QUrl>
 
-HttpConnection::HttpConnection(QTcpSocket *sock, QObject *parent)
-	: QObject(parent)
-	, m_socket(sock)
+static QByteArray statusText(int status_code)
 {
-	connect(sock, &QAbstractSocket::disconnected, sock, &QObject::deleteLater);
-	connect(sock, &QAbstractSocket::readyRead, this, &HttpConnection::onReadyRead);
+	switch (status_code) {
+	case 200: return QByteArrayLiteral("OK");
+	case 304: return QByteArrayLiteral("Not Modified");
+	case 400: return QByteArrayLiteral("Bad Request");
+	case 404: return QByteArrayLiteral("Not Found");
+	case 405: return QByteArrayLiteral("Method Not Allowed");
+	default: return QByteArray();
+	}
+}
+
+/// If-None-Match can contain list of etags or *
+static bool etagMatches(const QByteArray &if_none_match, const PageStore::Page &page)
+{
+	for(const QByteArray &tag : if_none_match.split(',')) {
+		QByteArray t = tag.trimmed();
+		if(t.startsWith("W/"))
+			t = t.mid(2);
+		if(t == "*" || t == page.etag || t == page.gzipEtag())
+			return true;
+	}
+	return false;
 }
 
-HttpConnection::~HttpConnection()
+HttpConnection::HttpConnection(QTcpSocket *sock, HttpServer *server)
+	: QObject(server)
+	, m_socket(sock)
+	, m_server(server)
 {
-	delete m_socket;
+	sock->setParent(this);
+	m_idleTimer = new QTimer(this);
+	m_idleTimer->setSingleShot(true);
+	m_idleTimer->setInterval(KEEP_ALIVE_TIMEOUT_SEC * 1000);
+	connect(m_idleTimer, &QTimer::timeout, this, &HttpConnection::closeConnection);
+	connect(sock, &QAbstractSocket::disconnected, this, &QObject::deleteLater);
+	connect(sock, &QAbstractSocket::readyRead, this, &HttpConnection::onReadyRead);
+	m_idleTimer->start();
 }
 
 void HttpConnection::onReadyRead()
 {
-	while(m_socket->canReadLine()) {
+	m_idleTimer->start();
+	while(m_socket->state() == QAbstractSocket::ConnectedState && m_socket->canReadLine()) {
 		QByteArray line = m_socket->readLine();
-		qfInfo() << line;
-		if(line.startsWith("GET ")) {
-			m_getPath = line.mid(4);
-			int ix = m_getPath.indexOf("HTTP");
-			m_getPath = m_getPath.mid(0, ix - 1);
+		m_headerSize += line.size();
+		if(m_headerSize > MAX_REQUEST_HEADER_SIZE) {
+			qfWarning() << "HTTP request header is too long, closing connection.";
+			m_keepAlive = false;
+			sendResponse(400, responseHead(400));
+			return;
 		}
-		else if(line == "\r\n") {
+		bool is_empty_line = (line == "\r\n" || line == "\n");
+		if(m_method.isEmpty()) {
+			/// empty lines before request line should be ignored
+			if(is_empty_line) {
+				m_headerSize = 0;
+				continue;
+			}
+			QList<QByteArray> request_line = line.trimmed().split(' ');
+			if(request_line.count() != 3) {
+				qfWarning() << "Invalid HTTP request line:" << line;
+				m_keepAlive = false;
+				sendResponse(400, responseHead(400));
+				return;
+			}
+			m_requestTimer.start();
+			m_method = request_line.value(0);
+			m_requestUri = request_line.value(1);
+			m_httpVersion = request_line.value(2);
+		}
+		else if(is_empty_line) {
 			processRequest();
 		}
+		else {
+			int ix = line.indexOf(':');
+			if(ix > 0)
+				m_headers[line.mid(0, ix).trimmed().toLower()] = line.mid(ix + 1).trimmed();
+		}
+	}
+	if(m_socket->bytesAvailable() > MAX_REQUEST_HEADER_SIZE) {
+		qfWarning() << "HTTP request line is too long, closing connection.";
+		closeConnection();
 	}
 }
 
 void HttpConnection::processRequest()
 {
-	if(!m_getPath.isEmpty()) {
-		if(!m_getPath.startsWith('/'))
-			m_getPath = '/' + m_getPath;
-		Application *app = Application::instance();
-		AppCliOptions *cliopts = app->cliOptions();
-		QString html_dir = cliopts->htmlDir();
-		QFileInfo fi(html_dir + m_getPath);
-		qfInfo() << "GET" << m_getPath << "abs:" << fi.absoluteFilePath();
-		if(fi.isDir()) {
-			if(!m_getPath.endsWith('/'))
-				m_getPath += '/';
-			QVariantList html_body = QVariantList() << QStringLiteral("body");
-			QDir dir(fi.absoluteFilePath());
-			QVariantList class_links;
-			qfInfo() << "dir of:" << dir.absolutePath();
-			for(const QString &fn : dir.entryList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot)) {
-				class_links.insert(class_links.length(), QVariantList{"a", QVariantMap{{"href", m_getPath + fn}}, fn});
-			}
-			html_body.insert(html_body.length(), QVariantList{"p"} << class_links);
+	QByteArray connection = m_headers.value(QByteArrayLiteral("connection")).toLower();
+	m_keepAlive = (m_httpVersion == "HTTP/1.1");
+	if(connection.contains("close"))
+		m_keepAlive = false;
+	else if(connection.contains("keep-alive"))
+		m_keepAlive = true;
 
-			qf::core::utils::HtmlUtils::FromHtmlListOptions opts;
-			opts.setDocumentTitle(tr("Dir list %1").arg(m_getPath));
-			QString html = qf::core::utils::HtmlUtils::fromHtmlList(html_body, opts);
-			responseOK(html.toUtf8());
+	if(m_method == "GET" || m_method == "HEAD") {
+		int ix = m_requestUri.indexOf('?');
+		QString path = QUrl::fromPercentEncoding(ix < 0? m_requestUri: m_requestUri.mid(0, ix));
+		processGet(path);
+	}
+	else {
+		/// request body is not supported
+		m_keepAlive = false;
+		QByteArray head = responseHead(405);
+		head += "Allow: GET, HEAD\r\n";
+		sendResponse(405, head);
+	}
+	resetRequest();
+}
+
+void HttpConnection::processGet(const QString &path)
+{
+	QString p = QDir::cleanPath(path);
+	if(!p.startsWith('/'))
+		p = '/' + p;
+	if(p.startsWith(QLatin1String("/.."))) {
+		sendResponse(400, responseHead(400));
+		return;
+	}
+	qfDebug() << m_method << p;
+	Application *app = Application::instance();
+	PageStore::Page page = app->pageStore()->page(p);
+	if(page.isValid()) {
+		bool use_gzip = !page.gzipContent.isEmpty()
+				&& m_headers.value(QByteArrayLiteral("accept-encoding")).contains("gzip");
+		QByteArray etag = use_gzip? page.gzipEtag(): page.etag;
+		/// pages change during race, browsers have to revalidate them, but they do not need to download them again
+		QByteArray head;
+		head += "Content-Type: " + page.contentType + "\r\n";
+		head += "ETag: " + etag + "\r\n";
+		head += "Cache-Control: no-cache\r\n";
+		if(!page.gzipContent.isEmpty())
+			head += "Vary: Accept-Encoding\r\n";
+		QByteArray if_none_match = m_headers.value(QByteArrayLiteral("if-none-match"));
+		if(!if_none_match.isEmpty() && etagMatches(if_none_match, page)) {
+			sendResponse(304, responseHead(304) + head);
+			return;
 		}
-		else {
-			QFile f(fi.absoluteFilePath());
-			if(f.open(QFile::ReadOnly)) {
-				QByteArray ba = f.readAll();
-				responseOK(ba);
-			}
+		if(use_gzip)
+			head += "Content-Encoding: gzip\r\n";
+		sendResponse(200, responseHead(200) + head, use_gzip? page.gzipContent: page.content);
+		return;
+	}
+	AppCliOptions *cliopts = app->cliOptions();
+	QFileInfo fi(cliopts->htmlDir() + p);
+	if(fi.isDir()) {
+		QString dir_path = p;
+		if(!dir_path.endsWith('/'))
+			dir_path += '/';
+		QVariantList html_body = QVariantList() << QStringLiteral("body");
+		QDir dir(fi.absoluteFilePath());
+		QVariantList class_links;
+		qfDebug() << "dir of:" << dir.absolutePath();
+		for(const QString &fn : dir.entryList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot)) {
+			class_links.insert(class_links.length(), QVariantList{"a", QVariantMap{{"href", dir_path + fn}}, fn});
 		}
+		html_body.insert(html_body.length(), QVariantList{"p"} << class_links);
+
+		qf::core::utils::HtmlUtils::FromHtmlListOptions opts;
+		opts.setDocumentTitle(tr("Dir list %1").arg(dir_path));
+		QString html = qf::core::utils::HtmlUtils::fromHtmlList(html_body, opts);
+		QByteArray head = responseHead(200);
+		head += "Content-Type: " + PageStore::contentType(QStringLiteral("index.html")) + "\r\n";
+		head += "Cache-Control: no-cache\r\n";
+		sendResponse(200, head, html.toUtf8());
+		return;
+	}
+	sendResponse(404, responseHead(404));
+}
+
+QByteArray HttpConnection::responseHead(int status_code) const
+{
+	QByteArray ret = "HTTP/1.1 " + QByteArray::number(status_code) + ' ' + statusText(status_code) + "\r\n";
+	if(m_keepAlive) {
+		ret += "Connection: keep-alive\r\n";
+		ret += "Keep-Alive: timeout=" + QByteArray::number(KEEP_ALIVE_TIMEOUT_SEC) + "\r\n";
+	}
+	else {
+		ret += "Connection: close\r\n";
 	}
-	m_socket->close();
+	return ret;
+}
+
+void HttpConnection::sendResponse(int status_code, QByteArray head, const QByteArray &body)
+{
+	/// 304 response must not contain body, Content-Length would describe body of 200 response
+	if(status_code != 304)
+		head += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+	head += "\r\n";
+	if(m_method != "HEAD" && status_code != 304)
+		head += body;
+	/// head and body are sent in one write to avoid extra TCP packet
+	m_socket->write(head);
+	m_server->addServedRequest(status_code, m_requestTimer.isValid()? m_requestTimer.nsecsElapsed(): 0);
+	if(!m_keepAlive)
+		closeConnection();
+}
+
+void HttpConnection::resetRequest()
+{
+	m_method.clear();
+	m_requestUri.clear();
+	m_httpVersion.clear();
+	m_headers.clear();
+	m_headerSize = 0;
+	m_requestTimer.invalidate();
 }
 
-void HttpConnection::responseOK(const QByteArray &message)
+void HttpConnection::closeConnection()
 {
-	m_socket->write(QByteArray("HTTP/1.1 200 OK\r\n"));
-	m_socket->write(QByteArray("Content-Type: text/html\r\n"));
-	m_socket->write(QByteArray("\r\n"));
-	m_socket->write(message);
+	/// pending data are written before socket is closed
+	m_socket->disconnectFromHost();
 }
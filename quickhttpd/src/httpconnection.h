@@ -1,22 +1,45 @@
 #ifndef HTTPCONNECTION_H
 #define HTTPCONNECTION_H
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QTcpSocket>
 
+class HttpServer;
+class QTimer;
+
+/// HTTP/1.1 connection serving GET and HEAD requests from PageStore.
+/// Connection is kept alive unless client asks to close it or it is idle for KEEP_ALIVE_TIMEOUT_SEC,
+/// pipelined requests are served in order.
 class HttpConnection : public QObject
 {
 	Q_OBJECT
 public:
-	HttpConnection(QTcpSocket *sock, QObject *parent);
-	~HttpConnection() override;
+	HttpConnection(QTcpSocket *sock, HttpServer *server);
 
 	void onReadyRead();
 private:
 	void processRequest();
-	void responseOK(const QByteArray &message);
+	void processGet(const QString &path);
+	void sendResponse(int status_code, QByteArray head, const QByteArray &body = QByteArray());
+	QByteArray responseHead(int status_code) const;
+	void resetRequest();
+	void closeConnection();
 private:
+	static constexpr int KEEP_ALIVE_TIMEOUT_SEC = 15;
+	static constexpr int MAX_REQUEST_HEADER_SIZE = 16 * 1024;
+
 	QTcpSocket *m_socket;
-	QString m_getPath;
+	HttpServer *m_server;
+	QTimer *m_idleTimer;
+
+	QByteArray m_method;
+	QByteArray m_requestUri;
+	QByteArray m_httpVersion;
+	QHash<QByteArray, QByteArray> m_headers;
+	int m_headerSize = 0;
+	bool m_keepAlive = false;
+	QElapsedTimer m_requestTimer;
 };
 
 #endif // HTTPCONNECTION_H
@@ -3,16 +3,59 @@
 
 #include <qf/core/log.h>
 
+#include <QTimer>
+
+static constexpr int STATISTICS_INTERVAL_MSEC = 10 * 1000;
+
 HttpServer::HttpServer(QObject *parent)
 	: QTcpServer(parent)
 {
 	connect(this, &HttpServer::newConnection, this, &HttpServer::onNewConnection);
+	m_statisticsTimer = new QTimer(this);
+	connect(m_statisticsTimer, &QTimer::timeout, this, &HttpServer::logStatistics);
+	m_statisticsTimer->start(STATISTICS_INTERVAL_MSEC);
+	m_statisticsElapsed.start();
 }
 
 void HttpServer::onNewConnection()
 {
 	while(QTcpSocket *sock = nextPendingConnection()) {
-		qfInfo() << "accepting connection, socket:" << sock;
-		new HttpConnection(sock, this);
+		qfDebug() << "accepting connection, socket:" << sock;
+		HttpConnection *conn = new HttpConnection(sock, this);
+		m_connectionCount++;
+		connect(conn, &QObject::destroyed, this, [this]() {
+			m_connectionCount--;
+		});
+	}
+}
+
+void HttpServer::addServedRequest(int status_code, qint64 latency_nsec)
+{
+	m_requestCount++;
+	if(status_code == 304)
+		m_notModifiedCount++;
+	else if(status_code >= 400)
+		m_errorCount++;
+	m_latencySumNsec += latency_nsec;
+	if(latency_nsec > m_latencyMaxNsec)
+		m_latencyMaxNsec = latency_nsec;
+}
+
+void HttpServer::logStatistics()
+{
+	qint64 elapsed_msec = m_statisticsElapsed.restart();
+	if(m_requestCount > 0 && elapsed_msec > 0) {
+		qfInfo() << "HTTP requests:" << m_requestCount
+				 << "req/s:" << (m_requestCount * 1000 / elapsed_msec)
+				 << "not modified:" << m_notModifiedCount
+				 << "errors:" << m_errorCount
+				 << "avg latency:" << (m_latencySumNsec / m_requestCount / 1000) << "usec"
+				 << "max latency:" << (m_latencyMaxNsec / 1000) << "usec"
+				 << "connections:" << m_connectionCount;
 	}
+	m_requestCount = 0;
+	m_notModifiedCount = 0;
+	m_errorCount = 0;
+	m_latencySumNsec = 0;
+	m_latencyMaxNsec = 0;
 }
@@ -1,15 +1,31 @@
 #ifndef HTTPSERVER_H
 #define HTTPSERVER_H
 
+#include <QElapsedTimer>
 #include <QTcpServer>
 
+class QTimer;
+
 class HttpServer : public QTcpServer
 {
 	Q_OBJECT
 public:
 	HttpServer(QObject *parent);
+
+	/// called by connection for every response sent, statistics are logged periodically
+	void addServedRequest(int status_code, qint64 latency_nsec);
 private:
 	void onNewConnection();
+	void logStatistics();
+private:
+	QTimer *m_statisticsTimer;
+	QElapsedTimer m_statisticsElapsed;
+	int m_connectionCount = 0;
+	int m_requestCount = 0;
+	int m_notModifiedCount = 0;
+	int m_errorCount = 0;
+	qint64 m_latencySumNsec = 0;
+	qint64 m_latencyMaxNsec = 0;
 };
 
 #endif // HTTPSERVER_H
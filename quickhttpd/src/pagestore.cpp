@@ -0,0 +1,174 @@
+#include "pagestore.h"
+
+#include <qf/core/log.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+
+static const QVector<quint32> &crc32Table()
+{
+	static const QVector<quint32> table = []() {
+		QVector<quint32> t(256);
+		for(quint32 i = 0; i < 256; i++) {
+			quint32 c = i;
+			for(int k = 0; k < 8; k++)
+				c = (c & 1)? 0xEDB88320u ^ (c >> 1): c >> 1;
+			t[static_cast<int>(i)] = c;
+		}
+		return t;
+	}();
+	return table;
+}
+
+static quint32 crc32(const QByteArray &data)
+{
+	const QVector<quint32> &table = crc32Table();
+	quint32 crc = 0xFFFFFFFFu;
+	for(char c : data)
+		crc = table[static_cast<int>((crc ^ static_cast<quint8>(c)) & 0xFF)] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFFu;
+}
+
+static void appendUInt32LE(QByteArray &ba, quint32 n)
+{
+	for(int i = 0; i < 4; i++)
+		ba.append(static_cast<char>((n >> (8 * i)) & 0xFF));
+}
+
+static QString normalizedPath(const QString &path)
+{
+	QString ret = QDir::cleanPath(path);
+	if(!ret.startsWith('/'))
+		ret.prepend('/');
+	return ret;
+}
+
+QByteArray PageStore::Page::gzipEtag() const
+{
+	if(etag.isEmpty())
+		return QByteArray();
+	return etag.mid(0, etag.length() - 1) + "-gz\"";
+}
+
+PageStore::PageStore(const QString &root_dir, QObject *parent)
+	: Super(parent)
+	, m_rootDir(root_dir)
+{
+}
+
+void PageStore::setPage(const QString &path, const QByteArray &content)
+{
+	QString p = normalizedPath(path);
+	qfDebug() << "storing page:" << p << "size:" << content.size();
+	m_pages[p] = createPage(p, content);
+}
+
+PageStore::Page PageStore::page(const QString &path)
+{
+	QString p = normalizedPath(path);
+	if(p.startsWith(QLatin1String("/..")))
+		return Page();
+	auto it = m_pages.constFind(p);
+	if(it != m_pages.constEnd()) {
+		const Page &pg = it.value();
+		/// generated pages are always up to date
+		if(pg.fileName.isEmpty() || QFileInfo(pg.fileName).lastModified() == pg.fileLastModified)
+			return pg;
+	}
+	return loadFile(p);
+}
+
+PageStore::Page PageStore::loadFile(const QString &path)
+{
+	QFileInfo fi(m_rootDir + path);
+	if(!fi.isFile()) {
+		m_pages.remove(path);
+		return Page();
+	}
+	QFile f(fi.absoluteFilePath());
+	if(!f.open(QFile::ReadOnly)) {
+		qfWarning() << "Cannot open file:" << f.fileName() << "for reading.";
+		m_pages.remove(path);
+		return Page();
+	}
+	Page ret = createPage(path, f.readAll());
+	ret.fileName = fi.absoluteFilePath();
+	ret.fileLastModified = fi.lastModified();
+	if(fi.size() <= MAX_FILE_SIZE)
+		m_pages[path] = ret;
+	return ret;
+}
+
+PageStore::Page PageStore::createPage(const QString &path, const QByteArray &content)
+{
+	Page ret;
+	ret.content = content;
+	ret.contentType = contentType(path);
+	ret.etag = '"' + QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex().left(20) + '"';
+	/// small pages and binary formats do not benefit from compression
+	static constexpr int MIN_GZIP_SIZE = 256;
+	if(content.size() >= MIN_GZIP_SIZE
+	   && (ret.contentType.startsWith("text/")
+		   || ret.contentType.contains("javascript")
+		   || ret.contentType.contains("json")
+		   || ret.contentType.contains("xml"))) {
+		QByteArray gz = gzip(content);
+		if(!gz.isEmpty() && gz.size() < content.size())
+			ret.gzipContent = gz;
+	}
+	return ret;
+}
+
+QByteArray PageStore::contentType(const QString &path)
+{
+	QString suffix = QFileInfo(path).suffix().toLower();
+	if(suffix == QLatin1String("html") || suffix == QLatin1String("htm"))
+		return QByteArrayLiteral("text/html; charset=utf-8");
+	if(suffix == QLatin1String("css"))
+		return QByteArrayLiteral("text/css; charset=utf-8");
+	if(suffix == QLatin1String("js"))
+		return QByteArrayLiteral("application/javascript; charset=utf-8");
+	if(suffix == QLatin1String("json"))
+		return QByteArrayLiteral("application/json");
+	if(suffix == QLatin1String("xml"))
+		return QByteArrayLiteral("application/xml");
+	if(suffix == QLatin1String("txt"))
+		return QByteArrayLiteral("text/plain; charset=utf-8");
+	if(suffix == QLatin1String("csv"))
+		return QByteArrayLiteral("text/csv; charset=utf-8");
+	if(suffix == QLatin1String("svg"))
+		return QByteArrayLiteral("image/svg+xml");
+	if(suffix == QLatin1String("png"))
+		return QByteArrayLiteral("image/png");
+	if(suffix == QLatin1String("jpg") || suffix == QLatin1String("jpeg"))
+		return QByteArrayLiteral("image/jpeg");
+	if(suffix == QLatin1String("gif"))
+		return QByteArrayLiteral("image/gif");
+	if(suffix == QLatin1String("ico"))
+		return QByteArrayLiteral("image/x-icon");
+	if(suffix == QLatin1String("pdf"))
+		return QByteArrayLiteral("application/pdf");
+	return QByteArrayLiteral("application/octet-stream");
+}
+
+QByteArray PageStore::gzip(const QByteArray &data)
+{
+	/// qCompress() output is uncompressed size (4 bytes), zlib header (2 bytes), deflate stream and adler32 (4 bytes)
+	/// gzip member is gzip header, the same deflate stream, crc32 and uncompressed size
+	static constexpr int QCOMPRESS_HEADER_SIZE = 4 + 2;
+	static constexpr int QCOMPRESS_TRAILER_SIZE = 4;
+	QByteArray zlib_data = qCompress(data, 9);
+	if(zlib_data.size() < QCOMPRESS_HEADER_SIZE + QCOMPRESS_TRAILER_SIZE)
+		return QByteArray();
+	static const char gzip_header[] = {'\x1f', '\x8b', '\x08', 0, 0, 0, 0, 0, '\x02', '\x03'};
+	QByteArray ret;
+	ret.reserve(static_cast<int>(sizeof(gzip_header)) + zlib_data.size());
+	ret.append(gzip_header, sizeof(gzip_header));
+	ret.append(zlib_data.constData() + QCOMPRESS_HEADER_SIZE, zlib_data.size() - QCOMPRESS_HEADER_SIZE - QCOMPRESS_TRAILER_SIZE);
+	appendUInt32LE(ret, crc32(data));
+	appendUInt32LE(ret, static_cast<quint32>(data.size()));
+	return ret;
+}
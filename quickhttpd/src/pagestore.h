@@ -0,0 +1,50 @@
+#ifndef PAGESTORE_H
+#define PAGESTORE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+
+/// Pages served by HttpServer kept in memory.
+/// Exporters put generated pages here directly, other files from HTML dir are loaded on first request
+/// and reloaded when they change on disk.
+/// Every page has strong ETag and gzip compressed body prepared, so request is served without disk access and compression.
+class PageStore : public QObject
+{
+	Q_OBJECT
+private:
+	using Super = QObject;
+public:
+	struct Page
+	{
+		QByteArray content;
+		QByteArray gzipContent; //< empty if content is not worth to compress
+		QByteArray etag; //< quoted, gzip encoded content has suffix -gz
+		QByteArray contentType;
+		QString fileName; //< set for pages loaded from disk
+		QDateTime fileLastModified;
+
+		bool isValid() const {return !etag.isEmpty();}
+		QByteArray gzipEtag() const;
+	};
+public:
+	explicit PageStore(const QString &root_dir, QObject *parent = nullptr);
+
+	/// path is relative to root dir, leading slash is optional
+	void setPage(const QString &path, const QByteArray &content);
+	/// invalid page is returned if path does not exist in store or root dir
+	Page page(const QString &path);
+	int pageCount() const {return m_pages.count();}
+
+	static QByteArray contentType(const QString &path);
+	static QByteArray gzip(const QByteArray &data);
+private:
+	static Page createPage(const QString &path, const QByteArray &content);
+	Page loadFile(const QString &path);
+private:
+	static constexpr int MAX_FILE_SIZE = 16 * 1024 * 1024;
+	QString m_rootDir;
+	QHash<QString, Page> m_pages;
+};
+
+#endif // PAGESTORE_H
@@ -2,13 +2,15 @@ HEADERS  +=   \
 	$$PWD/application.h      \
     $$PWD/appclioptions.h \
     $$PWD/httpserver.h \
-    $$PWD/httpconnection.h
+    $$PWD/httpconnection.h \
+    $$PWD/pagestore.h
 
 SOURCES +=   \
 	$$PWD/main.cpp     \
 	$$PWD/application.cpp      \
     $$PWD/appclioptions.cpp \
     $$PWD/httpserver.cpp \
-    $$PWD/httpconnection.cpp
+    $$PWD/httpconnection.cpp \
+    $$PWD/pagestore.cpp
 
 
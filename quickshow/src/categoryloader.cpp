@@ -0,0 +1,265 @@
+#include "categoryloader.h"
+#include "application.h"
+#include "appclioptions.h"
+
+#include <qf/core/log.h>
+#include <qf/core/sql/connection.h>
+#include <qf/core/sql/query.h>
+#include <qf/core/sql/querybuilder.h>
+
+#include <QMutexLocker>
+
+/// key of row content for Table row pixmap cache
+static QString rowContentKey(const QVariantMap &record)
+{
+	QString ret;
+	for(auto it = record.constBegin(); it != record.constEnd(); ++it) {
+		ret += it.value().toString();
+		ret += QChar(0x1f);
+	}
+	return ret;
+}
+
+CategoryLoader::CategoryLoader(QObject *parent)
+	: Super(parent)
+{
+	/// everything what needs GUI thread objects is resolved here
+	Application *app = Application::instance();
+	AppCliOptions *cli = app->cliOptions();
+	m_connectionName = QStringLiteral("quickshow_categoryLoader");
+	/// QSqlDatabase::database() and cloneDatabase() cannot be called from worker thread in Qt < 5.13,
+	/// connection parameters are read here and worker connection is created in run()
+	qf::core::sql::Connection conn = qf::core::sql::Connection::forName();
+	m_driverName = conn.driverName();
+	m_hostName = conn.hostName();
+	m_port = conn.port();
+	m_databaseName = conn.databaseName();
+	m_userName = conn.userName();
+	m_password = conn.password();
+	m_connectOptions = conn.connectOptions();
+	if(!cli->sqlDriver().endsWith(QLatin1String("SQLITE")))
+		m_schemaName = cli->eventName();
+	m_profile = cli->profile();
+	m_stageId = cli->stage();
+	QString where;
+	if(cli->classesLike_isset())
+		where += "name LIKE '" + cli->classesLike() + "'";
+	if(cli->classesNotLike_isset()) {
+		if(!where.isEmpty())
+			where += " AND ";
+		where += "name NOT LIKE '" + cli->classesNotLike() + "'";
+	}
+	if(cli->classesIn_isset()) {
+		if(!where.isEmpty())
+			where += " AND ";
+		where += "name IN " + cli->classesIn();
+	}
+	m_classesWhere = where;
+}
+
+CategoryLoader::~CategoryLoader()
+{
+	stop();
+}
+
+void CategoryLoader::stop()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_stopRequested = true;
+		m_loadedNotFull.wakeAll();
+	}
+	wait();
+}
+
+bool CategoryLoader::takeCategory(Rows &rows)
+{
+	QMutexLocker locker(&m_mutex);
+	if(m_loaded.isEmpty())
+		return false;
+	rows = m_loaded.dequeue();
+	m_loadedNotFull.wakeOne();
+	return true;
+}
+
+int CategoryLoader::loadedCategoryCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_loaded.count();
+}
+
+bool CategoryLoader::openConnection()
+{
+	if(!QSqlDatabase::contains(m_connectionName)) {
+		QSqlDatabase db = QSqlDatabase::addDatabase(m_driverName, m_connectionName);
+		db.setHostName(m_hostName);
+		db.setPort(m_port);
+		db.setDatabaseName(m_databaseName);
+		db.setUserName(m_userName);
+		db.setPassword(m_password);
+		db.setConnectOptions(m_connectOptions);
+	}
+	qf::core::sql::Connection conn = qf::core::sql::Connection::forName(m_connectionName);
+	if(!conn.open()) {
+		qfError() << "Category loader cannot open SQL connection:" << conn.errorString();
+		return false;
+	}
+	if(!m_schemaName.isEmpty()) {
+		if(!conn.setCurrentSchema(m_schemaName)) {
+			qfError() << "Category loader cannot open event:" << m_schemaName;
+			return false;
+		}
+	}
+	return true;
+}
+
+void CategoryLoader::run()
+{
+	/// screen would stay empty forever without connection, open is retried until thread is stopped
+	bool is_open = false;
+	while(true) {
+		is_open = openConnection();
+		if(is_open)
+			break;
+		QMutexLocker locker(&m_mutex);
+		if(!m_stopRequested)
+			m_loadedNotFull.wait(&m_mutex, CONNECT_RETRY_MSEC);
+		if(m_stopRequested)
+			break;
+	}
+	QStringList categories_to_proceed;
+	while(is_open) {
+		{
+			QMutexLocker locker(&m_mutex);
+			while(m_loaded.count() >= m_maxLoadedCategoryCount && !m_stopRequested)
+				m_loadedNotFull.wait(&m_mutex);
+			if(m_stopRequested)
+				break;
+		}
+		if(categories_to_proceed.isEmpty())
+			categories_to_proceed = loadCategoryIds();
+		if(categories_to_proceed.isEmpty()) {
+			qfError() << "Categories load ERROR";
+			/// do not spin when there is nothing to show
+			QMutexLocker locker(&m_mutex);
+			if(!m_stopRequested)
+				m_loadedNotFull.wait(&m_mutex, 5000);
+			continue;
+		}
+		Rows rows;
+		if(!loadCategory(categories_to_proceed.takeFirst().toInt(), rows))
+			continue;
+		{
+			QMutexLocker locker(&m_mutex);
+			m_loaded.enqueue(rows);
+		}
+		emit categoryLoaded();
+	}
+	{
+		qf::core::sql::Connection conn = qf::core::sql::Connection::forName(m_connectionName);
+		conn.close();
+	}
+	QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+QStringList CategoryLoader::loadCategoryIds()
+{
+	QStringList ret;
+	QString qs = "SELECT id FROM classes";
+	if(!m_classesWhere.isEmpty())
+		qs += " WHERE " + m_classesWhere;
+	qs += " ORDER BY name";
+	if(m_firstRun)
+		qfInfo() << "loading clases:" << qs;
+	qf::core::sql::Query q(qf::core::sql::Connection::forName(m_connectionName));
+	if(!q.exec(qs)) {
+		qfError() << "SQL ERROR:" << q.lastErrorText();
+		return ret;
+	}
+	while(q.next())
+		ret << q.value(0).toString();
+	return ret;
+}
+
+bool CategoryLoader::loadCategory(int class_id, Rows &rows)
+{
+	qf::core::sql::Query q(qf::core::sql::Connection::forName(m_connectionName));
+	{
+		qf::core::sql::QueryBuilder qb;
+		qb.select2("classes", "name")
+				//.select2("classdefs", "")
+				.select2("courses", "length, climb")
+				.from("classes")
+				.joinRestricted("classes.id", "classdefs.classId", "classdefs.stageId={{stage_id}}")
+				.join("classdefs.courseId", "courses.id")
+				.where("classes.id={{class_id}}");
+		QString qs = qb.toString();
+		qs.replace("{{stage_id}}", QString::number(m_stageId));
+		qs.replace("{{class_id}}", QString::number(class_id));
+		if(m_firstRun)
+			qfInfo() << "classes:" << qs;
+		if(!q.exec(qs)) {
+			qfError() << "SQL ERROR:" << q.lastErrorText();
+			return false;
+		}
+		if(q.next()) {
+			QVariantMap m;
+			QVariantMap category_map = q.values();
+			m["type"] = "classInfo";
+			m["record"] = category_map;
+			m["key"] = rowContentKey(category_map);
+			rows << m;
+		}
+		else {
+			qfError() << "Entry for classname" << class_id << "does not exist !!!";
+		}
+	}
+	{
+		QString qs;
+		qf::core::sql::QueryBuilder qb;
+		if(m_profile == QLatin1String("results")) {
+			qb.select2("competitors", "registration, lastName, firstName")
+					//.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
+					.select2("runs", "*")
+					.from("competitors")
+					.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId={{stage_id}} AND runs.isRunning AND runs.finishTimeMs>0", "JOIN")
+					.where("competitors.classId={{class_id}}")
+					.orderBy("runs.notCompeting, runs.disqualified, runs.timeMs");
+			qs = qb.toString();
+			if(m_firstRun)
+				qfInfo() << "results:" << qs;
+		}
+		else {
+			qb.select2("competitors", "registration, lastName, firstName")
+					//.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
+					.select2("runs", "*")
+					.from("competitors")
+					.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId={{stage_id}} AND runs.isRunning", "JOIN")
+					.where("competitors.classId={{class_id}}")
+					.orderBy("runs.startTimeMs");
+			qs = qb.toString();
+			if(m_firstRun)
+				qfInfo() << "startlist:" << qs;
+		}
+		qs.replace("{{stage_id}}", QString::number(m_stageId));
+		qs.replace("{{class_id}}", QString::number(class_id));
+		if(!q.exec(qs)) {
+			qfError() << "SQL ERROR:" << q.lastErrorText();
+			return false;
+		}
+		int pos = 0;
+		while(q.next()) {
+			QVariantMap m;
+			QVariantMap detail_map = q.values();
+			detail_map["pos"] = ++pos;
+			m["type"] = m_profile;
+			m["record"] = detail_map;
+			m["key"] = rowContentKey(detail_map);
+			/// pridej k detailu i kategorii, protoze na prvnim miste listu se zobrazuje vzdy zahlavi aktualni kategorie kvuli prehlednosti
+			//m["category"] = category_map;
+			rows << m;
+		}
+	}
+	m_firstRun = false;
+	return true;
+}
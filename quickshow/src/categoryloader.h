@@ -0,0 +1,66 @@
+#ifndef CATEGORYLOADER_H
+#define CATEGORYLOADER_H
+
+#include <QMutex>
+#include <QQueue>
+#include <QStringList>
+#include <QThread>
+#include <QVariantMap>
+#include <QVector>
+#include <QWaitCondition>
+
+/// Loads categories (class info row followed by runner rows) in worker thread with its own SQL connection,
+/// so the paint handler never waits for SQL.
+/// Categories are loaded round robin, class list is reloaded when all of them are loaded,
+/// so every round reflects current database content.
+/// Loaded categories queue is bounded, worker sleeps when it is full.
+/// Every row has content key in "key" field, rows with the same key look the same.
+class CategoryLoader : public QThread
+{
+	Q_OBJECT
+	using Super = QThread;
+public:
+	using Rows = QVector<QVariantMap>;
+	static constexpr int DEFAULT_MAX_LOADED_CATEGORY_COUNT = 4;
+
+	/// worker opens its own connection with parameters of default SQL connection
+	explicit CategoryLoader(QObject *parent = nullptr);
+	~CategoryLoader() override;
+
+	void stop();
+
+	/// takes next loaded category if any, it never blocks on SQL
+	bool takeCategory(Rows &rows);
+	int loadedCategoryCount() const;
+
+	Q_SIGNAL void categoryLoaded();
+protected:
+	void run() override;
+private:
+	bool openConnection();
+	QStringList loadCategoryIds();
+	bool loadCategory(int class_id, Rows &rows);
+private:
+	static constexpr unsigned long CONNECT_RETRY_MSEC = 5000;
+	QString m_connectionName;
+	QString m_driverName;
+	QString m_hostName;
+	int m_port = -1;
+	QString m_databaseName;
+	QString m_userName;
+	QString m_password;
+	QString m_connectOptions;
+	QString m_schemaName;
+	QString m_classesWhere;
+	QString m_profile;
+	int m_stageId = 0;
+	bool m_firstRun = true;
+
+	mutable QMutex m_mutex;
+	QWaitCondition m_loadedNotFull;
+	QQueue<Rows> m_loaded;
+	int m_maxLoadedCategoryCount = DEFAULT_MAX_LOADED_CATEGORY_COUNT;
+	bool m_stopRequested = false;
+};
+
+#endif // CATEGORYLOADER_H
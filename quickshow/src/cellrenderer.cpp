@@ -26,6 +26,13 @@ CellRenderer::CellRenderer(const QSize &size, QWidget *widget)
 	m_cellSpacing = m_scaledLetterWidth / 2;
 }
 
+void CellRenderer::draw(const QPoint &position, const QVariantMap &data, QWidget *widget)
+{
+	QPainter painter(widget);
+	painter.translate(position);
+	drawCell(&painter, data);
+}
+
 //=========================================================
 // ClassCellRenderer
 //=========================================================
@@ -37,15 +44,15 @@ ClassCellRenderer::ClassCellRenderer(const QSize &size, QWidget *widget)
 	m_cellAttributes[Info] = CellAttribute{2 * size.width() / 3 - 2 * m_cellSpacing, Qt::AlignRight};
 }
 
-void ClassCellRenderer::draw(const QPoint &position, const QVariantMap &data, QWidget *widget)
+void ClassCellRenderer::drawCell(QPainter *p, const QVariantMap &data)
 {
 	QVariantMap record = data.value(QStringLiteral("record")).toMap();
-	QPainter painter(widget);
+	QPainter &painter = *p;
+	painter.save();
 	//painter.fillRect(r.adjusted(2, 2, -2, -2), Qt::yellow);
 	QPen pen(Qt::SolidLine);
 	pen.setColor(Qt::red);
 	painter.setPen(pen);
-	painter.translate(position);
 	QRect r(QPoint(0, 0), m_size);
 	//qfDebug() << r;
 	painter.fillRect(r.adjusted(1, 1, -1, -1), QColor("gold"));
@@ -67,6 +74,7 @@ void ClassCellRenderer::draw(const QPoint &position, const QVariantMap &data, QW
 		x += m_cellAttributes[i].width;
 		painter.restore();
 	}
+	painter.restore();
 }
 
 QString ClassCellRenderer::columnText(ClassCellRenderer::Column col, const QVariantMap &data)
@@ -91,16 +99,16 @@ RunnersListCellRenderer::RunnersListCellRenderer(const QSize &size, QWidget *wid
 {
 }
 
-void RunnersListCellRenderer::draw(const QPoint &position, const QVariantMap &data, QWidget *widget)
+void RunnersListCellRenderer::drawCell(QPainter *p, const QVariantMap &data)
 {
 	QVariantMap record = data.value(QStringLiteral("record")).toMap();
 	//qfInfo() << record;
-	QPainter painter(widget);
+	QPainter &painter = *p;
+	painter.save();
 	//painter.fillRect(r.adjusted(2, 2, -2, -2), Qt::yellow);
 	QPen pen(Qt::SolidLine);
 	pen.setColor(Qt::red);
 	painter.setPen(pen);
-	painter.translate(position);
 	QRect r(QPoint(0, 0), m_size);
 
 	painter.fillRect(r, QColor(Qt::gray));
@@ -125,6 +133,7 @@ void RunnersListCellRenderer::draw(const QPoint &position, const QVariantMap &da
 		x += m_cellAttributes[i].width;
 		painter.restore();
 	}
+	painter.restore();
 }
 
 //=========================================================
@@ -14,8 +14,11 @@ class CellRenderer
 {
 public:
 	CellRenderer(const QSize &size, QWidget *widget);
+	virtual ~CellRenderer() {}
 
-	virtual void draw(const QPoint &position, const QVariantMap &data, QWidget *widget) = 0;
+	void draw(const QPoint &position, const QVariantMap &data, QWidget *widget);
+	/// draws cell with top left corner in painter origin, it can be used to render cell to pixmap
+	virtual void drawCell(QPainter *painter, const QVariantMap &data) = 0;
 protected:
 	const QSize m_size;
 	int m_cellSpacing;
@@ -41,7 +44,7 @@ private:
 public:
 	ClassCellRenderer(const QSize &size, QWidget *widget);
 
-	void draw(const QPoint &position, const QVariantMap &data, QWidget *widget) Q_DECL_OVERRIDE;
+	void drawCell(QPainter *painter, const QVariantMap &data) Q_DECL_OVERRIDE;
 protected:
 	enum Column {Name = 0, Info, ColumnCount};
 	QString columnText(Column col, const QVariantMap &data);
@@ -56,7 +59,7 @@ private:
 public:
 	RunnersListCellRenderer(const QSize &size, QWidget *widget);
 
-	void draw(const QPoint &position, const QVariantMap &data, QWidget *widget) Q_DECL_OVERRIDE;
+	void drawCell(QPainter *painter, const QVariantMap &data) Q_DECL_OVERRIDE;
 protected:
 	virtual int columnCount() = 0;
 	virtual QString columnText(int col, const QVariantMap &data) = 0;
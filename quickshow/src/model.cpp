@@ -1,158 +1,67 @@
 #include "model.h"
 #include "application.h"
-#include "appclioptions.h"
+#include "categoryloader.h"
 
-#include <qf/core/utils.h>
-#include <qf/core/sql/query.h>
-#include <qf/core/sql/querybuilder.h>
-#include <qf/core/log.h>
-
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlRecord>
-#include <QStringBuilder>
+#include <qf/core/sql/connection.h>
 
 Model::Model(QObject *parent) :
 	QObject(parent)
+	, m_storage(1024)
 {
 	m_shiftOffset = -1;
+	/// loader clones default connection, it must be open
+	Application::instance()->sqlConnetion();
+	m_categoryLoader = new CategoryLoader(this);
+	connect(m_categoryLoader, &CategoryLoader::categoryLoaded, this, &Model::fillStorage, Qt::QueuedConnection);
+	m_categoryLoader->start();
+}
+
+Model::~Model()
+{
+	m_categoryLoader->stop();
 }
 
 void Model::shift()
 {
+	fillStorage();
+	/// do not scroll to rows which are not loaded yet, they would be skipped when they come
+	if(m_shiftOffset + 1 > m_storage.lastIndex())
+		return;
 	m_shiftOffset++;
+	/// rows scrolled out are not needed any more
+	while(!m_storage.isEmpty() && m_storage.firstIndex() < m_shiftOffset)
+		m_storage.removeFirst();
 	//qDebug() << "shift offset:" << f_shiftOffset;
 }
 
 QVariantMap Model::data(int index)
 {
-	QVariantMap ret;
 	if(m_shiftOffset < 0)
-		return ret;
-	while((m_shiftOffset + index) >= m_storage.count()) {
-		if(!addCategoryToStorage()) break;
-	}
+		return QVariantMap();
+	if(index > m_maxRequestedIndex)
+		m_maxRequestedIndex = index;
 	int ix = m_shiftOffset + index;
-	if(ix < m_storage.count()) {
-		ret = m_storage[ix].toMap();
-	}
-	return ret;
+	if(m_storage.containsIndex(ix))
+		return m_storage.at(ix);
+	return QVariantMap();
 }
 
-void Model::reloadCategories()
+void Model::fillStorage()
 {
-	m_categoriesToProceed.clear();
-	Application *app = Application::instance();
-	AppCliOptions *cli = app->cliOptions();
-	QString where;
-	if(cli->classesLike_isset())
-		where += "name LIKE '" + cli->classesLike() + "'";
-	if(cli->classesNotLike_isset()) {
-		if(!where.isEmpty())
-			where += " AND ";
-		where += "name NOT LIKE '" + cli->classesNotLike() + "'";
-	}
-	if(cli->classesIn_isset()) {
-		if(!where.isEmpty())
-			where += " AND ";
-		where += "name IN " + cli->classesIn();
-	}
-	QString qs = "SELECT id FROM classes";
-	if(!where.isEmpty())
-		qs += " WHERE " + where;
-	qs += " ORDER BY name";
-	qfInfo() << "loading clases:" << qs;
-	QSqlQuery q = app->execSql(qs);
-	while(q.next()) {
-		m_categoriesToProceed << q.value(0).toString();
+	QVector<QVariantMap> rows;
+	while(m_storage.lastIndex() - qMax(m_shiftOffset, 0) < m_maxRequestedIndex + PREFETCH_ROW_COUNT) {
+		if(!m_categoryLoader->takeCategory(rows))
+			break;
+		appendCategory(rows);
 	}
 }
 
-bool Model::addCategoryToStorage()
+void Model::appendCategory(const QVector<QVariantMap> &rows)
 {
-	static bool first_run = true;
-	m_storage = m_storage.mid(m_shiftOffset);
-	m_shiftOffset = 0;
-
-	if(m_categoriesToProceed.isEmpty())
-		reloadCategories();
-	if(m_categoriesToProceed.isEmpty()) {
-		qfError() << "Categories load ERROR";
-		return false;
-	}
-	Application *app = Application::instance();
-	int cat_id_to_load = m_categoriesToProceed.takeFirst().toInt();
-	QVariantMap category_map;
-	{
-		qf::core::sql::QueryBuilder qb;
-		qb.select2("classes", "name")
-				//.select2("classdefs", "")
-				.select2("courses", "length, climb")
-				.from("classes")
-				.joinRestricted("classes.id", "classdefs.classId", "classdefs.stageId={{stage_id}}")
-				.join("classdefs.courseId", "courses.id")
-				.where("classes.id={{class_id}}");
-		QString qs = qb.toString();
-		qs.replace("{{stage_id}}", QString::number(app->cliOptions()->stage()));
-		qs.replace("{{class_id}}", QString::number(cat_id_to_load));
-		if(first_run)
-			qfInfo() << "classes:" << qs;
-		qf::core::sql::Query q = app->execSql(qs);
-		if(q.next()) {
-			QVariantMap m;
-			category_map = q.values();
-			m["type"] = "classInfo";
-			m["record"] = category_map;
-			m_storage << m;
-		}
-		else {
-			qfError() << "Entry for classname" << cat_id_to_load << "does not exist !!!";
-		}
-	}
-	{
-		QString qs;
-		qf::core::sql::QueryBuilder qb;
-		if(app->cliOptions()->profile() == QLatin1String("results")) {
-			qb.select2("competitors", "registration, lastName, firstName")
-					//.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
-					.select2("runs", "*")
-					.from("competitors")
-					.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId={{stage_id}} AND runs.isRunning AND runs.finishTimeMs>0", "JOIN")
-					.where("competitors.classId={{class_id}}")
-					.orderBy("runs.notCompeting, runs.disqualified, runs.timeMs");
-			qs = qb.toString();
-			if(first_run)
-				qfInfo() << "results:" << qs;
-		}
-		else {
-			qb.select2("competitors", "registration, lastName, firstName")
-					//.select("COALESCE(competitors.lastName, '') || ' ' || COALESCE(competitors.firstName, '') AS competitorName")
-					.select2("runs", "*")
-					.from("competitors")
-					.joinRestricted("competitors.id", "runs.competitorId", "runs.stageId={{stage_id}} AND runs.isRunning", "JOIN")
-					.where("competitors.classId={{class_id}}")
-					.orderBy("runs.startTimeMs");
-			qs = qb.toString();
-			if(first_run)
-				qfInfo() << "startlist:" << qs;
-		}
-		qs.replace("{{stage_id}}", QString::number(app->cliOptions()->stage()));
-		qs.replace("{{class_id}}", QString::number(cat_id_to_load));
-		qf::core::sql::Query q = app->execSql(qs);
-		int pos = 0;
-		while(q.next()) {
-			QVariantMap m;
-			//QVariantMap detail_map = app->sqlRecordToMap(rec);
-			QVariantMap detail_map = q.values();
-			detail_map["pos"] = ++pos;
-			m["type"] = app->cliOptions()->profile();
-			m["record"] = detail_map;
-			/// pridej k detailu i kategorii, protoze na prvnim miste listu se zobrazuje vzdy zahlavi aktualni kategorie kvuli prehlednosti
-			//m["category"] = category_map;
-			m_storage << m;
-		}
-	}
-	first_run = false;
-	return true;
+	/// ring buffer drops rows from start when it is full, they might be still visible
+	int needed = m_storage.count() + rows.count();
+	if(needed > m_storage.capacity())
+		m_storage.setCapacity(qMax(needed, 2 * m_storage.capacity()));
+	for(const QVariantMap &row : rows)
+		m_storage.append(row);
 }
-
@@ -1,27 +1,37 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <QContiguousCache>
 #include <QObject>
-#include <QVariantList>
-#include <QStringList>
+#include <QVariantMap>
 
+class CategoryLoader;
+
+/// Rows to show are kept in ring buffer, categories are appended to it by CategoryLoader from worker thread,
+/// so data() called from paint handler never touches SQL.
+/// Row indexes in ring buffer are absolute, shift() moves visible window forward by one row.
 class Model : public QObject
 {
 	Q_OBJECT
 public:
+	/// rows prefetched after the last row requested by data()
+	static constexpr int PREFETCH_ROW_COUNT = 100;
+
 	explicit Model(QObject *parent = nullptr);
+	~Model() override;
 public slots:
 	void shift();
 	QVariantMap data(int index);
 protected:
-	//void reset();
-	void reloadCategories();
-	bool addCategoryToStorage();
+	/// move loaded categories to storage as long as it needs more rows
+	void fillStorage();
+	void appendCategory(const QVector<QVariantMap> &rows);
 protected:
-	QVariantList m_storage;
-	QVariantList m_categoriesToProceed;
-	QVariantMap m_queryPlaceholders;
+	QContiguousCache<QVariantMap> m_storage;
+	/// absolute index of the first visible row
 	int m_shiftOffset;
+	int m_maxRequestedIndex = 0;
+	CategoryLoader *m_categoryLoader = nullptr;
 };
 
 #endif // MODEL_H
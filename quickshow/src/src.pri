@@ -6,6 +6,7 @@ HEADERS  +=   \
 	$$PWD/application.h      \
     $$PWD/appclioptions.h \
     $$PWD/model.h \
+    $$PWD/categoryloader.h \
     $$PWD/table.h \
     $$PWD/cellrenderer.h
 
@@ -15,6 +16,7 @@ SOURCES +=   \
 	$$PWD/application.cpp      \
     $$PWD/appclioptions.cpp \
     $$PWD/model.cpp \
+    $$PWD/categoryloader.cpp \
     $$PWD/table.cpp \
     $$PWD/cellrenderer.cpp
 
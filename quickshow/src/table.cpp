@@ -6,6 +6,8 @@
 
 #include <qf/core/log.h>
 
+#include <QElapsedTimer>
+#include <QPainter>
 #include <QTimer>
 
 Table::Table(QWidget *parent)
@@ -27,6 +29,10 @@ Table::Table(QWidget *parent)
 	});
 }
 
+Table::~Table()
+{
+}
+
 void Table::resetCellSize()
 {
 	m_cellSize = QSize();
@@ -35,31 +41,94 @@ void Table::resetCellSize()
 
 void Table::paintEvent(QPaintEvent *event)
 {
+	QElapsedTimer frame_timer;
+	frame_timer.start();
 	Super::paintEvent(event);
 	if(m_rowCount == 0)
 		return;
-	Application *app = Application::instance();
-	ClassCellRenderer cr(m_cellSize, this);
-	StartListCellRenderer rr_startlist(m_cellSize, this);
-	ResultsCellRenderer rr_results(m_cellSize, this);
-	RunnersListCellRenderer *rr;
-	if(app->cliOptions()->profile() == QLatin1String("results"))
-		rr = &rr_results;
-	else
-		rr = &rr_startlist;
+	/// rows shifted by one position are blitted from cache, only the new row is rendered
+	QPainter painter(this);
 	int ix = 0;
 	for (int j = 0; j < m_columnCount; ++j) {
 		for (int i = 0; i < m_rowCount; ++i) {
 			QPoint pos(j * m_cellSize.width(), i * m_cellSize.height());
 			QVariantMap data = model()->data(ix);
-			QString data_type = data.value(QStringLiteral("type")).toString();
-			if(data_type == QLatin1String("classInfo"))
-				cr.draw(pos, data, this);
-			else
-				rr->draw(pos, data, this);
+			painter.drawPixmap(pos, rowPixmap(data));
 			ix++;
 		}
 	}
+	updateFrameStats(static_cast<int>(frame_timer.nsecsElapsed() / 1000));
+}
+
+QPixmap Table::rowPixmap(const QVariantMap &data)
+{
+	/// window moved to screen with different device pixel ratio, cached pixmaps and cache budget are stale
+	if(!qFuzzyCompare(devicePixelRatioF(), m_rowPixmapDpr))
+		clearRowPixmapCache();
+	QString data_type = data.value(QStringLiteral("type")).toString();
+	bool is_class_info = (data_type == QLatin1String("classInfo"));
+	QString key = m_rowPixmapKeyPrefix + (is_class_info? 'C': 'R') + data.value(QStringLiteral("key")).toString();
+	if(QPixmap *pm = m_rowPixmapCache.object(key)) {
+		m_rowPixmapCacheHits++;
+		return *pm;
+	}
+	m_rowPixmapCacheMisses++;
+	if(m_classRenderer.isNull()) {
+		m_classRenderer.reset(new ClassCellRenderer(m_cellSize, this));
+		Application *app = Application::instance();
+		if(app->cliOptions()->profile() == QLatin1String("results"))
+			m_runnersRenderer.reset(new ResultsCellRenderer(m_cellSize, this));
+		else
+			m_runnersRenderer.reset(new StartListCellRenderer(m_cellSize, this));
+	}
+	CellRenderer *renderer = is_class_info? m_classRenderer.data(): m_runnersRenderer.data();
+	qreal dpr = devicePixelRatioF();
+	QPixmap *pm = new QPixmap(m_cellSize * dpr);
+	pm->setDevicePixelRatio(dpr);
+	/// cell borders are not painted, widget background is seen there
+	pm->fill(Qt::transparent);
+	{
+		QPainter painter(pm);
+		painter.setFont(font());
+		renderer->drawCell(&painter, data);
+	}
+	QPixmap ret = *pm;
+	int cost = qMax(1, pm->width() * pm->height() * pm->depth() / 8 / 1024);
+	m_rowPixmapCache.insert(key, pm, cost);
+	return ret;
+}
+
+void Table::clearRowPixmapCache()
+{
+	m_rowPixmapCache.clear();
+	m_classRenderer.reset();
+	m_runnersRenderer.reset();
+	m_rowPixmapKeyPrefix = QString::number(m_cellSize.width()) + 'x' + QString::number(m_cellSize.height()) + ':';
+	/// keep about three screens of rows, one visible, one scrolled out and one coming
+	/// cost is counted in device pixels the same way as in rowPixmap()
+	m_rowPixmapDpr = devicePixelRatioF();
+	QSize pixmap_size = m_cellSize * m_rowPixmapDpr;
+	int cell_cost = qMax(1, pixmap_size.width() * pixmap_size.height() * 4 / 1024);
+	m_rowPixmapCache.setMaxCost(qMax(1024, 3 * m_rowCount * m_columnCount * cell_cost));
+}
+
+void Table::updateFrameStats(int frame_time_us)
+{
+	m_lastFrameTimeUs = frame_time_us;
+	m_maxFrameTimeUs = qMax(m_maxFrameTimeUs, frame_time_us);
+	m_frameTimeSumUs += frame_time_us;
+	m_frameCount++;
+	if(m_frameCount >= FRAME_STATS_INTERVAL) {
+		qfInfo() << "frames:" << m_frameCount
+				 << "avg:" << (m_frameTimeSumUs / m_frameCount) << "us"
+				 << "max:" << m_maxFrameTimeUs << "us"
+				 << "row cache hits:" << m_rowPixmapCacheHits << "misses:" << m_rowPixmapCacheMisses;
+		m_frameCount = 0;
+		m_frameTimeSumUs = 0;
+		m_maxFrameTimeUs = 0;
+		m_rowPixmapCacheHits = 0;
+		m_rowPixmapCacheMisses = 0;
+	}
 }
 
 void Table::resizeEvent(QResizeEvent *event)
@@ -84,6 +153,7 @@ void Table::updateRowCount()
 	m_cellSize.setHeight(m_cellSize.height() + rest / m_rowCount);
 	m_cellSize.setWidth(frame_size.width() / m_columnCount);
 	qfDebug() << "new row count:" << m_rowCount << "cell size:" << m_cellSize;
+	clearRowPixmapCache();
 	update();
 }
 
@@ -1,9 +1,13 @@
 #ifndef TABLE_H
 #define TABLE_H
 
+#include <QCache>
 #include <QFrame>
+#include <QPixmap>
+#include <QScopedPointer>
 
 class Model;
+class CellRenderer;
 
 class Table : public QFrame
 {
@@ -12,21 +16,46 @@ private:
 	using Super = QFrame;
 public:
 	Table(QWidget *parent);
+	~Table() Q_DECL_OVERRIDE;
 
 	void resetCellSize();
+
+	/// paint time statistics, they are logged every FRAME_STATS_INTERVAL frames
+	int lastFrameTimeUs() const {return m_lastFrameTimeUs;}
+	int rowPixmapCacheHits() const {return m_rowPixmapCacheHits;}
+	int rowPixmapCacheMisses() const {return m_rowPixmapCacheMisses;}
 protected:
 	void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
 	void resizeEvent(QResizeEvent *event) Q_DECL_OVERRIDE;
 private:
 	void updateRowCount();
 	Model *model();
+	/// rendered cell of row, pixmaps are cached by row content key and cell size
+	QPixmap rowPixmap(const QVariantMap &data);
+	void clearRowPixmapCache();
+	void updateFrameStats(int frame_time_us);
 private:
+	static constexpr int FRAME_STATS_INTERVAL = 100;
 	QTimer *m_updateRowCountTimer = nullptr;
 	int m_rowCount = 0;
 	int m_columnCount = 2;
 	QSize m_cellSize;
 	Model *m_model = nullptr;
 	QTimer *m_scrollTimer = nullptr;
+
+	QScopedPointer<CellRenderer> m_classRenderer;
+	QScopedPointer<CellRenderer> m_runnersRenderer;
+	/// cost is pixmap size in KiB
+	QCache<QString, QPixmap> m_rowPixmapCache;
+	QString m_rowPixmapKeyPrefix;
+	qreal m_rowPixmapDpr = 1;
+
+	int m_lastFrameTimeUs = 0;
+	int m_maxFrameTimeUs = 0;
+	qint64 m_frameTimeSumUs = 0;
+	int m_frameCount = 0;
+	int m_rowPixmapCacheHits = 0;
+	int m_rowPixmapCacheMisses = 0;
 };
 
 #endif // TABLE_H